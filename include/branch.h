@@ -0,0 +1,70 @@
+/**
+ * @file branch.h
+ * @brief Embranchement d'une simulation
+ *
+ * Pour comparer plusieurs variantes d'un modèle (la valeur d'un
+ * paramètre modifiée à une date donnée par exemple), il n'est pas
+ * nécessaire de simuler plusieurs fois l'historique commun. Le
+ * processus est dupliqué (par fork) à la date courante : chaque fils
+ * partage, en copie sur écriture, toute la mémoire du père, modifie le
+ * modèle puis poursuit la simulation, sur son propre processeur. Seul
+ * un résumé des sondes choisies est renvoyé au père, par un tube.
+ *
+ * Les fils partent tous du même état, y compris celui des générateurs
+ * aléatoires : les variantes sont donc comparées avec les mêmes
+ * nombres aléatoires, tant que la modification ne décale pas leur
+ * utilisation.
+ */
+#ifndef __DEF_BRANCH
+#define __DEF_BRANCH
+
+#include <motsim.h>
+#include <probe.h>
+
+/**
+ * @brief Le résumé d'une sonde à la fin d'une branche
+ */
+struct motSimBranchResult_t {
+   unsigned long nbSamples;
+   double        mean;
+   double        min;
+   double        max;
+   double        variance; // Sondes exhaustives seulement, 0 sinon
+};
+
+/**
+ * @brief La fonction de modification d'une branche
+ * @param n le numéro de la branche (de 0 à nbBranches - 1)
+ * @param data le pointeur fourni à motSim_branch
+ *
+ * Elle est invoquée dans le processus fils, à la date de
+ * l'embranchement, dans le contexte courant. Elle ne doit pas créer de
+ * nouveau contexte ni de thread.
+ */
+typedef void (*motSimBranchChange_t)(int n, void * data);
+
+/**
+ * @brief Exécution de plusieurs variantes de la simulation courante
+ * @param nbBranches le nombre de branches (de processus fils)
+ * @param date la date (simulée) de fin de chaque branche
+ * @param change la fonction de modification (ou NULL)
+ * @param data un pointeur passé à change
+ * @param nbProbes le nombre de sondes à résumer
+ * @param probes les sondes à résumer
+ * @param results les résumés, results[n*nbProbes + m] pour la sonde m
+ * de la branche n
+ * @return le nombre de branches qui ont échoué (leurs résumés sont
+ * alors à 0), -1 si l'embranchement est impossible
+ *
+ * La fonction rend la main lorsque toutes les branches sont
+ * terminées. L'état du contexte courant n'est pas modifié, la
+ * simulation peut donc y être poursuivie sans modification.
+ *
+ * Elle ne peut être invoquée ni depuis un événement, ni dans un LP.
+ */
+int motSim_branch(int nbBranches, motSimDate_t date,
+		  motSimBranchChange_t change, void * data,
+		  int nbProbes, struct probe_t ** probes,
+		  struct motSimBranchResult_t * results);
+
+#endif
@@ -0,0 +1,147 @@
+/**
+ * @file campaign.h
+ * @brief Les campagnes de simulation
+ *
+ * Une campagne exécute plusieurs réplications indépendantes d'une
+ * même simulation, par exemple pour établir des intervalles de
+ * confiance. Chaque réplication est construite par une fonction
+ * fournie par l'utilisateur, dans son propre contexte de simulation
+ * (cf motsim-context.h) et avec sa propre graine (cf motSim_setSeed).
+ *
+ * Les réplications sont réparties entre plusieurs threads. Chaque
+ * thread a sa propre liste de réplications à exécuter, et vient en
+ * prendre dans celle des autres lorsqu'il a épuisé la sienne.
+ *
+ * Les résultats sont regroupés dans des sondes de campagne, créées
+ * dans le contexte de l'appelant. Pour chaque mesure, on peut
+ * obtenir
+ *  - une sonde recevant un échantillon par réplication : la moyenne
+ * de la sonde correspondante dans la réplication. Si elle est
+ * exhaustive, on en tire moyenne, variance et intervalle de confiance ;
+ *  - une sonde dans laquelle sont fusionnés tous les échantillons de
+ * toutes les réplications (cf probe_merge), par exemple un
+ * histogramme.
+ *
+ * Les fusions sont faites dans l'ordre des réplications, le résultat
+ * ne dépend donc pas du nombre de threads.
+ */
+#ifndef __DEF_CAMPAIGN
+#define __DEF_CAMPAIGN
+
+#include <motsim.h>
+#include <probe.h>
+
+struct motSimCampaign_t;
+
+/**
+ * @brief La fonction de construction d'une réplication
+ * @param c la campagne
+ * @param n le numéro de la réplication (de 0 à nbSimulations - 1)
+ * @param data le pointeur fourni à la création de la campagne
+ *
+ * Elle est invoquée dans le contexte (déjà créé) de la réplication,
+ * depuis un thread quelconque. Elle ne doit donc rien modifier qui
+ * soit partagé avec les autres réplications.
+ */
+typedef void (*motSimBuild_t)(struct motSimCampaign_t * c, int n, void * data);
+
+/**
+ * @brief Création d'une campagne
+ * @param nbSimulations le nombre de réplications
+ * @param duree la durée (simulée) de chaque réplication
+ * @param build la fonction de construction d'une réplication
+ * @param data un pointeur passé à build
+ */
+struct motSimCampaign_t * motSim_campaignCreate(int nbSimulations,
+						motSimDate_t duree,
+						motSimBuild_t build,
+						void * data);
+
+/**
+ * @brief Choix du nombre de threads (par défaut, le nombre de
+ * processeurs)
+ */
+void motSim_campaignSetNbThreads(struct motSimCampaign_t * c, int nbThreads);
+
+/**
+ * @brief Choix de la graine de la campagne
+ *
+ * La réplication n utilise la graine seed + n. Par défaut, seed vaut 0.
+ */
+void motSim_campaignSetSeed(struct motSimCampaign_t * c, unsigned long long seed);
+
+/**
+ * @brief Réplications par paires antithétiques
+ *
+ * Si antithetic est non nul, les réplications 2k et 2k+1 utilisent
+ * la même graine seed + k, la seconde avec des variables
+ * antithétiques (cf motSim_setAntithetic). Chaque sonde des moyennes
+ * reçoit alors un échantillon par paire, la moyenne des deux
+ * réplications : ces échantillons sont indépendants, l'intervalle de
+ * confiance qu'on en tire reste donc valide, et il est plus étroit
+ * lorsque les deux réplications d'une paire sont négativement
+ * corrélées. Le nombre de réplications devrait être pair. Une paire
+ * dont l'une des réplications est instable est ignorée.
+ *
+ * Pour comparer deux configurations d'un modèle, on utilisera plutôt
+ * la même graine pour les deux campagnes, et des flots nommés
+ * d'après leur rôle (cf randomGenerator_setStream).
+ */
+void motSim_campaignSetAntithetic(struct motSimCampaign_t * c, int antithetic);
+
+/**
+ * @brief Déclaration d'une mesure de la campagne
+ * @param c la campagne
+ * @param meanProbe une sonde (ou NULL) qui recevra la moyenne de la
+ * mesure dans chaque réplication
+ * @param mergedProbe une sonde (ou NULL) dans laquelle seront
+ * fusionnés les échantillons de toutes les réplications
+ * @return le numéro de la mesure, à fournir à motSim_campaignSetProbe
+ *
+ * Les deux sondes sont rendues persistantes.
+ */
+int motSim_campaignAddProbe(struct motSimCampaign_t * c,
+			    struct probe_t * meanProbe,
+			    struct probe_t * mergedProbe);
+
+/**
+ * @brief Association d'une sonde d'une réplication à une mesure
+ * @param c la campagne
+ * @param n le numéro de la réplication
+ * @param m le numéro de la mesure
+ * @param probe la sonde de la réplication
+ *
+ * A invoquer depuis la fonction de construction.
+ */
+void motSim_campaignSetProbe(struct motSimCampaign_t * c, int n, int m,
+			     struct probe_t * probe);
+
+/**
+ * @brief Exécution de toutes les réplications d'une campagne
+ *
+ * La fonction rend la main lorsque toutes les réplications sont
+ * terminées et leurs résultats fusionnés dans les sondes de la
+ * campagne.
+ */
+void motSim_campaignRun(struct motSimCampaign_t * c);
+
+/**
+ * @brief Un petit affichage de l'exécution d'une campagne
+ */
+void motSim_campaignPrintStatus(struct motSimCampaign_t * c);
+
+/**
+ * @brief L'état final de la réplication n (cf motSim_getStatus)
+ *
+ * Les résultats d'une réplication arrêtée car instable
+ * (MOTSIM_STATUS_UNSTABLE, cf probe_setInstabilityDetector) ne sont
+ * pas fusionnés dans les sondes de la campagne.
+ */
+int motSim_campaignGetStatus(struct motSimCampaign_t * c, int n);
+
+/**
+ * @brief Nombre de réplications arrêtées car instables
+ */
+int motSim_campaignNbUnstable(struct motSimCampaign_t * c);
+
+#endif
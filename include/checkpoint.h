@@ -0,0 +1,139 @@
+/**
+ * @file checkpoint.h
+ * @brief Sauvegarde et restauration de l'état d'une simulation
+ *
+ * L'état du contexte courant (horloge, compteurs, événements en
+ * attente et état de chaque client enregistré) peut être écrit dans
+ * un fichier binaire puis relu par un autre exécution du même
+ * modèle, ce qui permet par exemple de partager une phase de
+ * chauffe entre plusieurs simulations.
+ *
+ * La restauration se fait dans un modèle déjà construit, de la même
+ * façon que lors de la sauvegarde : les objets ne sont pas recréés,
+ * seul leur état est remplacé. Les clients (sondes, générateurs, files,
+ * sources, serveurs, ...) sont identifiés par leur ordre
+ * d'enregistrement et les fonctions (celles des événements en
+ * particulier) par leur nom. Un fichier dont le format, la
+ * représentation des dates, le modèle (cf motSim_setModelVersion) ou
+ * la liste des clients et des fonctions diffère est refusé.
+ *
+ * Le paramètre data d'un événement en attente doit être NULL ou un
+ * client, ses arguments (cf event_setArg) des valeurs scalaires. Le
+ * champ privé d'une PDU est sauvegardé tel quel, il doit donc être
+ * NULL ou une valeur scalaire.
+ */
+#ifndef __DEF_CHECKPOINT
+#define __DEF_CHECKPOINT
+
+#include <stddef.h>    // size_t
+
+#include <motsim.h>
+
+/*
+ * Version du format des fichiers. A changer à chaque modification de
+ * ce qui est écrit par le moteur ou par l'un des modules.
+ */
+#define CHECKPOINT_FORMAT_VERSION 10
+
+struct checkpoint_t;
+struct motsim_t;
+struct PDU_t;
+
+/**
+ * @brief Sauvegarde de l'état du contexte courant
+ *
+ * Elle ne peut être invoquée qu'entre deux exécutions (pas depuis un
+ * événement) et pas dans un LP (cf pdes.h).
+ *
+ * @return 0 si tout va bien
+ */
+int motSim_checkpoint(const char * fileName);
+
+/**
+ * @brief Restauration de l'état du contexte courant
+ *
+ * Les événements en attente sont purgés et remplacés par ceux du
+ * fichier. Le fichier est entièrement vérifié (en-tête, taille de
+ * l'état de chaque client, événements, marque de fin) avant toute
+ * modification : s'il est refusé, l'état n'est pas modifié. Seul un
+ * client qui ne relit pas exactement ce qu'il a écrit est détecté en
+ * cours de restauration, le contexte est alors inutilisable et
+ * l'erreur fatale.
+ *
+ * @return 0 si tout va bien
+ */
+int motSim_restore(const char * fileName);
+
+/**
+ * @brief Nom et version du modèle, enregistrés dans les fichiers de
+ * sauvegarde et vérifiés à la restauration
+ */
+void motSim_setModelVersion(const char * name, int version);
+
+/**
+ * @brief Enregistrement d'un client
+ *
+ * Les objets dont l'état évolue au cours d'une simulation doivent
+ * s'enregistrer, dans le même ordre à chaque construction du
+ * modèle. Leur fonction save écrit leur état, la fonction restore le
+ * relit dans le même ordre.
+ *
+ * @param name le type du client, vérifié à la restauration
+ */
+void motSim_addToCheckpointList(void * data, const char * name,
+				void (*save)(struct checkpoint_t * cp, void * data),
+				void (*restore)(struct checkpoint_t * cp, void * data));
+
+/**
+ * @brief Enregistrement d'un bloc de données sauvegardé tel quel
+ * (qui ne doit donc pas contenir de pointeur)
+ */
+void motSim_addBlockToCheckpointList(void * data, const char * name, size_t size);
+
+/**
+ * @brief Enregistrement d'une fonction, sous son nom
+ *
+ * Les fonctions des événements en attente, et celles sauvegardées par
+ * checkpoint_writeFunction, doivent avoir été enregistrées.
+ */
+#define checkpoint_registerFunction(f) \
+   checkpoint_addFunction(#f, (void (*)())(f))
+
+void checkpoint_addFunction(const char * name, void (*function)());
+
+/*
+ * Les fonctions suivantes sont utilisées par les clients pour écrire
+ * ou lire leur état. Une erreur (fichier tronqué, pointeur inconnu,
+ * ...) est mémorisée et fait échouer la sauvegarde ou la
+ * restauration.
+ */
+void checkpoint_write(struct checkpoint_t * cp, const void * data, size_t size);
+void checkpoint_read(struct checkpoint_t * cp, void * data, size_t size);
+
+/**
+ * @brief Une PDU (éventuellement NULL), écrite une seule fois même si
+ * elle est référencée plusieurs fois
+ */
+void checkpoint_writePDU(struct checkpoint_t * cp, struct PDU_t * pdu);
+struct PDU_t * checkpoint_readPDU(struct checkpoint_t * cp);
+
+/**
+ * @brief Une référence vers un client (ou NULL)
+ */
+void checkpoint_writeObject(struct checkpoint_t * cp, void * data);
+void * checkpoint_readObject(struct checkpoint_t * cp);
+
+/**
+ * @brief Une fonction enregistrée (ou NULL)
+ */
+void checkpoint_writeFunction(struct checkpoint_t * cp, void (*function)());
+void (*checkpoint_readFunction(struct checkpoint_t * cp))();
+
+/**
+ * @brief Signalement d'un état qui ne peut être sauvegardé ou restauré
+ */
+void checkpoint_setError(struct checkpoint_t * cp);
+
+void checkpoint_free(struct motsim_t * ctx);   // cf motSim_destroyContext
+
+#endif
@@ -61,8 +61,11 @@ void dateGenerator_addInterArrivalProbe(struct dateGenerator_t * dateGen,
 /**
  * @brief Obtention de la prochaine date
  * @param dateGen le générateur à utiliser
+ *
+ * Les durées tirées (en secondes) sont converties avant d'être
+ * cumulées (cf motSim_secondsToDate).
  */
-double dateGenerator_nextDate(struct dateGenerator_t * dateGen);
+motSimDate_t dateGenerator_nextDate(struct dateGenerator_t * dateGen);
 
 /**
  * @brief Choix de la date de démarrage
@@ -75,6 +78,13 @@ double dateGenerator_nextDate(struct dateGenerator_t * dateGen);
 void dateGenerator_setStartDate(struct dateGenerator_t * dateGen,
 				motSimDate_t date);
 
+/*
+ * Retour à la date de démarrage (cf dateGenerator_setStartDate) : la
+ * prochaine date sera la première qui a été générée. Utilisé lors de
+ * la réinitialisation d'une source (cf motSim_reset).
+ */
+void dateGenerator_rewind(struct dateGenerator_t * dateGen);
+
 /*
  * Modification du paramètre lambda
  */
@@ -1,3 +1,12 @@
+/**
+ * @file event-file.h
+ * @brief Les files d'événements (échéanciers)
+ *
+ * Une file d'événements conserve des événements triés par date
+ * croissante. Les événements de même date sont extraits dans l'ordre
+ * de leur insertion, ce qui garantit la reproductibilité des
+ * simulations quelle que soit l'implantation choisie.
+ */
 #ifndef __DEF_EVENT_FILE
 #define __DEF_EVENT_FILE
 
@@ -5,18 +14,117 @@
 
 struct eventFile_t;
 
+/*
+ * Création d'une file avec l'implantation par défaut
+ * (eventFileDefaultType)
+ */
 struct eventFile_t * eventFile_create();
 
+/**
+ * @brief Création d'une file d'une implantation donnée
+ * @param type l'implantation choisie
+ * @return Une file vide
+ */
+struct eventFile_t * eventFile_createType(enum eventFileType_t type);
+
+/**
+ * @brief Libération d'une file
+ *
+ * Les événements qu'elle contient encore ne sont pas libérés.
+ */
+void eventFile_free(struct eventFile_t * file);
+
+/**
+ * @brief Implantation utilisée par une file
+ */
+enum eventFileType_t eventFile_getType(struct eventFile_t * file);
+
+/**
+ * @brief Nom (lisible) de l'implantation utilisée par une file
+ */
+char * eventFile_getTypeName(struct eventFile_t * file);
+
+/**
+ * @brief Nombre de réajustements (changement du nombre ou de la
+ * largeur des seaux d'une file calendrier)
+ *
+ * Un nombre élevé relativement au nombre d'événements traduit une
+ * distribution des dates mal adaptée à la file. Pour une roue, c'est
+ * le nombre de reconstructions dues à une insertion dans le
+ * passé. Toujours nul pour les autres implantations.
+ */
+unsigned long eventFile_getNbResize(struct eventFile_t * file);
+
+/**
+ * @brief Numérotation commune des insertions de deux files
+ *
+ * file numérote désormais ses insertions avec le compteur de other :
+ * l'ordre d'insertion entre des événements de même date est alors
+ * connu d'une file à l'autre, ce qui permet au simulateur de les
+ * fusionner (cf motSim_addEvent).
+ */
+void eventFile_shareSequence(struct eventFile_t * file, struct eventFile_t * other);
+
 void eventFile_insert(struct eventFile_t * file, struct event_t * event);
 
 struct event_t * eventFile_extract(struct eventFile_t * file);
 
+/**
+ * @brief Extraction de tous les événements de la date la plus proche
+ *
+ * Les événements annulés sont libérés au passage. Les autres sont
+ * chaînés (champs next et prev) dans l'ordre de leur insertion, comme
+ * des appels successifs à eventFile_extract les auraient donnés, mais
+ * la file n'est réorganisée qu'une fois.
+ *
+ * @return Le premier de la chaîne, NULL si la file est vide
+ */
+struct event_t * eventFile_extractSameDate(struct eventFile_t * file);
+
 /*
  * Consultation (sans extraction) du prochain. NULL si file vide
  */
 struct event_t * eventFile_nextEvent(struct eventFile_t * file);
 
+/*
+ * Nombre d'événements en attente (les événements annulés ne sont pas
+ * comptés)
+ */
 int eventFile_length(struct eventFile_t * file);
 
+/*
+ * Nombre d'événements présents, y compris ceux qui sont annulés
+ */
+int eventFile_size(struct eventFile_t * file);
+
+/*
+ * Vidage de la file sans extraction ni libération des événements (cf
+ * motSim_reset)
+ */
+void eventFile_clear(struct eventFile_t * file);
+
+/**
+ * @brief Annulation d'un événement présent dans la file
+ *
+ * L'événement est seulement marqué. Il sera libéré (cf event_free)
+ * par eventFile_extract ou eventFile_nextEvent lorsqu'il atteindra
+ * la tête de la file, ces fonctions ne renvoient donc jamais un
+ * événement annulé. On utilisera plutôt event_cancel.
+ */
+void eventFile_cancel(struct eventFile_t * file, struct event_t * event);
+
+/**
+ * @brief Déplacement d'un événement présent dans la file
+ *
+ * A date égale, l'événement sort après ceux déjà présents. On
+ * utilisera plutôt event_reschedule.
+ */
+void eventFile_reschedule(struct eventFile_t * file, struct event_t * event, motSimDate_t date);
+
+/*
+ * Un affichage (dans l'ordre de stockage, pas forcément celui des
+ * dates) pour le débogage
+ */
+void eventFile_dump(struct eventFile_t * file);
 
 #endif
@@ -11,27 +11,75 @@
 
 #include <motsim.h>
 
+struct eventFile_t;
+
+/*
+ * Nombre de mots d'arguments transportés par un événement en plus de
+ * data (cf event_setArg)
+ */
+#define EVENT_NB_ARGS 3
+
+union eventArg_t {
+   void * ptr;
+   long   integer;
+   double real;
+};
+
+/*
+ * Les événements sont découpés dans des blocs alignés sur les lignes
+ * de cache (cf event.c). Ce qui sert à chaque comparaison ou
+ * exécution est regroupé dans la première ligne, un tas implicite ne
+ * touche pas à la seconde.
+ */
+#define EVENT_CACHE_LINE 64
+
 struct event_t {
-   int    type;
-   motSimDate_t period;  // Pour les événements périodiques
-   motSimDate_t date;
-   void * data;
+   // Première ligne
+   motSimDate_t     date;
+   unsigned long    seq;     // Numéro d'insertion (FIFO à date égale)
    void (*run)(void * data);
+   void           * data;
+   union {
+      int              heapIdx; // Position dans un tas implicite
+      struct event_t * child;   // Premier fils dans un tas d'appariement
+   };
+   int              type;
+   unsigned long    id;      // Identifiant (change à chaque réutilisation)
+   struct eventFile_t * file; // La file où il attend (NULL sinon)
+
+   // Seconde ligne
+   motSimDate_t     period;  // Pour les événements périodiques
+   void           * origin;  // Programmé par un événement spéculatif (cf pdes.c)
+   union eventArg_t args[EVENT_NB_ARGS];
 
    // Pour le chainage
    struct event_t * prev;
    struct event_t * next;
-};
+} __attribute__((aligned(EVENT_CACHE_LINE)));
 
-#define EVENT_PERIODIC 0x00000001
+#define EVENT_PERIODIC  0x00000001
+#define EVENT_CANCELLED 0x00000002 // Annulé, en attente d'être balayé
+#define EVENT_BATCHED   0x00000004 // Extrait avec ses ex aequo, pas encore exécuté
+#define EVENT_TIMER     0x00000008 // Attend dans la roue des temporisateurs
+
+/**
+ * @brief Une référence sur un événement programmé
+ *
+ * Les événements étant recyclés, un simple pointeur ne suffit pas à
+ * savoir si l'événement désigné est toujours celui que l'on a
+ * programmé. Une poignée mémorise en plus son identifiant, elle
+ * devient simplement caduque lorsque l'événement a été exécuté ou
+ * annulé.
+ */
+struct eventHandle_t {
+   struct event_t * event;
+   unsigned long    id;
+};
 
 /*
- * Les mesures suivantes pourraient être faites par des sondes
+ * Les compteurs (événements créés, réutilisés, annulés, ...) sont
+ * dans le contexte de simulation (cf motsim-context.h)
  */
-extern unsigned long event_nbCreate;
-extern unsigned long event_nbMalloc;
-extern unsigned long event_nbReuse;
-extern unsigned long event_nbFree;
 
 typedef void (*eventAction_t)(void *);
 
@@ -106,8 +154,138 @@ void event_periodicAdd(void (*run)(void *data),
 		       motSimDate_t date,
 		       motSimDate_t period);
 
+/**
+ * @brief  Création d'un temporisateur
+ * Un temporisateur est un événement ordinaire qui attend dans la
+ * roue des temporisateurs plutôt que dans l'échéancier (cf
+ * motSim_addEvent). Son insertion est en O(1), ce qui convient aux
+ * échéances proches et souvent réarmées (délais de garde, sondes
+ * périodiques, ...). Les événements périodiques en sont aussi.
+ *
+ * @param run La fonction à invoquer lors de l'occurence de l'événement
+ * @param data Un pointeur (ou NULL) passé en paramètre à run
+ * @param date Date à laquelle exécuter l'événement
+ * @return L'événement créé
+ */
+struct event_t * event_timerCreate(void (*run)(void *data),
+				   void * data,
+				   motSimDate_t date);
+
+/**
+ * @brief  Création et insertion d'un temporisateur
+ */
+void event_timerAdd(void (*run)(void *data),
+		    void * data,
+		    motSimDate_t date);
+
 motSimDate_t event_getDate(struct event_t * event);
 
 void event_run(struct event_t * event);
 
+/**
+ * @brief Libération d'un événement (il retourne dans la file des
+ * événements libres). Toute poignée sur cet événement devient caduque.
+ */
+void event_free(struct event_t * event);
+
+/**
+ * @brief Affectation d'un argument supplémentaire à un événement
+ *
+ * Un événement transporte, en plus de data, EVENT_NB_ARGS mots
+ * (initialement nuls) que sa fonction retrouve par event_getArg. On
+ * évite ainsi d'allouer une structure par événement lorsque data ne
+ * suffit pas.
+ *
+ * @param event l'événement (pas encore exécuté)
+ * @param n le numéro de l'argument (de 0 à EVENT_NB_ARGS - 1)
+ * @param arg sa valeur
+ */
+void event_setArg(struct event_t * event, int n, void * arg);
+void event_setArgDouble(struct event_t * event, int n, double arg);
+
+/**
+ * @brief Un argument de l'événement en cours d'exécution
+ */
+void * event_getArg(int n);
+double event_getArgDouble(int n);
+
+/**
+ * @brief L'événement en cours d'exécution (NULL en dehors de toute
+ * exécution)
+ */
+struct event_t * event_getCurrent();
+
+/*
+ * Les événements libres retournent dans leurs blocs, dans l'ordre des
+ * adresses. N'est fait que si aucun événement n'est plus en vie (cf
+ * motSim_reset).
+ */
+void event_resetSlabs();
+
+/*
+ * Récupération en bloc des événements : les nbLost événements encore
+ * en vie, qui ne sont plus référencés par personne (cf
+ * eventFile_clear), sont considérés comme libérés, puis tous les
+ * blocs sont rembobinés. Les identifiants sont effacés au passage pour
+ * que les poignées deviennent caduques. Renvoie 0 (sans rien faire) si
+ * d'autres événements sont en vie.
+ */
+int event_reclaimSlabs(long nbLost);
+
+/*
+ * Libération de tous les blocs d'événements d'un contexte (cf
+ * motSim_destroyContext)
+ */
+void event_freeSlabs(struct motsim_t * ctx);
+
+/**
+ * @brief Obtention d'une poignée sur un événement
+ */
+struct eventHandle_t event_getHandle(struct event_t * event);
+
+/**
+ * @brief  Création et insertion d'un événement dont on garde une
+ * poignée pour pouvoir l'annuler ou le déplacer
+ *
+ * @param run La fonction à invoquer lors de l'occurence de l'événement
+ * @param data Un pointeur (ou NULL) passé en paramètre à run
+ * @param date Date à laquelle exécuter l'événement
+ * @return La poignée sur l'événement
+ */
+struct eventHandle_t event_addWithHandle(void (*run)(void *data),
+					 void * data,
+					 motSimDate_t date);
+
+/**
+ * @brief L'événement désigné est-il toujours en attente ?
+ * @return 1 s'il est dans une file et n'a pas été annulé, 0 sinon
+ */
+int event_isPending(struct eventHandle_t handle);
+
+/**
+ * @brief Annulation d'un événement
+ *
+ * L'événement n'est pas retiré immédiatement de sa file, il y est
+ * simplement marqué et sera libéré sans être exécuté lorsqu'il en
+ * atteindra la tête. Un événement périodique peut être annulé depuis
+ * sa propre fonction, il n'est alors plus reprogrammé.
+ *
+ * @param handle la poignée obtenue lors de la programmation
+ * @return 1 si l'événement a été annulé, 0 si la poignée est caduque
+ */
+int event_cancel(struct eventHandle_t handle);
+
+/**
+ * @brief Déplacement d'un événement en attente à une nouvelle date
+ *
+ * L'événement est déplacé sans être recréé (sur place dans les tas).
+ * A date égale, il sortira après ceux déjà programmés, comme s'il
+ * venait d'être inséré.
+ *
+ * @param handle la poignée obtenue lors de la programmation
+ * @param date la nouvelle date
+ * @return 1 si l'événement a été déplacé, 0 si la poignée est caduque
+ */
+int event_reschedule(struct eventHandle_t handle, motSimDate_t date);
+
 #endif
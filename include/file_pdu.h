@@ -119,6 +119,12 @@ int filePDU_size_n_PDU(struct filePDU_t * file, int n);
 int filePDU_size_PDU_n(struct filePDU_t * file, int n);
 int filePDU_id_PDU_n(struct filePDU_t * file, int n);
 
+/**
+ * @brief Nombre de PDU de tête dont la taille cumulée ne dépasse pas
+ * volume (en O(log n), les deux précédentes sont en temps constant)
+ */
+int filePDU_nb_PDU_in(struct filePDU_t * file, unsigned long volume);
+
 /****************************************************************************
     File probes
  ***************************************************************************/
@@ -148,6 +154,15 @@ void filePDU_addSejournProbe(struct filePDU_t * file, struct probe_t * sejournPr
  */
 void filePDU_addFileLengthProbe(struct filePDU_t * file, struct probe_t * length);
 
+/**
+ * @brief Détection d'une croissance durable de la longueur de la file
+ * (cf probe_setInstabilityDetector)
+ * @return la sonde (de moyenne) sur la longueur qui porte le détecteur
+ */
+struct probe_t * filePDU_addInstabilityDetector(struct filePDU_t * file,
+						void (*unstable)(struct probe_t * p, void * data),
+						void * data);
+
 /*
  * Mesure du dÃ©bit d'entrÃ©e sur les n-1 derniÃ¨res PDUs, oÃ¹ n est le
  * nombre de PDUs prÃ©sentes. Le dÃ©bit est alors obtenu en divisant la
@@ -15,6 +15,17 @@ struct llSimplex_t * llSimplex_create(void * destination,
 				      unsigned long throughput,
 				      double propagation);
 
+struct pdes_t;
+
+/*
+ * Le destinataire est dans le LP destLP d'une simulation parallle
+ * (cf pdes.h). A appeler depuis le LP de l'metteur. Le temps de
+ * propagation sert d'anticipation, il doit tre strictement positif.
+ */
+void llSimplex_setDestinationLP(struct llSimplex_t * lls,
+				struct pdes_t * pdes,
+				int destLP);
+
 /*
  * Destruction
  */
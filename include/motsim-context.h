@@ -0,0 +1,119 @@
+/**
+ * @file motsim-context.h
+ * @brief Le contexte d'une simulation
+ *
+ * Tout ce qui est propre à une simulation est regroupé dans un
+ * contexte : l'échéancier, l'horloge, la liste des clients à
+ * réinitialiser, les réserves d'événements et de PDU libres, la
+ * chaîne des sondes, les compteurs d'identifiants et le log.
+ *
+ * Le contexte courant est désigné par __motSim, propre à chaque
+ * thread. Plusieurs simulations indépendantes peuvent donc coexister,
+ * y compris en parallèle pourvu que chacune ne soit manipulée que par
+ * un seul thread à la fois.
+ *
+ * Cette structure ne doit être manipulée que par les modules du
+ * moteur, les modèles passent par les fonctions de motsim.h.
+ */
+#ifndef __DEF_MOTSIM_CONTEXT
+#define __DEF_MOTSIM_CONTEXT
+
+#include <time.h>
+
+#include <motsim.h>
+#include <telemetry.h>
+
+struct resetClient_t {
+   void * data;
+   void (*resetFunc)(void * data);
+
+   struct resetClient_t * next;
+};
+
+struct motsim_t {
+   time_t               actualStartTime;
+   motSimDate_t               currentTime;
+   motSimDate_t               finishTime; // Heure simulée de fin prévue
+   struct eventFile_t * events;
+   struct eventFile_t * timers;     // La roue des temporisateurs (cf motSim_addEvent)
+   int                  nbInsertedEvents;
+   int                  nbRanEvents;
+   unsigned long        nbBatches;  // Groupes d'événements de même date
+   struct event_t     * batch;      // Ceux du groupe courant restant à exécuter
+   int                  status;     // cf motSim_stop
+
+   struct probe_t       * dureeSimulation;
+   struct resetClient_t * resetClient;
+
+   // Les blocs d'événements, les événements libres et quelques
+   // compteurs (cf event.c)
+   struct eventSlab_t * eventSlabs;  // Tous les blocs, dans l'ordre
+   struct eventSlab_t * currentSlab; // Le bloc en cours de découpe
+   unsigned long    event_nbSlabs;
+   struct event_t * freeEvent;
+   struct event_t * runningEvent;    // En cours d'exécution
+   unsigned long    event_nbCreate;
+   unsigned long    event_nbMalloc;
+   unsigned long    event_nbReuse;
+   unsigned long    event_nbFree;
+   unsigned long    event_nbCancel;
+   unsigned long    event_nbReschedule;
+
+   // Les blocs de PDU, les PDU libres, les compteurs et les sondes
+   // système éventuelles (cf pdu.c)
+   struct PDUSlab_t * PDUSlabs;      // Le bloc en cours de découpe en tête
+   unsigned long    PDU_nbSlabs;
+   struct PDU_t   * firstFreePDU;
+   unsigned long long pduNB;
+   unsigned long    PDU_nbCreate;
+   unsigned long    PDU_nbMalloc;
+   unsigned long    PDU_nbReuse;
+   unsigned long    PDU_nbFree;
+   struct probe_t * PDU_createProbe;
+   struct probe_t * PDU_reuseProbe;
+   struct probe_t * PDU_mallocProbe;
+   struct probe_t * PDU_releaseProbe;
+
+   // La région propre à la simulation en cours (cf region.c)
+   struct regionBlock_t * regionFirst;
+   struct regionBlock_t * regionCurrent; // NULL si elle est vide
+
+   // La chaîne de toutes les sondes (cf probe.c)
+   struct probe_t * firstProbe;
+
+   // Les ndesObject et le log (cf ndesObject.c et log.c)
+   int               ndesObject_nb;
+   struct ndesLog_t * ndesLog;
+
+   // La graine des sources d'aléa (cf motSim_setSeed)
+   int                rngSeeded;
+   unsigned long long rngSeed;
+   unsigned long      rngNbStreams;
+   int                rngAntithetic; // cf motSim_setAntithetic
+
+   // Le LP optimiste en cours d'exécution, NULL sinon (cf pdes.c)
+   struct pdesLP_t  * pdesLP;
+
+   // Les mesures des événements (cf profiler.c)
+   int                 profiling;
+   struct profiler_t * profiler;
+
+   // Les clients et fonctions des sauvegardes (cf checkpoint.c)
+   struct checkpointList_t * checkpoint;
+
+   // Les compteurs publiés pour le thread de suivi (cf telemetry.c)
+   struct telemetry_t  telemetry;
+};
+
+/*
+ * Les événements attendent dans l'échéancier ou dans la roue des
+ * temporisateurs (EVENT_TIMER). Les fonctions suivantes, pour les
+ * modules du moteur, donnent la file d'un événement, et consultent
+ * ou extraient le prochain événement du contexte courant, quelle que
+ * soit sa file.
+ */
+struct eventFile_t * motSim_getEventFile(struct event_t * event);
+struct event_t * motSim_nextEvent();
+struct event_t * motSim_extractEvent();
+
+#endif
@@ -1,15 +1,18 @@
 /** @file motsim.c
  * @brief Le moteur de simulation.
  * 
- *   Puisqu'il n'y aura jamais qu'un seul moteur de simulation et
- * qu'il faut le passer en paramètre à de nombreuses fonctions qui n'en
- * ont pas directement besoin mais qui vont elles mêmes le passer à 
- * d'autres fonctions pour finalement qu'il soit utilisé par les fonctions
- * qui génèrent des événements, ... bref une variable globale est créée
- * ici et sera utilisée lorsque nécessaire. Ce n'est pas très glorieux
- * mais ça simplifie tellement.
+ *   Puisque le moteur de simulation devrait être passé en paramètre à
+ * de nombreuses fonctions qui n'en ont pas directement besoin mais qui
+ * vont elles mêmes le passer à d'autres fonctions pour finalement
+ * qu'il soit utilisé par les fonctions qui génèrent des événements,
+ * ... bref une variable désigne le contexte de simulation courant et
+ * sera utilisée lorsque nécessaire. Ce n'est pas très glorieux mais
+ * ça simplifie tellement.
  *
- *   A voir : rendre tout ca multithreadable !
+ *   Cette variable est propre à chaque thread : on peut donc faire
+ * tourner plusieurs simulations indépendantes, chacune dans son
+ * thread, ou passer d'une simulation à l'autre dans un même thread
+ * (cf motSim_setCurrentContext).
  *
  *   Attention, il faut tout de même l'initialiser ! 
  */
@@ -19,29 +22,179 @@
 #include <assert.h>
 #include <stdio.h>   // printf
 #include <stdlib.h>  // malloc
+#include <math.h>    // HUGE_VAL
 
 
 #define min(a, b) ((a)<(b)?(a):(b))
 #define max(a, b) ((a)>(b)?(a):(b))
 
 //#define MOTSIM_LONG_DATE
+//#define MOTSIM_TICK_DATE
 
-#ifdef MOTSIM_LONG_DATE
+/*
+ * Les dates sont par défaut des réels exprimés en secondes. Avec
+ * MOTSIM_TICK_DATE, ce sont des entiers sur 64 bits comptant des
+ * ticks de MOTSIM_TICK secondes (une picoseconde par défaut, soit
+ * plus de 100 jours simulés) : les comparaisons sont exactes et
+ * rapides, et les dates ne dérivent plus au fil des additions. Les
+ * durées issues des générateurs aléatoires ou destinées aux sondes
+ * restent en secondes, on passe de l'un à l'autre par
+ * motSim_secondsToDate et motSim_dateToSeconds (sans effet dans les
+ * autres modes). Un modèle qui veut fonctionner dans tous les modes
+ * doit les utiliser pour toute date ou durée qu'il calcule.
+ *
+ * La bibliothèque et les modèles doivent être compilés avec les
+ * mêmes options.
+ */
+#if defined(MOTSIM_TICK_DATE)
+#   ifndef MOTSIM_TICK
+#      define MOTSIM_TICK 1e-12
+#   endif
+   typedef long long  motSimDate_t;
+#   define MOTSIM_DATE_MAX 0x7fffffffffffffffLL
+#elif defined(MOTSIM_LONG_DATE)
    typedef long double  motSimDate_t;
+#   define MOTSIM_DATE_MAX HUGE_VALL
 #else
    typedef double  motSimDate_t;
+#   define MOTSIM_DATE_MAX HUGE_VAL
 #endif
 
+/*
+ * Conversion d'une durée (ou d'une date) exprimée en secondes, arrondie
+ * au tick le plus proche
+ */
+static inline motSimDate_t motSim_secondsToDate(double seconds)
+{
+#ifdef MOTSIM_TICK_DATE
+   return (motSimDate_t)((seconds / MOTSIM_TICK) + ((seconds < 0.0) ? -0.5 : 0.5));
+#else
+   return seconds;
+#endif
+}
+
+/*
+ * Conversion d'une date (ou d'une durée entre deux dates) en secondes
+ */
+static inline double motSim_dateToSeconds(motSimDate_t date)
+{
+#ifdef MOTSIM_TICK_DATE
+   return (double)date * MOTSIM_TICK;
+#else
+   return (double)date;
+#endif
+}
+
 struct motsim_t;
 struct event_t;
 
-extern struct motsim_t * __motSim;
+/*
+ * Le contexte de simulation courant (cf motsim-context.h)
+ */
+extern __thread struct motsim_t * __motSim;
+
+/*
+ * Les différentes implantations possibles de l'échéancier (la file
+ * des événements en attente). Cf event-file.h
+ */
+enum eventFileType_t {
+   eventFileSortedList,   // Liste triée, insertion en O(n)
+   eventFileBinaryHeap,   // Tas binaire implicite, O(log n)
+   eventFile4aryHeap,     // Tas 4-aire implicite, O(log n)
+   eventFilePairingHeap,  // Tas d'appariement, O(log n) amorti
+   eventFileCalendarQueue, // File calendrier, O(1) amorti
+   eventFileTimingWheel   // Roue hiérarchique, O(1) pour les échéances proches
+};
+
+#define eventFileDefaultType eventFile4aryHeap
 
 /*
  * Initialisation du système
  */
 void motSim_create(); 
 
+/**
+ * @brief Initialisation du système avec un échéancier choisi
+ * @param eventFileType l'implantation de la file des événements
+ *
+ * motSim_create() est équivalente à un appel avec
+ * eventFileDefaultType. Quelle que soit l'implantation, les
+ * événements de même date sont exécutés dans leur ordre d'insertion.
+ */
+void motSim_createWithEventFile(enum eventFileType_t eventFileType);
+
+/**
+ * @brief Obtention du contexte de simulation courant du thread
+ *
+ * Chaque appel à motSim_create crée un nouveau contexte (échéancier,
+ * horloge, sondes, réserves d'événements et de PDU, ...) qui devient
+ * le contexte courant du thread appelant.
+ */
+struct motsim_t * motSim_getCurrentContext();
+
+/**
+ * @brief Changement du contexte de simulation courant du thread
+ * @param ctx le contexte à utiliser (obtenu par
+ * motSim_getCurrentContext après sa création)
+ * @return le contexte précédent
+ *
+ * Un contexte ne doit être courant que dans un thread à la fois.
+ */
+struct motsim_t * motSim_setCurrentContext(struct motsim_t * ctx);
+
+/**
+ * @brief Destruction d'un contexte de simulation
+ *
+ * Les événements en attente, les réserves d'événements et de PDU et
+ * l'échéancier sont libérés. Les objets créés par le modèle (sondes,
+ * files, sources, ...) ne le sont pas. Le contexte ne doit pas être le
+ * contexte courant d'un thread.
+ */
+void motSim_destroyContext(struct motsim_t * ctx);
+
+/**
+ * @brief Choix de la graine des sources d'aléa du contexte courant
+ *
+ * Chaque source d'aléa créée ensuite dans ce contexte reçoit sa
+ * propre sous-suite, déterminée par la graine et son rang de
+ * création. Deux simulations construites de la même façon avec la
+ * même graine sont donc identiques. Sans graine, les sources sont
+ * initialisées à partir de l'heure.
+ */
+void motSim_setSeed(unsigned long long seed);
+
+/*
+ * Initialisation de l'état (pour erand48) d'une nouvelle source
+ * d'aléa. Renvoie 0 si aucune graine n'a été fixée.
+ */
+int motSim_getSubstreamSeed(unsigned short xsubi[3]);
+
+/**
+ * @brief Initialisation de l'état (pour erand48) d'une source d'aléa
+ * à partir d'un identifiant de flot
+ *
+ * Le résultat ne dépend que de la graine du contexte et de
+ * l'identifiant, pas de l'ordre de création des sources. Deux
+ * configurations d'un modèle qui donnent le même identifiant à une
+ * source jouant le même rôle (les arrivées d'une file par exemple)
+ * lui fournissent donc la même suite (cf randomGenerator_setStream).
+ * Sans graine, c'est la graine 0 qui est utilisée.
+ */
+void motSim_getStreamSeed(unsigned long long stream, unsigned short xsubi[3]);
+
+/**
+ * @brief Choix de variables antithétiques
+ *
+ * Si antithetic est non nul, les sources d'aléa créées ensuite dans
+ * le contexte courant fournissent 1 - U au lieu de chaque valeur U
+ * de leur suite (cf randomGenerator_setAntithetic). Deux simulations
+ * de même graine, l'une antithétique et l'autre non, donnent des
+ * résultats négativement corrélés lorsque le modèle répond de façon
+ * monotone à ses tirages.
+ */
+void motSim_setAntithetic(int antithetic);
+int motSim_getAntithetic();
+
 /*
  * A la fin d'une simulation, certains objets ont besoin d'être
  * réinitialiser (pour remettre des compteurs à 0 par exemple). Ces
@@ -55,6 +208,11 @@ void motsim_addToResetList(void * data, void (*resetFunc)(void * data));
  */
 void motSim_reset();
 
+/*
+ * Suppression de tous les événements en attente
+ */
+void motSim_purge();
+
 /*
  * Insertion d'un evenement initialise
  */
@@ -77,6 +235,49 @@ motSimDate_t motSim_getCurrentTime();
  */
 void motSim_runUntil(motSimDate_t date);
 
+/*
+ * L'état d'une simulation (cf motSim_stop)
+ */
+#define MOTSIM_STATUS_OK       0  // En cours ou terminée normalement
+#define MOTSIM_STATUS_STOPPED  1  // Arrêtée par le modèle
+#define MOTSIM_STATUS_UNSTABLE 2  // Arrêtée car instable (cf probe_setInstabilityDetector)
+
+/**
+ * @brief Arrêt de la simulation en cours
+ * @param status la raison de l'arrêt (MOTSIM_STATUS_STOPPED, ...)
+ *
+ * Invoquée depuis un événement, elle arrête la simulation à la fin du
+ * groupe d'événements de même date en cours. Les fonctions
+ * d'exécution (motSim_runUntil, ...) ne font plus rien jusqu'à la
+ * prochaine réinitialisation (motSim_reset).
+ */
+void motSim_stop(int status);
+
+/**
+ * @brief L'état de la simulation, MOTSIM_STATUS_OK si elle n'a pas
+ * été arrêtée
+ */
+int motSim_getStatus();
+
+struct probe_t;
+
+/**
+ * @brief Simulation jusqu'à une précision donnée
+ * @param probes les sondes dont on veut estimer la moyenne
+ * @param nbProbes leur nombre
+ * @param relHalfWidth la demi-largeur relative visée de l'intervalle
+ * de confiance à 95% (0.01 pour 1%)
+ * @param maxDate la date à ne pas dépasser
+ * @return 0 si la précision est atteinte pour chaque sonde, 1 si la
+ * simulation s'est arrêtée à maxDate (ou faute d'événements) avant
+ *
+ * L'intervalle est calculé par la méthode des lots (cf
+ * probe_setBatchMeans, invoquée sur chaque sonde) à des dates de plus
+ * en plus espacées.
+ */
+int motSim_runUntilPrecision(struct probe_t ** probes, int nbProbes,
+			     double relHalfWidth, motSimDate_t maxDate);
+
 /** brief Simulation jusqu'à épuisement des événements
  */
 void motSim_runUntilTheEnd();
@@ -86,6 +287,37 @@ void motSim_runUntilTheEnd();
  */
 void motSim_printStatus();
 
+/*
+ * Les compteurs internes du moteur. Ce sont de simples entiers,
+ * propres à chaque contexte et donc au thread qui l'exécute ; ils ne
+ * sont jamais remis à zéro (pas même par motSim_reset). Un relevé
+ * les copie tous d'un coup, et plusieurs relevés (ceux des contextes
+ * d'une campagne par exemple) peuvent être cumulés.
+ */
+struct motSimCounters_t {
+   unsigned long eventCreated;
+   unsigned long eventMalloced;
+   unsigned long eventReused;
+   unsigned long eventFreed;
+   unsigned long eventCancelled;
+   unsigned long eventRescheduled;
+   unsigned long PDUCreated;
+   unsigned long PDUMalloced;
+   unsigned long PDUReused;
+   unsigned long PDUFreed;
+};
+
+/*
+ * Relevé des compteurs d'un contexte (NULL pour le contexte courant),
+ * qui ne doit pas être en cours d'exécution par un autre thread
+ */
+void motSim_getCounters(struct motsim_t * ctx, struct motSimCounters_t * counters);
+
+/*
+ * Ajout des compteurs de counters à ceux de total
+ */
+void motSim_addCounters(struct motSimCounters_t * total, const struct motSimCounters_t * counters);
+
 /*
  * Lancement de nbSimu simulations, chacune d'une durée inférieures ou
  * égale à date.
@@ -108,7 +340,7 @@ void motSim_exit(int retValue);
 
 #   define printf_debug(lvl, fmt, args...)	\
    if ((lvl)& debug_mask)                    \
-      printf("[%6.3f ms] %s - " fmt, 1000.0*motSim_getCurrentTime() , __FUNCTION__ , ## args)
+      printf("[%6.3f ms] %s - " fmt, 1000.0*motSim_dateToSeconds(motSim_getCurrentTime()) , __FUNCTION__ , ## args)
 
 #define DEBUG_EVENT    0x00000001
 #define DEBUG_MOTSIM   0x00000002
@@ -177,7 +409,7 @@ static unsigned long debug_mask __attribute__ ((unused)) = 0x00000000
    printf("\n------- Error report -------\n");                      \
    if (lvl == MS_FATAL) motSim_exit(1);
 
-extern unsigned long __totalMallocSize;
+extern __thread unsigned long __totalMallocSize;
 
 #define sim_malloc(l)				\
   ({ void * __tmpMallocRes = malloc(l);\
@@ -0,0 +1,177 @@
+/**
+ * @file pdes.h
+ * @brief Simulation parallèle, conservatrice ou optimiste
+ *
+ * Un modèle peut être découpé en plusieurs processus logiques (LP),
+ * chacun ayant son propre contexte de simulation (cf
+ * motsim-context.h) et exécuté par son propre thread. Les LP ne
+ * communiquent que par des PDU transmises sur des liens
+ * (llSimplex_t) dont l'émetteur et le destinataire sont dans des LP
+ * différents (cf llSimplex_setDestinationLP).
+ *
+ * Une PDU émise sur un tel lien à la date t n'arrive pas avant t +
+ * propagation. Le plus petit temps de propagation L des liens entre
+ * LP fournit donc une anticipation (lookahead) : si T est la date du
+ * prochain événement, tous LP confondus, aucun LP ne peut recevoir de
+ * PDU avant T + L. Chaque LP exécute alors sans risque ses événements
+ * de date inférieure à T + L, puis tous se synchronisent (barrière),
+ * récupèrent les PDU reçues et recommencent (YAWNS).
+ *
+ * Les PDU transitent d'un LP à l'autre par des canaux sans verrou
+ * (un seul producteur, un seul consommateur).
+ *
+ * Si le modèle est construit de la même façon (même ordre de
+ * création, même graine, cf motSim_setSeed), les résultats sont
+ * identiques à ceux d'une exécution séquentielle dans un seul
+ * contexte, à condition que deux événements d'un même LP ne tombent
+ * jamais exactement à la même date (l'ordre d'insertion, qui les
+ * départage, n'est pas le même). Les identifiants des PDU sont en
+ * revanche propres à chaque LP.
+ *
+ * Lorsque l'anticipation est faible (voire nulle), les LP peuvent
+ * être exécutés de façon optimiste (Time Warp, cf pdes_setOptimistic)
+ * : chacun exécute ses événements sans attendre les autres. Une PDU
+ * qui arrive dans le passé d'un LP (retardataire) provoque un retour
+ * arrière : les événements postérieurs sont annulés, l'état des
+ * objets enregistrés (cf pdes_registerState) est restauré et les PDU
+ * émises par ces événements sont annulées par des anti-messages. Le
+ * temps virtuel global (GVT), calculé régulièrement, permet de
+ * libérer l'historique, les états sauvegardés et les PDU des
+ * événements qui ne peuvent plus être annulés.
+ *
+ * Seul l'état enregistré est restauré : le modèle doit donc garder
+ * son état dans des objets enregistrés et ne pas échantillonner de
+ * sondes pendant l'exécution spéculative. Les événements ne peuvent
+ * pas y être annulés ni déplacés (cf event_cancel).
+ */
+#ifndef __DEF_PDES
+#define __DEF_PDES
+
+#include <stddef.h>   // size_t
+
+#include <motsim.h>
+#include <pdu.h>
+
+struct pdes_t;
+struct pdesChannel_t;
+struct ndesObject_t;
+struct event_t;
+
+/**
+ * @brief Création d'une simulation parallèle
+ * @param nbLP le nombre de processus logiques
+ *
+ * Un contexte est créé pour chaque LP. Le premier devient le contexte
+ * courant.
+ */
+struct pdes_t * pdes_create(int nbLP);
+
+/**
+ * @brief Choix du LP dans lequel sont créés les prochains éléments
+ * du modèle
+ *
+ * Le contexte du LP devient le contexte courant. La graine et la
+ * numérotation des sources d'aléa sont reportées d'un LP à l'autre :
+ * une graine fixée (cf motSim_setSeed) dans le premier LP vaut donc
+ * pour tous, et les sources reçoivent les mêmes sous-suites que dans
+ * une construction séquentielle dans le même ordre.
+ */
+void pdes_setCurrentLP(struct pdes_t * pdes, int lp);
+
+/**
+ * @brief Passage en mode optimiste (Time Warp)
+ * @param batch le nombre maximal d'événements exécutés par chaque LP
+ * entre deux calculs du GVT
+ * @param window l'avance maximale d'un LP sur le GVT (MOTSIM_DATE_MAX pour
+ * ne pas limiter l'optimisme)
+ *
+ * A appeler avant la création des canaux, dont l'anticipation peut
+ * alors être nulle.
+ */
+void pdes_setOptimistic(struct pdes_t * pdes, int batch, motSimDate_t window);
+
+/**
+ * @brief Enregistrement d'une zone mémoire faisant partie de l'état du
+ * LP courant
+ *
+ * En mode optimiste, les modifications de cette zone par chaque
+ * événement sont sauvegardées (seuls les mots modifiés le sont) pour
+ * pouvoir être défaites lors d'un retour arrière. Sans effet en mode
+ * conservateur.
+ */
+void pdes_registerState(struct pdes_t * pdes, void * data, size_t size);
+
+/**
+ * @brief Enregistrement des données privées d'un ndesObject (cf
+ * pdes_registerState)
+ */
+void pdes_registerObject(struct pdes_t * pdes, struct ndesObject_t * object);
+
+/**
+ * @brief Création d'un canal depuis le LP courant vers le LP destLP
+ * @param destination l'entité destinataire (dans destLP)
+ * @param destProcessPDU sa fonction de traitement
+ * @param lookahead le délai minimal entre l'émission et l'arrivée
+ * d'une PDU sur ce canal (strictement positif, sauf en mode optimiste)
+ *
+ * Utilisé par llSimplex_setDestinationLP.
+ */
+struct pdesChannel_t * pdes_channelCreate(struct pdes_t * pdes,
+					  int destLP,
+					  void * destination,
+					  processPDU_t destProcessPDU,
+					  motSimDate_t lookahead);
+
+/**
+ * @brief Emission d'une PDU qui sera fournie au destinataire à la date
+ * date (au moins lookahead après la date courante)
+ */
+void pdes_channelSend(struct pdesChannel_t * channel,
+		      struct PDU_t * pdu,
+		      motSimDate_t date);
+
+/**
+ * @brief Réinitialisation de tous les LP (cf motSim_reset)
+ */
+void pdes_reset(struct pdes_t * pdes);
+
+/**
+ * @brief Exécution parallèle jusqu'à la date date
+ *
+ * Chaque LP est exécuté par un thread. La fonction rend la main
+ * lorsque tous les événements de date inférieure ou égale à date ont
+ * été traités.
+ */
+void pdes_runUntil(struct pdes_t * pdes, motSimDate_t date);
+
+/**
+ * @brief Affichage des statistiques de chaque LP : événements
+ * exécutés, fenêtres (dont celles sans événement, qui ne servent qu'à
+ * la synchronisation), PDU échangées et temps passé bloqué aux
+ * barrières. Elles permettent de juger du découpage du modèle.
+ */
+void pdes_printStatus(struct pdes_t * pdes);
+
+/**
+ * @brief Sonde recevant, pour le LP lp en mode optimiste, le nombre
+ * d'événements défaits à chaque retour arrière
+ */
+struct probe_t * pdes_getRollbackProbe(struct pdes_t * pdes, int lp);
+
+/**
+ * @brief Sonde recevant, pour le LP lp en mode optimiste, l'efficacité
+ * (événements validés / événements exécutés) de chaque intervalle
+ * entre deux calculs du GVT
+ */
+struct probe_t * pdes_getEfficiencyProbe(struct pdes_t * pdes, int lp);
+
+/*
+ * Utilisées par le moteur pour suivre l'exécution spéculative d'un LP
+ * optimiste (cf motsim-context.h)
+ */
+void pdes_eventInserted(struct event_t * event);
+void pdes_PDUCreated(struct PDU_t * pdu);
+int pdes_PDUFreed(struct PDU_t * pdu);
+int pdes_isSpeculative();
+
+#endif
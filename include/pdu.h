@@ -24,7 +24,13 @@ extern struct PDU_t * PDU_create(int size, void * private);
  */
 extern int PDU_size(struct PDU_t * PDU);
 
+/*
+ * L'identifiant, sur 64 bits pour ne pas boucler sur les longues
+ * simulations. PDU_id n'en donne que les 32 bits de poids faible (pour
+ * les traces).
+ */
 extern int PDU_id(struct PDU_t * PDU);
+extern unsigned long long PDU_getId(struct PDU_t * PDU);
 
 /*
  * Obtention de la date de création
@@ -39,6 +45,33 @@ void * PDU_private(struct PDU_t * PDU);
  */
 void PDU_free(struct PDU_t * pdu);
 
+/*
+ * Destruction d'une chaîne de nb PDU, liées par leur champ next de
+ * first à last (inclus). La chaîne est ajoutée d'un coup à la liste
+ * des PDU libres (cf filePDU_reset).
+ */
+void PDU_freeChain(struct PDU_t * first, struct PDU_t * last, int nb);
+
+/*
+ * Recréation d'une PDU sauvegardée, avec son identifiant et sa date
+ * de création d'origine (cf checkpoint.h)
+ */
+struct PDU_t * PDU_restore(int size, void * private, unsigned long long id,
+                           motSimDate_t creationDate);
+
+/*
+ * L'en-tête ndesObject d'une PDU n'est créé qu'au premier appel de
+ * cette fonction (pour le log par exemple)
+ */
+struct ndesObject_t;
+struct ndesObject_t * PDU_getObject(struct PDU_t * PDU);
+
+/*
+ * Libération des blocs dans lesquels sont découpées les PDU d'un
+ * contexte (cf motSim_destroyContext)
+ */
+void PDU_freeSlabs(struct motsim_t * ctx);
+
 /*
  * Le type des fonctions utilisées entre les producteurs
  * et consommateurs de PDU.
@@ -80,16 +113,16 @@ void PDU_setNext(struct PDU_t * pdu, struct PDU_t * next);
  */
 void PDU_setPrev(struct PDU_t * pdu, struct PDU_t * prev);
 
-
 /*
- * Les sondes systeme WARNING : a déclarer ici ?
+ * Les créations, réutilisations, allocations et libérations de PDU
+ * sont comptées dans le contexte de simulation (cf
+ * motSim_getCounters). Des sondes peuvent en plus être attachées à ces
+ * événements (NULL pour en détacher une), elles sont alors alimentées
+ * avec l'identifiant de la PDU.
  */
 struct probe_t;
-
-extern struct probe_t * PDU_createProbe;
-extern struct probe_t * PDU_reuseProbe;
-extern struct probe_t * PDU_mallocProbe;
-extern struct probe_t * PDU_releaseProbe;
+void PDU_setSystemProbes(struct probe_t * create, struct probe_t * reuse,
+                         struct probe_t * alloc, struct probe_t * release);
 
 
 #endif
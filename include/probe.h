@@ -126,6 +126,11 @@ void probe_setName(struct probe_t * p, char * name);
  */
 char * probe_getName(struct probe_t * p);
 
+/**
+ * @brief Type d'une sonde
+ */
+enum probeType_t probe_getType(struct probe_t * p);
+
 /**
  * @brief Echantillonage d'une valeur
  * @param probe La sonde dans laquelle on veut enregistrer
@@ -135,6 +140,121 @@ char * probe_getName(struct probe_t * p);
  */
 void probe_sample(struct probe_t * probe, double value);
 
+/**
+ * @brief Fusion des échantillons d'une sonde dans une autre
+ * @param dst La sonde qui reçoit les échantillons
+ * @param src La sonde dont les échantillons sont ajoutés (inchangée)
+ *
+ * dst se retrouve dans l'état où elle serait si elle avait aussi
+ * reçu les échantillons de src. Seules les sondes exhaustives, de
+ * moyenne et les histogrammes (de mêmes bornes) peuvent être
+ * fusionnés, avec une sonde de même type. Les méta sondes de dst ne
+ * sont pas alimentées.
+ */
+void probe_merge(struct probe_t * dst, struct probe_t * src);
+
+/*****************************************************************************
+       Fenêtres de mesure
+ */
+
+/**
+ * @brief Choix de la fenêtre de mesure d'une sonde
+ * @param p la sonde
+ * @param start début de la fenêtre (en secondes)
+ * @param end fin de la fenêtre (en secondes), pas de fin si end <= start
+ *
+ * Les échantillons pris hors de [start, end[ ne sont pas conservés (ni
+ * transmis aux méta sondes). La fenêtre survit aux réinitialisations.
+ */
+void probe_setMeasureWindow(struct probe_t * p, double start, double end);
+
+/**
+ * @brief Détection de la fin du régime transitoire sur une sonde
+ *
+ * La troncature est déterminée en ligne, sur les échantillons de p,
+ * par la méthode MSER-5, avec une mémoire bornée. La sonde p conserve
+ * tous ses échantillons.
+ */
+void probe_setWarmupDetector(struct probe_t * p);
+
+/**
+ * @brief La sonde p ne conserve ses échantillons qu'après la fin du
+ * régime transitoire détectée par la sonde detector
+ *
+ * detector devient si nécessaire un détecteur. Cette condition
+ * s'ajoute à l'éventuelle fenêtre de mesure de p.
+ */
+void probe_startAfterWarmup(struct probe_t * p, struct probe_t * detector);
+
+/**
+ * @brief La fin du régime transitoire a-t-elle été détectée ?
+ */
+int probe_warmupDetected(struct probe_t * p);
+
+/**
+ * @brief Date (en secondes) de la détection, 0 si elle n'a pas eu lieu
+ */
+double probe_warmupDate(struct probe_t * p);
+
+/**
+ * @brief Nombre d'échantillons du régime transitoire selon MSER-5
+ */
+unsigned long probe_warmupTruncation(struct probe_t * p);
+
+/*****************************************************************************
+       Intervalles de confiance par lots
+ */
+
+/**
+ * @brief Calcul en ligne d'un intervalle de confiance par la méthode
+ * des lots (batch means) sur les échantillons de p
+ *
+ * Contrairement à probe_demiIntervalleConfiance5pc, les échantillons
+ * n'ont pas besoin d'être indépendants : seules les moyennes des lots,
+ * dont la taille croît avec le nombre d'échantillons, doivent
+ * l'être. La mémoire utilisée est bornée, quel que soit le type de la
+ * sonde.
+ */
+void probe_setBatchMeans(struct probe_t * p);
+
+/**
+ * @brief Demi-largeur de l'intervalle de confiance à 95% de la moyenne
+ * @return -1 s'il n'y a pas encore assez de lots, ou s'ils sont
+ * encore corrélés
+ */
+double probe_batchMeansHalfWidth(struct probe_t * p);
+
+/**
+ * @brief Moyenne des lots complets, centre de l'intervalle
+ */
+double probe_batchMeansMean(struct probe_t * p);
+
+/*****************************************************************************
+       Détection d'instabilité
+ */
+
+/**
+ * @brief Détection d'une croissance durable des échantillons de p
+ * @param p la sonde (la longueur d'une file, un temps de séjour, ...)
+ * @param unstable la fonction invoquée lors de la détection, ou NULL
+ * pour arrêter la simulation (cf motSim_stop) avec l'état
+ * MOTSIM_STATUS_UNSTABLE
+ * @param data le pointeur passé à unstable
+ *
+ * Un test de tendance (Mann-Kendall) est appliqué en ligne aux
+ * moyennes de lots d'échantillons de taille croissante. Il doit être
+ * positif sur un horizon multiplié par 16 pour que l'instabilité soit
+ * déclarée, ce qui n'arrive qu'une fois par simulation.
+ */
+void probe_setInstabilityDetector(struct probe_t * p,
+				  void (*unstable)(struct probe_t * p, void * data),
+				  void * data);
+
+/**
+ * @brief Une instabilité a-t-elle été détectée sur p ?
+ */
+int probe_instabilityDetected(struct probe_t * p);
+
 /*****************************************************************************
        Probes and filters
  */
@@ -0,0 +1,89 @@
+/**
+ * @file profiler.h
+ * @brief Profilage des événements
+ *
+ * Lorsque la bibliothèque est compilée avec MOTSIM_PROFILE, la
+ * boucle du simulateur (event_run) peut mesurer, pour chaque fonction
+ * d'événement et pour chaque ndesObject destinataire d'un événement
+ * (son paramètre data), le nombre d'exécutions, leur coût en cycles
+ * (cumulé, minimal et maximal) et le nombre d'événements qu'elles
+ * programment. Le coût d'un événement inclut celui des événements
+ * qu'il exécute lui-même (cf srcTCPss_addEOTEvent).
+ *
+ * Sans MOTSIM_PROFILE, rien n'est mesuré et la boucle du simulateur
+ * n'est pas modifiée ; les fonctions suivantes ne font rien.
+ *
+ * Les noms des fonctions sont obtenus par dladdr : l'exécutable doit
+ * être lié avec -ldl (nécessaire avant la glibc 2.34) et avec
+ * -rdynamic pour que ceux de ses propres fonctions (et de la
+ * bibliothèque statique) soient connus, à défaut leur adresse est
+ * affichée.
+ *
+ * Les mesures sont propres au contexte de simulation courant.
+ */
+#ifndef __DEF_PROFILER
+#define __DEF_PROFILER
+
+#include <motsim.h>
+
+struct event_t;
+struct ndesObject_t;
+struct motsim_t;
+
+/**
+ * @brief Démarrage (ou reprise) des mesures
+ */
+void profiler_start();
+
+/**
+ * @brief Suspension des mesures
+ */
+void profiler_stop();
+
+/**
+ * @brief Effacement des mesures
+ */
+void profiler_reset();
+
+/**
+ * @brief Affichage des rapports par fonction et par objet, triés par
+ * coût cumulé décroissant
+ * @param nbLines nombre maximal de lignes de chaque rapport (0 pour
+ * tout afficher)
+ */
+void profiler_printReport(int nbLines);
+
+/**
+ * @brief Ecriture des mesures dans un fichier CSV
+ *
+ * Une ligne par fonction puis par objet : kind, name, count, cycles,
+ * min, max, mean, scheduled.
+ *
+ * @return 0 si tout va bien
+ */
+int profiler_writeCSV(const char * fileName);
+
+/**
+ * @brief Nombre d'exécutions d'une fonction d'événement mesurées
+ */
+unsigned long profiler_getNbRuns(void (*run)(void *data));
+
+/**
+ * @brief Nombre d'événements programmés par une fonction d'événement
+ */
+unsigned long profiler_getNbScheduled(void (*run)(void *data));
+
+/**
+ * @brief Nombre d'exécutions d'événements destinés à un objet
+ */
+unsigned long profiler_getObjectNbRuns(struct ndesObject_t * object);
+
+/*
+ * Les fonctions suivantes sont utilisées par le moteur
+ */
+void profiler_runEvent(struct event_t * event);  // cf event_run
+void profiler_eventScheduled();                   // cf motSim_addEvent
+void profiler_registerObject(struct ndesObject_t * object); // cf ndesObject_create
+void profiler_free(struct motsim_t * ctx);       // cf motSim_destroyContext
+
+#endif
@@ -127,6 +127,35 @@ struct randomGenerator_t * randomGenerator_createFromProbe(struct probe_t * p);
 
 void randomGenerator_reset(struct randomGenerator_t * rg);
 
+/**
+ * @brief Choix d'un flot d'aléa stable
+ * @param rg le générateur
+ * @param stream l'identifiant du flot
+ *
+ * Par défaut, la sous-suite d'un générateur dépend de son rang de
+ * création (cf motSim_setSeed), elle change donc dès qu'une
+ * configuration du modèle crée un générateur de plus ou de moins. Un
+ * identifiant lié au rôle du générateur dans le modèle lui assure la
+ * même suite dans toutes les configurations simulées avec la même
+ * graine (nombres aléatoires communs). Seule la source erand48 est
+ * concernée.
+ */
+void randomGenerator_setStream(struct randomGenerator_t * rg, unsigned long long stream);
+
+/**
+ * @brief La même, l'identifiant étant obtenu à partir d'un nom
+ */
+void randomGenerator_setStreamName(struct randomGenerator_t * rg, const char * role);
+
+/**
+ * @brief Variable antithétique
+ *
+ * Si antithetic est non nul, le générateur utilise 1 - U au lieu de
+ * chaque valeur U de sa suite. Par défaut, c'est le choix du contexte
+ * lors de la création (cf motSim_setAntithetic).
+ */
+void randomGenerator_setAntithetic(struct randomGenerator_t * rg, int antithetic);
+
 /*
  * Destructor
  */
@@ -0,0 +1,60 @@
+/**
+ * @file region.h
+ * @brief Allocation de la mémoire propre à une simulation
+ *
+ * Ce qui est alloué par sim_malloc lors de la construction du modèle
+ * dure autant que lui. Les objets qui ne vivent que le temps d'une
+ * simulation (encapsulations, trames, solutions temporaires d'un
+ * ordonnanceur, ...) peuvent au contraire être pris dans la région du
+ * contexte courant : l'allocation se réduit à l'avancée d'un pointeur
+ * dans un bloc, et tout est rendu d'un coup par motSim_reset. Les
+ * blocs sont conservés pour la simulation suivante, une campagne de
+ * simulations successives n'alloue donc plus rien après la première.
+ *
+ * Un objet de la région ne peut pas être libéré seul, mais on peut
+ * noter la position courante et y revenir, ce qui rend tout ce qui a
+ * été alloué depuis (pour une zone de travail temporaire par exemple).
+ */
+#ifndef __DEF_REGION
+#define __DEF_REGION
+
+#include <stddef.h>   // size_t
+
+struct motsim_t;
+struct regionBlock_t;
+
+/**
+ * @brief Une position dans la région (cf motSim_runMark)
+ */
+struct motSimRunMark_t {
+   struct regionBlock_t * block;
+   size_t                 used;
+};
+
+/**
+ * @brief Allocation de size octets (alignés sur 16) dans la région du
+ * contexte courant, rendus par le prochain motSim_reset
+ *
+ * Le contenu n'est pas initialisé.
+ */
+void * motSim_runMalloc(size_t size);
+
+/**
+ * @brief La position courante dans la région
+ */
+struct motSimRunMark_t motSim_runMark();
+
+/**
+ * @brief Retour à une position notée par motSim_runMark, tout ce qui
+ * a été alloué depuis est rendu
+ */
+void motSim_runRelease(struct motSimRunMark_t mark);
+
+/*
+ * Pour le moteur : la région est vidée par motSim_reset et ses blocs
+ * libérés avec le contexte
+ */
+void region_reset();
+void region_free(struct motsim_t * ctx);
+
+#endif
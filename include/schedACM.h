@@ -383,6 +383,12 @@ int schedACM_getNbEpochStarvation(struct schedACM_t * sched);
  */
 void remplissage_init(t_remplissage * tr, int nbModCod, int nbQoS);
 
+/**
+ * @brief Initialisation d'une solution de travail dans la région de
+ * la simulation (cf region.h), qui n'est pas à libérer
+ */
+void remplissage_initRun(t_remplissage * tr, int nbModCod, int nbQoS);
+
 /**
  * @brief Remise à zéro d'un remplissage
  */
@@ -0,0 +1,87 @@
+/**
+ * @file telemetry.h
+ * @brief Suivi de l'avancement des simulations
+ *
+ * Chaque contexte de simulation publie quelques compteurs (date
+ * simulée, événements exécutés et en attente, PDU utilisées et
+ * allouées) dans des variables atomiques. Un thread de suivi, lancé
+ * par telemetry_start, les échantillonne périodiquement pour tous les
+ * contextes existants et en déduit le débit (événements par seconde)
+ * et le rapport entre temps simulé et temps réel. Il affiche une
+ * ligne d'état et/ou écrit une ligne JSON par échantillon.
+ *
+ * La boucle du simulateur ne publie ses compteurs que lorsque le
+ * thread de suivi le demande (un simple test par groupe d'événements
+ * de même date), et à la fin de chaque motSim_runUntil.
+ *
+ * motSim_create enregistre chaque contexte auprès du suivi, qui
+ * utilise les pthreads : tout programme lié à la bibliothèque doit
+ * l'être avec -lpthread (nécessaire avant la glibc 2.34).
+ */
+#ifndef __DEF_TELEMETRY
+#define __DEF_TELEMETRY
+
+#include <stdatomic.h>
+
+struct motsim_t;
+
+/*
+ * Les compteurs publiés par un contexte (cf motsim-context.h)
+ */
+struct telemetry_t {
+   atomic_int           requested;    // Le thread de suivi attend une publication
+   _Atomic double       date;         // Date simulée (en secondes)
+   _Atomic double       finishTime;   // Fin prévue (en secondes)
+   atomic_ulong         nbEvents;     // Evénements exécutés
+   atomic_ulong         nbPending;    // Evénements en attente
+   atomic_ulong         nbPDUInUse;
+   atomic_ulong         nbPDUAllocated;
+
+   // Propre au thread de suivi
+   int                  id;
+   double               lastDate;
+   unsigned long        lastEvents;
+   struct telemetry_t * next;
+};
+
+/**
+ * @brief Lancement du thread de suivi
+ * @param period intervalle entre deux échantillons (en secondes de
+ * temps réel)
+ * @param statusLine affichage d'une ligne d'état (réécrite à chaque
+ * échantillon) sur la sortie standard
+ * @param jsonFileName fichier où écrire une ligne JSON par
+ * échantillon ("-" pour la sortie standard, NULL pour ne pas en
+ * écrire)
+ * @return 0 si tout va bien
+ */
+int telemetry_start(double period, int statusLine, const char * jsonFileName);
+
+/**
+ * @brief Arrêt du thread de suivi (après un dernier échantillon)
+ */
+void telemetry_stop();
+
+/**
+ * @brief Nombre d'échantillons pris depuis telemetry_start
+ */
+unsigned long telemetry_getNbSamples();
+
+/*
+ * Les fonctions suivantes sont utilisées par le moteur
+ */
+void telemetry_register(struct motsim_t * ctx);   // cf motSim_create
+void telemetry_unregister(struct motsim_t * ctx); // cf motSim_destroyContext
+void telemetry_publish(struct motsim_t * ctx);
+
+/*
+ * Publication si le thread de suivi l'a demandée
+ */
+#define telemetry_poll(ctx)                                              \
+   do {                                                                 \
+      if (atomic_load_explicit(&(ctx)->telemetry.requested, memory_order_relaxed)) { \
+         telemetry_publish(ctx);                                        \
+      }                                                                 \
+   } while (0)
+
+#endif
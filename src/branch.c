@@ -0,0 +1,172 @@
+/**
+ * @file branch.c
+ * @brief Implantation des embranchements
+ *
+ * Chaque fils a son tube, dont le père ne garde que l'extrémité en
+ * lecture. Les fils sont tous lancés avant que le père ne lise leurs
+ * résumés, dans l'ordre des branches. Un fils qui se termine sans
+ * avoir écrit tous ses résumés (sur une erreur fatale par exemple) est
+ * compté comme un échec.
+ */
+#include <stdio.h>     // fflush
+#include <stdlib.h>    // malloc (cf sim_malloc)
+#include <string.h>    // memset
+#include <errno.h>
+#include <signal.h>    // sigaction
+#include <unistd.h>    // fork, pipe, ...
+#include <sys/wait.h>  // waitpid
+
+#include <branch.h>
+#include <motsim-context.h>
+
+/*
+ * Ecriture ou lecture complète d'un bloc, 0 si tout va bien
+ */
+static int branch_write(int fd, const void * buffer, size_t size)
+{
+   const char * p = (const char *)buffer;
+   ssize_t      n;
+
+   while (size > 0) {
+      n = write(fd, p, size);
+      if ((n < 0) && (errno == EINTR)) {
+         continue;
+      }
+      if (n <= 0) {
+         return 1;
+      }
+      p += n;
+      size -= n;
+   }
+   return 0;
+}
+
+static int branch_read(int fd, void * buffer, size_t size)
+{
+   char    * p = (char *)buffer;
+   ssize_t   n;
+
+   while (size > 0) {
+      n = read(fd, p, size);
+      if ((n < 0) && (errno == EINTR)) {
+         continue;
+      }
+      if (n <= 0) {
+         return 1;
+      }
+      p += n;
+      size -= n;
+   }
+   return 0;
+}
+
+static void branch_summarize(struct probe_t * probe, struct motSimBranchResult_t * result)
+{
+   memset(result, 0, sizeof(*result));
+   result->nbSamples = probe_nbSamples(probe);
+   if (result->nbSamples) {
+      result->mean = probe_mean(probe);
+      result->min = probe_min(probe);
+      result->max = probe_max(probe);
+   }
+   if ((probe_getType(probe) == exhaustiveProbeType) && (result->nbSamples > 1)) {
+      result->variance = probe_variance(probe);
+   }
+}
+
+/*
+ * Le travail d'un fils, qui ne revient pas
+ */
+static void branch_run(int n, int fd, motSimDate_t date,
+		       motSimBranchChange_t change, void * data,
+		       int nbProbes, struct probe_t ** probes)
+{
+   struct motSimBranchResult_t result;
+   int m, status = 0;
+
+   if (change) {
+      change(n, data);
+   }
+   motSim_runUntil(date);
+
+   for (m = 0; (m < nbProbes) && (!status); m++) {
+      branch_summarize(probes[m], &result);
+      status = branch_write(fd, &result, sizeof(result));
+   }
+   close(fd);
+
+   fflush(NULL);
+   _exit(status);
+}
+
+int motSim_branch(int nbBranches, motSimDate_t date,
+		  motSimBranchChange_t change, void * data,
+		  int nbProbes, struct probe_t ** probes,
+		  struct motSimBranchResult_t * results)
+{
+   pid_t * pids;
+   int   * fds;
+   int     tube[2];
+   int     n, failed, status, nbFailed = 0;
+   struct sigaction act, oldAct;
+
+   if ((__motSim->runningEvent) || (__motSim->batch) || (__motSim->pdesLP)) {
+      motSim_error(MS_WARN, "embranchement impossible pendant une exécution");
+      return -1;
+   }
+
+   pids = (pid_t *)sim_malloc(nbBranches * sizeof(pid_t));
+   fds = (int *)sim_malloc(nbBranches * sizeof(int));
+   memset(results, 0, nbBranches * nbProbes * sizeof(struct motSimBranchResult_t));
+
+   // Le gestionnaire installé par motSim_create (SA_NOCLDWAIT) ne
+   // permet pas d'attendre les fils
+   memset(&act, 0, sizeof(act));
+   act.sa_handler = SIG_DFL;
+   sigaction(SIGCHLD, &act, &oldAct);
+
+   // Ce qui est en attente d'écriture ne doit pas l'être par chaque fils
+   fflush(NULL);
+
+   for (n = 0; n < nbBranches; n++) {
+      pids[n] = -1;
+      fds[n] = -1;
+      if (pipe(tube)) {
+         continue;
+      }
+      pids[n] = fork();
+      if (pids[n] == 0) {
+         close(tube[0]);
+         branch_run(n, tube[1], date, change, data, nbProbes, probes);
+      }
+      close(tube[1]);
+      if (pids[n] < 0) {
+         close(tube[0]);
+      } else {
+         fds[n] = tube[0];
+      }
+   }
+
+   for (n = 0; n < nbBranches; n++) {
+      if (fds[n] < 0) {
+         motSim_error(MS_WARN, "branche %d non lancée", n);
+         nbFailed++;
+         continue;
+      }
+      failed = branch_read(fds[n], &results[n * nbProbes],
+			   nbProbes * sizeof(struct motSimBranchResult_t));
+      close(fds[n]);
+      while ((waitpid(pids[n], &status, 0) < 0) && (errno == EINTR));
+      if ((failed) || (!WIFEXITED(status)) || (WEXITSTATUS(status))) {
+         memset(&results[n * nbProbes], 0, nbProbes * sizeof(struct motSimBranchResult_t));
+         motSim_error(MS_WARN, "échec de la branche %d", n);
+         nbFailed++;
+      }
+   }
+
+   sigaction(SIGCHLD, &oldAct, NULL);
+   sim_free(pids);
+   sim_free(fds);
+
+   return nbFailed;
+}
@@ -0,0 +1,387 @@
+/**
+ * @file campaign.c
+ * @brief Implantation des campagnes de simulation
+ *
+ * Les réplications sont distribuées à tour de rôle dans les files des
+ * threads. Un thread prend ses réplications en queue de sa file et,
+ * lorsqu'elle est vide, en vole en tête de celle d'un autre. Aucune
+ * réplication n'est ajoutée en cours de route, un thread s'arrête donc
+ * dès que toutes les files sont vides.
+ *
+ * Chaque réplication garde son contexte jusqu'à la fin de la
+ * campagne. Les résultats sont alors fusionnés, dans l'ordre des
+ * réplications, par le thread appelant, puis les contextes sont
+ * détruits.
+ */
+#include <stdlib.h>    // Malloc, NULL, ...
+#include <assert.h>
+#include <pthread.h>
+#include <unistd.h>    // sysconf
+#include <time.h>
+
+#include <campaign.h>
+
+/*
+ * Une mesure de la campagne
+ */
+struct campaignProbe_t {
+   struct probe_t * meanProbe;   // Un échantillon par réplication
+   struct probe_t * mergedProbe; // Tous les échantillons
+};
+
+/*
+ * La file des réplications d'un thread
+ */
+struct campaignWorker_t {
+   struct motSimCampaign_t * campaign;
+   pthread_t                 thread;
+   pthread_mutex_t           mutex;
+   int                     * replications;
+   int                       head, tail; // A exécuter : [head, tail[
+
+   int                       nbRun;      // Réplications exécutées
+   int                       nbStolen;   // dont volées
+};
+
+/*
+ * Caractéristiques d'une campagne de simulation. Une campagne sert à
+ * instancier à plusieurs reprises une même simulation.
+ */
+struct motSimCampaign_t {
+   int                nbSimulations; // Nombre d'instances de la
+				     // simulation à répliquer
+   motSimDate_t       duree;
+   motSimBuild_t      build;
+   void             * data;
+   unsigned long long seed;
+   int                antithetic;    // Réplications par paires (cf motSim_campaignSetAntithetic)
+   int                nbThreads;
+
+   // Les mesures
+   int                      nbProbes;
+   struct campaignProbe_t * probes;
+
+   // Pour chaque réplication, son contexte et ses sondes
+   // (replicationProbes[n*nbProbes + m])
+   struct motsim_t  ** contexts;
+   struct probe_t   ** replicationProbes;
+
+   // L'état final de chaque réplication (cf motSim_getStatus)
+   int               * status;
+   int                 nbUnstable;
+
+   struct campaignWorker_t * workers;
+   int                       nbWorkers;  // Threads effectivement lancés
+   time_t                    actualDuration;
+};
+
+struct motSimCampaign_t * motSim_campaignCreate(int nbSimulations,
+						motSimDate_t duree,
+						motSimBuild_t build,
+						void * data)
+{
+   struct motSimCampaign_t * result = (struct motSimCampaign_t *)sim_malloc(sizeof(struct motSimCampaign_t));
+
+   result->nbSimulations = nbSimulations;
+   result->duree = duree;
+   result->build = build;
+   result->data = data;
+   result->seed = 0;
+   result->antithetic = 0;
+   result->nbThreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+   if (result->nbThreads < 1) {
+      result->nbThreads = 1;
+   }
+
+   result->nbProbes = 0;
+   result->probes = NULL;
+   result->contexts = NULL;
+   result->replicationProbes = NULL;
+   result->status = NULL;
+   result->nbUnstable = 0;
+   result->workers = NULL;
+   result->nbWorkers = 0;
+   result->actualDuration = 0;
+
+   return result;
+}
+
+void motSim_campaignSetNbThreads(struct motSimCampaign_t * c, int nbThreads)
+{
+   assert(nbThreads > 0);
+   c->nbThreads = nbThreads;
+}
+
+void motSim_campaignSetSeed(struct motSimCampaign_t * c, unsigned long long seed)
+{
+   c->seed = seed;
+}
+
+void motSim_campaignSetAntithetic(struct motSimCampaign_t * c, int antithetic)
+{
+   c->antithetic = antithetic;
+}
+
+int motSim_campaignAddProbe(struct motSimCampaign_t * c,
+			    struct probe_t * meanProbe,
+			    struct probe_t * mergedProbe)
+{
+   assert(c->replicationProbes == NULL); // Pas en cours d'exécution
+
+   c->probes = (struct campaignProbe_t *)realloc(c->probes, (c->nbProbes + 1) * sizeof(struct campaignProbe_t));
+   assert(c->probes);
+   __totalMallocSize += sizeof(struct campaignProbe_t);
+
+   c->probes[c->nbProbes].meanProbe = meanProbe;
+   c->probes[c->nbProbes].mergedProbe = mergedProbe;
+   if (meanProbe) {
+      probe_setPersistent(meanProbe);
+   }
+   if (mergedProbe) {
+      probe_setPersistent(mergedProbe);
+   }
+
+   return c->nbProbes++;
+}
+
+void motSim_campaignSetProbe(struct motSimCampaign_t * c, int n, int m,
+			     struct probe_t * probe)
+{
+   assert((n >= 0) && (n < c->nbSimulations));
+   assert((m >= 0) && (m < c->nbProbes));
+
+   c->replicationProbes[n * c->nbProbes + m] = probe;
+}
+
+/*
+ * Exécution d'une réplication dans un nouveau contexte
+ */
+static void motSim_campaignRunReplication(struct motSimCampaign_t * c, int n)
+{
+   motSim_create();
+   if (c->antithetic) {
+      // Les deux réplications d'une paire partagent leur graine
+      motSim_setSeed(c->seed + n / 2);
+      motSim_setAntithetic(n % 2);
+   } else {
+      motSim_setSeed(c->seed + n);
+   }
+
+   c->build(c, n, c->data);
+
+   // On réinitialise tous les éléments (et on démarre les sources)
+   motSim_reset();
+   motSim_runUntil(c->duree);
+
+   c->status[n] = motSim_getStatus();
+   c->contexts[n] = motSim_setCurrentContext(NULL);
+}
+
+/*
+ * Prochaine réplication à exécuter par un thread, -1 s'il n'y en a
+ * plus nulle part
+ */
+static int motSim_campaignNextReplication(struct campaignWorker_t * w)
+{
+   struct motSimCampaign_t * c = w->campaign;
+   struct campaignWorker_t * victim;
+   int result = -1;
+   int i;
+
+   // D'abord dans sa propre file, en queue
+   pthread_mutex_lock(&w->mutex);
+   if (w->head < w->tail) {
+      result = w->replications[--w->tail];
+   }
+   pthread_mutex_unlock(&w->mutex);
+
+   // Sinon, on vole en tête de la file d'un autre
+   for (i = 1; (result < 0) && (i < c->nbWorkers); i++) {
+      victim = &c->workers[(w - c->workers + i) % c->nbWorkers];
+      pthread_mutex_lock(&victim->mutex);
+      if (victim->head < victim->tail) {
+         result = victim->replications[victim->head++];
+         w->nbStolen++;
+      }
+      pthread_mutex_unlock(&victim->mutex);
+   }
+
+   return result;
+}
+
+static void * motSim_campaignWorker(void * arg)
+{
+   struct campaignWorker_t * w = (struct campaignWorker_t *)arg;
+   int n;
+
+   while ((n = motSim_campaignNextReplication(w)) >= 0) {
+      printf_debug(DEBUG_MOTSIM, "replication %d on worker %ld\n", n, (long)(w - w->campaign->workers));
+      motSim_campaignRunReplication(w->campaign, n);
+      w->nbRun++;
+   }
+
+   return NULL;
+}
+
+/*
+ * Fusion des résultats des réplications n à n + nb - 1 dans les
+ * sondes de la campagne. La sonde des moyennes reçoit la moyenne de
+ * leurs moyennes (nb vaut 2 pour une paire antithétique).
+ */
+static void motSim_campaignMerge(struct motSimCampaign_t * c, int n, int nb)
+{
+   struct probe_t * probe;
+   double sum;
+   int m, i, k;
+
+   for (m = 0; m < c->nbProbes; m++) {
+      sum = 0.0;
+      k = 0;
+      for (i = n; i < n + nb; i++) {
+         probe = c->replicationProbes[i * c->nbProbes + m];
+         if (probe == NULL) {
+            continue;
+         }
+         if (probe_nbSamples(probe)) {
+            sum += probe_mean(probe);
+            k++;
+         }
+         if (c->probes[m].mergedProbe) {
+            probe_merge(c->probes[m].mergedProbe, probe);
+         }
+      }
+      if ((c->probes[m].meanProbe) && (k)) {
+         probe_sample(c->probes[m].meanProbe, sum / k);
+      }
+   }
+}
+
+void motSim_campaignRun(struct motSimCampaign_t * c)
+{
+   struct motsim_t * master;
+   time_t start = time(NULL);
+   int step = c->antithetic ? 2 : 1;
+   int n, t, i, nb, nbUnstable;
+
+   c->contexts = (struct motsim_t **)sim_malloc(c->nbSimulations * sizeof(struct motsim_t *));
+   if (c->status) {
+      sim_free(c->status);
+   }
+   c->status = (int *)sim_malloc(c->nbSimulations * sizeof(int));
+   c->replicationProbes = (struct probe_t **)sim_malloc(max(c->nbSimulations * c->nbProbes, 1) * sizeof(struct probe_t *));
+   for (n = 0; n < c->nbSimulations * c->nbProbes; n++) {
+      c->replicationProbes[n] = NULL;
+   }
+
+   // Répartition initiale à tour de rôle, sur au plus un thread par
+   // réplication (ceux d'un lancement précédent sont remplacés)
+   if (c->workers) {
+      sim_free(c->workers);
+   }
+   c->nbWorkers = max(min(c->nbThreads, c->nbSimulations), 1);
+   c->workers = (struct campaignWorker_t *)sim_malloc(c->nbWorkers * sizeof(struct campaignWorker_t));
+   for (t = 0; t < c->nbWorkers; t++) {
+      c->workers[t].campaign = c;
+      pthread_mutex_init(&c->workers[t].mutex, NULL);
+      c->workers[t].replications = (int *)sim_malloc((c->nbSimulations / c->nbWorkers + 1) * sizeof(int));
+      c->workers[t].head = 0;
+      c->workers[t].tail = 0;
+      c->workers[t].nbRun = 0;
+      c->workers[t].nbStolen = 0;
+   }
+   // En ordre décroissant pour que chacun commence par la plus petite
+   for (n = c->nbSimulations - 1; n >= 0; n--) {
+      t = n % c->nbWorkers;
+      c->workers[t].replications[c->workers[t].tail++] = n;
+   }
+
+   // Le thread appelant n'a plus de contexte pendant la campagne
+   master = motSim_setCurrentContext(NULL);
+
+   for (t = 0; t < c->nbWorkers; t++) {
+      if (pthread_create(&c->workers[t].thread, NULL, motSim_campaignWorker, &c->workers[t])) {
+         motSim_error(MS_FATAL, "Can't create campaign thread %d\n", t);
+      }
+   }
+   for (t = 0; t < c->nbWorkers; t++) {
+      pthread_join(c->workers[t].thread, NULL);
+   }
+
+   motSim_setCurrentContext(master);
+
+   // Fusion des résultats dans l'ordre des réplications (ou des
+   // paires), sauf ceux des réplications instables qui n'ont pas de
+   // sens. Une paire dont l'une est instable est ignorée.
+   c->nbUnstable = 0;
+   for (n = 0; n < c->nbSimulations; n += step) {
+      nb = min(step, c->nbSimulations - n);
+      nbUnstable = 0;
+      for (i = n; i < n + nb; i++) {
+         if (c->status[i] == MOTSIM_STATUS_UNSTABLE) {
+            nbUnstable++;
+         }
+      }
+      if (nbUnstable) {
+         c->nbUnstable += nbUnstable;
+      } else {
+         motSim_campaignMerge(c, n, nb);
+      }
+   }
+   for (n = 0; n < c->nbSimulations; n++) {
+      motSim_destroyContext(c->contexts[n]);
+   }
+
+   for (t = 0; t < c->nbWorkers; t++) {
+      pthread_mutex_destroy(&c->workers[t].mutex);
+      sim_free(c->workers[t].replications);
+   }
+   sim_free(c->contexts);
+   sim_free(c->replicationProbes);
+   c->contexts = NULL;
+   c->replicationProbes = NULL;
+
+   c->actualDuration = time(NULL) - start;
+}
+
+void motSim_campaignPrintStatus(struct motSimCampaign_t * c)
+{
+   int t, m;
+
+   printf("[CAMPA] %d replications of %f on %d threads%s\n",
+	  c->nbSimulations, motSim_dateToSeconds(c->duree),
+	  c->workers ? c->nbWorkers : c->nbThreads,
+	  c->antithetic ? " (antithetic pairs)" : "");
+   if (c->workers) {
+      for (t = 0; t < c->nbWorkers; t++) {
+	 printf("[CAMPA] Thread %d : %d replications (%d stolen)\n",
+		t, c->workers[t].nbRun, c->workers[t].nbStolen);
+      }
+   }
+   for (m = 0; m < c->nbProbes; m++) {
+      if ((c->probes[m].meanProbe) && (probe_nbSamples(c->probes[m].meanProbe))) {
+	 printf("[CAMPA] \"%s\" : %f", probe_getName(c->probes[m].meanProbe),
+		probe_mean(c->probes[m].meanProbe));
+	 if ((probe_getType(c->probes[m].meanProbe) == exhaustiveProbeType)
+	     && (probe_nbSamples(c->probes[m].meanProbe) > 1)) {
+	    printf(" +/- %f", probe_demiIntervalleConfiance5pc(c->probes[m].meanProbe));
+	 }
+	 printf("\n");
+      }
+   }
+   if (c->nbUnstable) {
+      printf("[CAMPA] %d unstable replications ignored\n", c->nbUnstable);
+   }
+   printf("[CAMPA] Realtime duration : %ld sec\n", (long)c->actualDuration);
+}
+
+int motSim_campaignGetStatus(struct motSimCampaign_t * c, int n)
+{
+   assert((c->status) && (n >= 0) && (n < c->nbSimulations));
+
+   return c->status[n];
+}
+
+int motSim_campaignNbUnstable(struct motSimCampaign_t * c)
+{
+   return c->nbUnstable;
+}
@@ -0,0 +1,883 @@
+/**
+ * @file checkpoint.c
+ * @brief Sauvegarde et restauration de l'état d'une simulation
+ *
+ * Un fichier de sauvegarde contient, dans l'ordre :
+ *  - un en-tête : magique, version du format, représentation des
+ * dates, nom et version du modèle ;
+ *  - la signature du modèle : le nom de chaque client, dans l'ordre
+ * d'enregistrement, puis celui de chaque fonction ;
+ *  - l'état du moteur (horloge et compteurs) ;
+ *  - l'état de chaque client, précédé de son numéro et de sa taille ;
+ *  - les événements en attente, dans l'ordre où ils seront exécutés ;
+ *  - une marque de fin.
+ *
+ * Le fichier est entièrement vérifié avant de modifier quoi que ce
+ * soit : en-tête, numéro et taille de chaque client (grâce à laquelle
+ * son état est sauté), fonction, client et date de chaque événement,
+ * marque de fin. Seul le contenu de l'état d'un client n'est relu
+ * qu'en l'appliquant.
+ *
+ * Une PDU n'est écrite qu'à sa première référence, les suivantes se
+ * contentent de son numéro dans le fichier. A la sauvegarde, les
+ * numéros des PDU et des clients sont retrouvés par des tables de
+ * hachage (adressage ouvert) indexées par leur adresse, à la
+ * restauration par de simples tableaux.
+ *
+ * Pour être sauvegardés dans l'ordre, les événements en attente sont
+ * extraits puis réinsérés tels quels : ils gardent leur identifiant,
+ * les poignées restent donc valables.
+ */
+#include <stdio.h>     // fopen, fwrite, ...
+#include <stdlib.h>    // realloc, free
+#include <string.h>    // strcmp, strdup, memset
+#include <stdint.h>    // uint32_t, intptr_t
+
+#include <checkpoint.h>
+#include <motsim-context.h>
+#include <event.h>
+#include <pdu.h>
+
+#define CHECKPOINT_MAGIC       "NDESCKPT"
+#define CHECKPOINT_END         "NDESEND"
+#define CHECKPOINT_BUFFER_SIZE (1 << 20)
+
+struct checkpointClient_t {
+   const char * name;
+   void       * data;
+   size_t       size;   // Bloc sauvegardé tel quel si save == NULL
+   void (*save)(struct checkpoint_t * cp, void * data);
+   void (*restore)(struct checkpoint_t * cp, void * data);
+
+   struct checkpointClient_t * next;
+};
+
+struct checkpointFunction_t {
+   const char * name;
+   void (*function)();
+};
+
+/*
+ * Ce qui est enregistré dans le contexte
+ */
+struct checkpointList_t {
+   struct checkpointClient_t   * first;
+   struct checkpointClient_t   * last;
+   int                           nbClients;
+   struct checkpointFunction_t * functions;
+   int                           nbFunctions;
+   int                           maxFunctions;
+   char                        * modelName;
+   int                           modelVersion;
+};
+
+/*
+ * Une table adresse -> numéro
+ */
+struct checkpointMap_t {
+   void         ** keys;
+   long          * values;
+   unsigned long   size;  // Toujours une puissance de 2
+   unsigned long   nb;
+};
+
+struct checkpoint_t {
+   FILE                    * file;
+   int                       error;
+   struct checkpointList_t * list;
+
+   // Sauvegarde
+   struct checkpointMap_t    clients;
+   struct checkpointMap_t    pdus;
+
+   // Restauration
+   void                   ** clientTable;
+   struct PDU_t           ** pduTable;
+   long                      nbPDU;
+   long                      maxPDU;
+};
+
+/*
+ * Ce qui est sauvegardé du moteur
+ */
+struct checkpointEngine_t {
+   motSimDate_t       currentTime;
+   motSimDate_t       finishTime;
+   int                nbInsertedEvents;
+   int                nbRanEvents;
+   unsigned long      nbBatches;
+   unsigned long long pduNB;
+   int                ndesObject_nb;
+   int                rngSeeded;
+   unsigned long long rngSeed;
+   unsigned long      rngNbStreams;
+   int                rngAntithetic;
+};
+
+/*
+ * Ce qui est sauvegardé d'un événement, outre sa fonction et son
+ * paramètre
+ */
+struct checkpointEvent_t {
+   motSimDate_t     date;
+   motSimDate_t     period;
+   int              type;
+   union eventArg_t args[EVENT_NB_ARGS];
+};
+
+/*==========================================================================*/
+/*      Les enregistrements                                                 */
+/*==========================================================================*/
+
+static struct checkpointList_t * checkpoint_getList()
+{
+   if (__motSim->checkpoint == NULL) {
+      __motSim->checkpoint = (struct checkpointList_t *)sim_malloc(sizeof(struct checkpointList_t));
+      memset(__motSim->checkpoint, 0, sizeof(struct checkpointList_t));
+   }
+   return __motSim->checkpoint;
+}
+
+static void checkpoint_addClient(void * data, const char * name, size_t size,
+				 void (*save)(struct checkpoint_t * cp, void * data),
+				 void (*restore)(struct checkpoint_t * cp, void * data))
+{
+   struct checkpointList_t   * list = checkpoint_getList();
+   struct checkpointClient_t * client = (struct checkpointClient_t *)sim_malloc(sizeof(struct checkpointClient_t));
+
+   client->name = name;
+   client->data = data;
+   client->size = size;
+   client->save = save;
+   client->restore = restore;
+   client->next = NULL;
+
+   // Dans l'ordre d'enregistrement
+   if (list->last) {
+      list->last->next = client;
+   } else {
+      list->first = client;
+   }
+   list->last = client;
+   list->nbClients++;
+}
+
+void motSim_addToCheckpointList(void * data, const char * name,
+				void (*save)(struct checkpoint_t * cp, void * data),
+				void (*restore)(struct checkpoint_t * cp, void * data))
+{
+   checkpoint_addClient(data, name, 0, save, restore);
+}
+
+void motSim_addBlockToCheckpointList(void * data, const char * name, size_t size)
+{
+   checkpoint_addClient(data, name, size, NULL, NULL);
+}
+
+void checkpoint_addFunction(const char * name, void (*function)())
+{
+   struct checkpointList_t * list = checkpoint_getList();
+   int n;
+
+   for (n = 0; n < list->nbFunctions; n++) {
+      if (list->functions[n].function == function) {
+	 return;
+      }
+   }
+
+   if (list->nbFunctions == list->maxFunctions) {
+      list->maxFunctions = list->maxFunctions ? 2 * list->maxFunctions : 16;
+      list->functions = (struct checkpointFunction_t *)realloc(list->functions,
+							       list->maxFunctions * sizeof(struct checkpointFunction_t));
+   }
+   list->functions[list->nbFunctions].name = name;
+   list->functions[list->nbFunctions].function = function;
+   list->nbFunctions++;
+}
+
+void motSim_setModelVersion(const char * name, int version)
+{
+   struct checkpointList_t * list = checkpoint_getList();
+
+   free(list->modelName);
+   list->modelName = strdup(name);
+   list->modelVersion = version;
+}
+
+void checkpoint_free(struct motsim_t * ctx)
+{
+   struct checkpointList_t   * list = ctx->checkpoint;
+   struct checkpointClient_t * client;
+
+   if (list == NULL) {
+      return;
+   }
+   while ((client = list->first) != NULL) {
+      list->first = client->next;
+      sim_free(client);
+   }
+   free(list->functions);
+   free(list->modelName);
+   sim_free(list);
+   ctx->checkpoint = NULL;
+}
+
+/*==========================================================================*/
+/*      Les tables adresse -> numéro                                        */
+/*==========================================================================*/
+
+static inline unsigned long checkpoint_hash(void * key, unsigned long size)
+{
+   return (((uintptr_t)key >> 4) * 0x9E3779B97F4A7C15ULL) & (size - 1);
+}
+
+static void checkpoint_mapInit(struct checkpointMap_t * map)
+{
+   map->keys = NULL;
+   map->values = NULL;
+   map->size = 0;
+   map->nb = 0;
+}
+
+static void checkpoint_mapFree(struct checkpointMap_t * map)
+{
+   free(map->keys);
+   free(map->values);
+   checkpoint_mapInit(map);
+}
+
+static long checkpoint_mapLookup(struct checkpointMap_t * map, void * key)
+{
+   unsigned long i;
+
+   if (map->size == 0) {
+      return -1;
+   }
+   for (i = checkpoint_hash(key, map->size); map->keys[i]; i = (i + 1) & (map->size - 1)) {
+      if (map->keys[i] == key) {
+	 return map->values[i];
+      }
+   }
+   return -1;
+}
+
+static void checkpoint_mapInsert(struct checkpointMap_t * map, void * key, long value)
+{
+   struct checkpointMap_t old = *map;
+   unsigned long i;
+
+   // Au plus à moitié pleine
+   if (2 * (map->nb + 1) > map->size) {
+      map->size = map->size ? 2 * map->size : 1024;
+      map->keys = (void **)calloc(map->size, sizeof(void *));
+      map->values = (long *)malloc(map->size * sizeof(long));
+      map->nb = 0;
+      for (i = 0; i < old.size; i++) {
+	 if (old.keys[i]) {
+	    checkpoint_mapInsert(map, old.keys[i], old.values[i]);
+	 }
+      }
+      free(old.keys);
+      free(old.values);
+   }
+
+   for (i = checkpoint_hash(key, map->size); map->keys[i]; i = (i + 1) & (map->size - 1));
+   map->keys[i] = key;
+   map->values[i] = value;
+   map->nb++;
+}
+
+/*==========================================================================*/
+/*      Les lectures et écritures                                           */
+/*==========================================================================*/
+
+void checkpoint_setError(struct checkpoint_t * cp)
+{
+   cp->error = 1;
+}
+
+void checkpoint_write(struct checkpoint_t * cp, const void * data, size_t size)
+{
+   if ((!cp->error) && (fwrite(data, 1, size, cp->file) != size)) {
+      cp->error = 1;
+   }
+}
+
+void checkpoint_read(struct checkpoint_t * cp, void * data, size_t size)
+{
+   if ((cp->error) || (fread(data, 1, size, cp->file) != size)) {
+      cp->error = 1;
+      memset(data, 0, size);
+   }
+}
+
+static void checkpoint_writeInt(struct checkpoint_t * cp, int32_t value)
+{
+   checkpoint_write(cp, &value, sizeof(value));
+}
+
+static int32_t checkpoint_readInt(struct checkpoint_t * cp)
+{
+   int32_t value;
+
+   checkpoint_read(cp, &value, sizeof(value));
+   return value;
+}
+
+static void checkpoint_writeString(struct checkpoint_t * cp, const char * s)
+{
+   int32_t len = s ? strlen(s) : 0;
+
+   checkpoint_writeInt(cp, len);
+   checkpoint_write(cp, s, len);
+}
+
+/*
+ * Comparaison de la prochaine chaîne du fichier avec s (NULL
+ * équivaut à une chaîne vide). Renvoie 0 si elles sont identiques.
+ */
+static int checkpoint_compareString(struct checkpoint_t * cp, const char * s)
+{
+   int32_t len = checkpoint_readInt(cp);
+   char    buffer[256];
+   int     result = (len != (s ? strlen(s) : 0));
+   int32_t n;
+
+   while ((len > 0) && (!cp->error)) {
+      n = (len < sizeof(buffer)) ? len : sizeof(buffer);
+      checkpoint_read(cp, buffer, n);
+      result = result || memcmp(buffer, s, n);
+      s += result ? 0 : n;
+      len -= n;
+   }
+   return result || cp->error;
+}
+
+void checkpoint_writeObject(struct checkpoint_t * cp, void * data)
+{
+   long n = -1;
+
+   if ((data) && ((n = checkpoint_mapLookup(&cp->clients, data)) < 0)) {
+      motSim_error(MS_WARN, "%p n'est pas un client de la sauvegarde", data);
+      cp->error = 1;
+   }
+   checkpoint_writeInt(cp, n);
+}
+
+void * checkpoint_readObject(struct checkpoint_t * cp)
+{
+   int32_t n = checkpoint_readInt(cp);
+
+   if ((n < -1) || (n >= cp->list->nbClients)) {
+      cp->error = 1;
+   }
+   return ((n < 0) || (cp->error)) ? NULL : cp->clientTable[n];
+}
+
+void checkpoint_writeFunction(struct checkpoint_t * cp, void (*function)())
+{
+   int n = -1;
+
+   if (function) {
+      for (n = cp->list->nbFunctions - 1; n >= 0; n--) {
+	 if (cp->list->functions[n].function == function) {
+	    break;
+	 }
+      }
+      if (n < 0) {
+	 motSim_error(MS_WARN, "fonction %p non enregistrée (cf checkpoint_registerFunction)", function);
+	 cp->error = 1;
+      }
+   }
+   checkpoint_writeInt(cp, n);
+}
+
+void (*checkpoint_readFunction(struct checkpoint_t * cp))()
+{
+   int32_t n = checkpoint_readInt(cp);
+
+   if ((n < -1) || (n >= cp->list->nbFunctions)) {
+      cp->error = 1;
+   }
+   return ((n < 0) || (cp->error)) ? NULL : cp->list->functions[n].function;
+}
+
+void checkpoint_writePDU(struct checkpoint_t * cp, struct PDU_t * pdu)
+{
+   long         n = -1;
+   uint64_t     id;
+   int32_t      size;
+   motSimDate_t date;
+   intptr_t     private;
+
+   if (pdu == NULL) {
+      checkpoint_writeInt(cp, -1);
+      return;
+   }
+
+   // Déjà écrite ?
+   if ((n = checkpoint_mapLookup(&cp->pdus, pdu)) >= 0) {
+      checkpoint_writeInt(cp, n);
+      return;
+   }
+
+   n = cp->pdus.nb;
+   checkpoint_mapInsert(&cp->pdus, pdu, n);
+   checkpoint_writeInt(cp, n);
+
+   id = PDU_getId(pdu);
+   size = PDU_size(pdu);
+   date = PDU_getCreationDate(pdu);
+   private = (intptr_t)PDU_private(pdu);
+   checkpoint_write(cp, &id, sizeof(id));
+   checkpoint_write(cp, &size, sizeof(size));
+   checkpoint_write(cp, &date, sizeof(date));
+   checkpoint_write(cp, &private, sizeof(private));
+}
+
+struct PDU_t * checkpoint_readPDU(struct checkpoint_t * cp)
+{
+   int32_t      n = checkpoint_readInt(cp);
+   uint64_t     id;
+   int32_t      size;
+   motSimDate_t date;
+   intptr_t     private;
+
+   if ((cp->error) || (n < 0)) {
+      return NULL;
+   }
+   if (n < cp->nbPDU) {
+      return cp->pduTable[n];
+   }
+   if (n > cp->nbPDU) {
+      cp->error = 1;
+      return NULL;
+   }
+
+   checkpoint_read(cp, &id, sizeof(id));
+   checkpoint_read(cp, &size, sizeof(size));
+   checkpoint_read(cp, &date, sizeof(date));
+   checkpoint_read(cp, &private, sizeof(private));
+   if (cp->error) {
+      return NULL;
+   }
+
+   if (cp->nbPDU == cp->maxPDU) {
+      cp->maxPDU = cp->maxPDU ? 2 * cp->maxPDU : 1024;
+      cp->pduTable = (struct PDU_t **)realloc(cp->pduTable, cp->maxPDU * sizeof(struct PDU_t *));
+   }
+   cp->pduTable[cp->nbPDU] = PDU_restore(size, (void *)private, id, date);
+
+   return cp->pduTable[cp->nbPDU++];
+}
+
+/*
+ * L'état d'un client est précédé de sa taille, écrite une fois qu'il
+ * est complet. Renvoie la position du début de l'état.
+ */
+static long checkpoint_beginBlock(struct checkpoint_t * cp)
+{
+   int64_t size = 0;
+   long    start;
+
+   checkpoint_write(cp, &size, sizeof(size));
+   if ((start = ftell(cp->file)) < 0) {
+      cp->error = 1;
+   }
+   return start;
+}
+
+static void checkpoint_endBlock(struct checkpoint_t * cp, long start)
+{
+   long    end = ftell(cp->file);
+   int64_t size = end - start;
+
+   if ((cp->error) || (end < 0)
+       || (fseek(cp->file, start - (long)sizeof(size), SEEK_SET))
+       || (fwrite(&size, 1, sizeof(size), cp->file) != sizeof(size))
+       || (fseek(cp->file, end, SEEK_SET))) {
+      cp->error = 1;
+   }
+}
+
+/*==========================================================================*/
+/*      L'en-tête                                                           */
+/*==========================================================================*/
+
+static void checkpoint_init(struct checkpoint_t * cp, FILE * file)
+{
+   memset(cp, 0, sizeof(struct checkpoint_t));
+   cp->file = file;
+   cp->list = checkpoint_getList();
+   checkpoint_mapInit(&cp->clients);
+   checkpoint_mapInit(&cp->pdus);
+   setvbuf(file, NULL, _IOFBF, CHECKPOINT_BUFFER_SIZE);
+}
+
+static void checkpoint_writeHeader(struct checkpoint_t * cp)
+{
+   struct checkpointClient_t * client;
+   int n;
+
+   checkpoint_write(cp, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+   checkpoint_writeInt(cp, CHECKPOINT_FORMAT_VERSION);
+   checkpoint_writeInt(cp, sizeof(motSimDate_t));
+   checkpoint_writeInt(cp, motSim_secondsToDate(1.0) != (motSimDate_t)1);
+
+   checkpoint_writeString(cp, cp->list->modelName);
+   checkpoint_writeInt(cp, cp->list->modelVersion);
+
+   checkpoint_writeInt(cp, cp->list->nbClients);
+   for (client = cp->list->first; client; client = client->next) {
+      checkpoint_writeString(cp, client->name);
+   }
+   checkpoint_writeInt(cp, cp->list->nbFunctions);
+   for (n = 0; n < cp->list->nbFunctions; n++) {
+      checkpoint_writeString(cp, cp->list->functions[n].name);
+   }
+}
+
+/*
+ * Vérification de l'en-tête. Renvoie 0 si le fichier est compatible
+ */
+static int checkpoint_checkHeader(struct checkpoint_t * cp, const char * fileName)
+{
+   struct checkpointClient_t * client;
+   char    magic[sizeof(CHECKPOINT_MAGIC)];
+   int32_t version;
+   int     n;
+
+   checkpoint_read(cp, magic, sizeof(magic));
+   if ((cp->error) || (memcmp(magic, CHECKPOINT_MAGIC, sizeof(magic)))) {
+      motSim_error(MS_WARN, "%s n'est pas une sauvegarde", fileName);
+      return 1;
+   }
+   if ((version = checkpoint_readInt(cp)) != CHECKPOINT_FORMAT_VERSION) {
+      motSim_error(MS_WARN, "%s : format %d au lieu de %d", fileName, version, CHECKPOINT_FORMAT_VERSION);
+      return 1;
+   }
+   if ((checkpoint_readInt(cp) != sizeof(motSimDate_t))
+       || (checkpoint_readInt(cp) != (motSim_secondsToDate(1.0) != (motSimDate_t)1))) {
+      motSim_error(MS_WARN, "%s : représentation des dates différente", fileName);
+      return 1;
+   }
+
+   if ((checkpoint_compareString(cp, cp->list->modelName))
+       || (checkpoint_readInt(cp) != cp->list->modelVersion)) {
+      motSim_error(MS_WARN, "%s : modèle différent de \"%s\" version %d", fileName,
+		   cp->list->modelName ? cp->list->modelName : "", cp->list->modelVersion);
+      return 1;
+   }
+
+   if (checkpoint_readInt(cp) != cp->list->nbClients) {
+      motSim_error(MS_WARN, "%s : nombre de clients différent", fileName);
+      return 1;
+   }
+   for (client = cp->list->first, n = 0; client; client = client->next, n++) {
+      if (checkpoint_compareString(cp, client->name)) {
+	 motSim_error(MS_WARN, "%s : client %d différent de \"%s\"", fileName, n, client->name);
+	 return 1;
+      }
+   }
+   if (checkpoint_readInt(cp) != cp->list->nbFunctions) {
+      motSim_error(MS_WARN, "%s : nombre de fonctions différent", fileName);
+      return 1;
+   }
+   for (n = 0; n < cp->list->nbFunctions; n++) {
+      if (checkpoint_compareString(cp, cp->list->functions[n].name)) {
+	 motSim_error(MS_WARN, "%s : fonction %d différente de %s", fileName, n,
+		      cp->list->functions[n].name);
+	 return 1;
+      }
+   }
+
+   return cp->error;
+}
+
+/*==========================================================================*/
+/*      Sauvegarde                                                          */
+/*==========================================================================*/
+
+int motSim_checkpoint(const char * fileName)
+{
+   struct checkpoint_t         cp;
+   struct checkpointClient_t * client;
+   struct checkpointEngine_t   engine;
+   struct checkpointEvent_t    saved;
+   struct event_t           ** events = NULL;
+   struct event_t            * event;
+   long                        nbEvents = 0, maxEvents = 0, n, start;
+   int                         profiling = __motSim->profiling;
+   FILE                      * file;
+
+   if ((__motSim->runningEvent) || (__motSim->batch) || (__motSim->pdesLP)) {
+      motSim_error(MS_WARN, "sauvegarde impossible pendant une exécution");
+      return 1;
+   }
+   if ((file = fopen(fileName, "wb")) == NULL) {
+      motSim_error(MS_WARN, "impossible de créer %s", fileName);
+      return 1;
+   }
+   checkpoint_init(&cp, file);
+
+   checkpoint_writeHeader(&cp);
+
+   engine.currentTime = __motSim->currentTime;
+   engine.finishTime = __motSim->finishTime;
+   engine.nbInsertedEvents = __motSim->nbInsertedEvents;
+   engine.nbRanEvents = __motSim->nbRanEvents;
+   engine.nbBatches = __motSim->nbBatches;
+   engine.pduNB = __motSim->pduNB;
+   engine.ndesObject_nb = __motSim->ndesObject_nb;
+   engine.rngSeeded = __motSim->rngSeeded;
+   engine.rngSeed = __motSim->rngSeed;
+   engine.rngNbStreams = __motSim->rngNbStreams;
+   engine.rngAntithetic = __motSim->rngAntithetic;
+   checkpoint_write(&cp, &engine, sizeof(engine));
+
+   // Les clients
+   for (client = cp.list->first, n = 0; client; client = client->next, n++) {
+      checkpoint_mapInsert(&cp.clients, client->data, n);
+   }
+   for (client = cp.list->first, n = 0; client; client = client->next, n++) {
+      checkpoint_writeInt(&cp, n);
+      start = checkpoint_beginBlock(&cp);
+      if (client->save) {
+	 client->save(&cp, client->data);
+      } else {
+	 checkpoint_write(&cp, client->data, client->size);
+      }
+      checkpoint_endBlock(&cp, start);
+   }
+
+   // Les événements, extraits dans l'ordre puis réinsérés
+   while ((event = motSim_extractEvent()) != NULL) {
+      if (nbEvents == maxEvents) {
+	 maxEvents = maxEvents ? 2 * maxEvents : 1024;
+	 events = (struct event_t **)realloc(events, maxEvents * sizeof(struct event_t *));
+      }
+      events[nbEvents++] = event;
+   }
+   checkpoint_write(&cp, &nbEvents, sizeof(nbEvents));
+   __motSim->profiling = 0;
+   for (n = 0; n < nbEvents; n++) {
+      event = events[n];
+      memset(&saved, 0, sizeof(saved));
+      saved.date = event->date;
+      saved.period = event->period;
+      saved.type = event->type & (EVENT_PERIODIC | EVENT_TIMER);
+      memcpy(saved.args, event->args, sizeof(saved.args));
+      checkpoint_writeFunction(&cp, (void (*)())event->run);
+      checkpoint_writeObject(&cp, event->data);
+      checkpoint_write(&cp, &saved, sizeof(saved));
+
+      motSim_addEvent(event);
+   }
+   __motSim->profiling = profiling;
+   __motSim->nbInsertedEvents = engine.nbInsertedEvents;
+   free(events);
+
+   checkpoint_write(&cp, CHECKPOINT_END, sizeof(CHECKPOINT_END));
+
+   checkpoint_mapFree(&cp.clients);
+   checkpoint_mapFree(&cp.pdus);
+   if ((fclose(file)) || (cp.error)) {
+      motSim_error(MS_WARN, "échec de la sauvegarde dans %s", fileName);
+      remove(fileName);
+      return 1;
+   }
+
+   return 0;
+}
+
+/*==========================================================================*/
+/*      Restauration                                                        */
+/*==========================================================================*/
+
+/*
+ * Vérification de ce qui suit l'état du moteur, sans rien modifier.
+ * Renvoie 0 si le fichier est complet et cohérent.
+ */
+static int checkpoint_checkBody(struct checkpoint_t * cp, const char * fileName,
+				motSimDate_t currentTime)
+{
+   struct checkpointClient_t * client;
+   struct checkpointEvent_t    saved;
+   char                        end[sizeof(CHECKPOINT_END)];
+   long                        position, fileSize, nbEvents, n;
+   int64_t                     size;
+
+   if (((position = ftell(cp->file)) < 0)
+       || (fseek(cp->file, 0, SEEK_END))
+       || ((fileSize = ftell(cp->file)) < 0)
+       || (fseek(cp->file, position, SEEK_SET))) {
+      motSim_error(MS_WARN, "%s : fichier illisible", fileName);
+      return 1;
+   }
+
+   // Les clients, dont l'état est sauté
+   for (client = cp->list->first, n = 0; client; client = client->next, n++) {
+      if (checkpoint_readInt(cp) != n) {
+	 cp->error = 1;
+      }
+      checkpoint_read(cp, &size, sizeof(size));
+      if ((cp->error)
+	  || ((position = ftell(cp->file)) < 0)
+	  || (size < 0) || (size > fileSize - position)
+	  || ((client->restore == NULL) && (size != client->size))
+	  || (fseek(cp->file, size, SEEK_CUR))) {
+	 motSim_error(MS_WARN, "%s : état du client %ld (\"%s\") incorrect", fileName, n, client->name);
+	 return 1;
+      }
+   }
+
+   // Les événements
+   checkpoint_read(cp, &nbEvents, sizeof(nbEvents));
+   for (n = 0; (n < nbEvents) && (!cp->error); n++) {
+      if ((checkpoint_readFunction(cp) == NULL) && (!cp->error)) {
+	 cp->error = 1;
+      }
+      checkpoint_readObject(cp);
+      checkpoint_read(cp, &saved, sizeof(saved));
+      if ((cp->error) || (saved.date < currentTime)) {
+	 motSim_error(MS_WARN, "%s : événement %ld incorrect", fileName, n);
+	 return 1;
+      }
+   }
+
+   checkpoint_read(cp, end, sizeof(end));
+   if ((cp->error) || (memcmp(end, CHECKPOINT_END, sizeof(end)))) {
+      motSim_error(MS_WARN, "%s : fichier tronqué", fileName);
+      return 1;
+   }
+
+   return 0;
+}
+
+int motSim_restore(const char * fileName)
+{
+   struct checkpoint_t         cp;
+   struct checkpointClient_t * client;
+   struct checkpointEngine_t   engine;
+   struct checkpointEvent_t    saved;
+   struct probe_t            * systemProbes[4];
+   struct event_t            * event;
+   void                     (* run)();
+   void                      * data;
+   char                        end[sizeof(CHECKPOINT_END)];
+   long                        nbEvents, n, body, start;
+   int64_t                     size;
+   FILE                      * file;
+
+   if ((__motSim->runningEvent) || (__motSim->batch) || (__motSim->pdesLP)) {
+      motSim_error(MS_WARN, "restauration impossible pendant une exécution");
+      return 1;
+   }
+   if ((file = fopen(fileName, "rb")) == NULL) {
+      motSim_error(MS_WARN, "impossible d'ouvrir %s", fileName);
+      return 1;
+   }
+   checkpoint_init(&cp, file);
+
+   if (checkpoint_checkHeader(&cp, fileName)) {
+      fclose(file);
+      return 1;
+   }
+   checkpoint_read(&cp, &engine, sizeof(engine));
+   body = ftell(file);
+
+   cp.clientTable = (void **)malloc((cp.list->nbClients + 1) * sizeof(void *));
+   for (client = cp.list->first, n = 0; client; client = client->next, n++) {
+      cp.clientTable[n] = client->data;
+   }
+
+   // Tout est vérifié avant de toucher au contexte
+   if ((cp.error) || (body < 0)) {
+      motSim_error(MS_WARN, "%s : fichier tronqué", fileName);
+      cp.error = 1;
+   }
+   if ((cp.error)
+       || (checkpoint_checkBody(&cp, fileName, engine.currentTime))
+       || (fseek(file, body, SEEK_SET))) {
+      free(cp.clientTable);
+      fclose(file);
+      return 1;
+   }
+
+   // Les PDU recréées ou libérées ne doivent pas apparaître dans les
+   // sondes système, qui sont restaurées comme les autres
+   systemProbes[0] = __motSim->PDU_createProbe;
+   systemProbes[1] = __motSim->PDU_reuseProbe;
+   systemProbes[2] = __motSim->PDU_mallocProbe;
+   systemProbes[3] = __motSim->PDU_releaseProbe;
+   __motSim->PDU_createProbe = __motSim->PDU_reuseProbe = NULL;
+   __motSim->PDU_mallocProbe = __motSim->PDU_releaseProbe = NULL;
+
+   // Les événements en attente sont remplacés
+   motSim_purge();
+   __motSim->currentTime = engine.currentTime;
+
+   // Les clients, chacun doit relire exactement ce qu'il a écrit
+   for (client = cp.list->first, n = 0; (client) && (!cp.error); client = client->next, n++) {
+      checkpoint_readInt(&cp);
+      checkpoint_read(&cp, &size, sizeof(size));
+      start = ftell(file);
+      if (client->restore) {
+	 client->restore(&cp, client->data);
+      } else {
+	 checkpoint_read(&cp, client->data, client->size);
+      }
+      if (ftell(file) != start + size) {
+	 cp.error = 1;
+      }
+   }
+
+   // Les événements, dans l'ordre
+   checkpoint_read(&cp, &nbEvents, sizeof(nbEvents));
+   for (n = 0; (n < nbEvents) && (!cp.error); n++) {
+      run = checkpoint_readFunction(&cp);
+      data = checkpoint_readObject(&cp);
+      checkpoint_read(&cp, &saved, sizeof(saved));
+      if ((cp.error) || (run == NULL) || (saved.date < engine.currentTime)) {
+	 cp.error = 1;
+	 break;
+      }
+      event = event_create((void (*)(void *))run, data, saved.date);
+      event->type = saved.type;
+      event->period = saved.period;
+      memcpy(event->args, saved.args, sizeof(saved.args));
+      motSim_addEvent(event);
+   }
+
+   checkpoint_read(&cp, end, sizeof(end));
+   if (memcmp(end, CHECKPOINT_END, sizeof(end))) {
+      cp.error = 1;
+   }
+
+   __motSim->PDU_createProbe = systemProbes[0];
+   __motSim->PDU_reuseProbe = systemProbes[1];
+   __motSim->PDU_mallocProbe = systemProbes[2];
+   __motSim->PDU_releaseProbe = systemProbes[3];
+
+   __motSim->finishTime = engine.finishTime;
+   __motSim->nbInsertedEvents = engine.nbInsertedEvents;
+   __motSim->nbRanEvents = engine.nbRanEvents;
+   __motSim->nbBatches = engine.nbBatches;
+   __motSim->pduNB = engine.pduNB;
+   __motSim->ndesObject_nb = engine.ndesObject_nb;
+   __motSim->rngSeeded = engine.rngSeeded;
+   __motSim->rngSeed = engine.rngSeed;
+   __motSim->rngNbStreams = engine.rngNbStreams;
+   __motSim->rngAntithetic = engine.rngAntithetic;
+
+   free(cp.clientTable);
+   free(cp.pduTable);
+   fclose(file);
+
+   // Le fichier a été vérifié, seul l'état d'un client peut encore être
+   // incohérent, et le contexte est alors en partie restauré
+   if (cp.error) {
+      motSim_error(MS_FATAL, "%s : restauration incomplète, contexte inutilisable", fileName);
+   }
+   return 0;
+}
@@ -12,6 +12,7 @@
 #include <random-generator.h>  
 
 #include <date-generator.h>  
+#include <checkpoint.h>
 
 /**
  * @brief Implantation des générateurs de dates.
@@ -30,6 +31,7 @@ struct dateGenerator_t {
    struct probe_t * interArrivalProbe;
 
    motSimDate_t lastDate; //!< Dernière date générée
+   motSimDate_t startDate; //!< Valeur initiale de lastDate (cf dateGenerator_rewind)
 };
 
 /*-------------------------------------------------------------------------*/
@@ -55,6 +57,10 @@ struct dateGenerator_t * dateGenerator_create()
   result->randGen = NULL;
   dateGenerator_setStartDate(result, motSim_getCurrentTime());
 
+  // Seule la dernière date est à sauvegarder, le générateur
+  // aléatoire l'est pour son propre compte
+  motSim_addBlockToCheckpointList(&result->lastDate, "dateGenerator", sizeof(motSimDate_t));
+
   printf_debug(DEBUG_GENE, "OUT %p\n", result);
   return result;
 }
@@ -99,9 +105,18 @@ void dateGenerator_setStartDate(struct dateGenerator_t * dateGen,
    // A trick to ensure a periodic dateGenerator will start at date
    if ((dateGen->randGen) && (dateGenerator_isPeriodic(dateGen))) {
       printf_debug(DEBUG_GENE, "%p is periodic\n", dateGen);
-      dateGen->lastDate -= randomGenerator_getNextDouble(dateGen->randGen);
+      dateGen->lastDate -= motSim_secondsToDate(randomGenerator_getNextDouble(dateGen->randGen));
    }
-   printf_debug(DEBUG_GENE, "OUT (lastDate %lf)\n", dateGen->lastDate);
+   dateGen->startDate = dateGen->lastDate;
+   printf_debug(DEBUG_GENE, "OUT (lastDate %lf)\n", motSim_dateToSeconds(dateGen->lastDate));
+}
+
+/*
+ * Retour à la date de démarrage, pour une nouvelle simulation
+ */
+void dateGenerator_rewind(struct dateGenerator_t * dateGen)
+{
+   dateGen->lastDate = dateGen->startDate;
 }
 
 /**
@@ -123,7 +138,7 @@ void dateGenerator_setRandomGenerator(struct dateGenerator_t * dateGen,
  * @param dateGen le générateur à utiliser
  * @param currentTime la date actuelle
  */
-double dateGenerator_nextDate(struct dateGenerator_t * dateGen)
+motSimDate_t dateGenerator_nextDate(struct dateGenerator_t * dateGen)
 {
    double result =  randomGenerator_getNextDouble(dateGen->randGen);
 
@@ -132,7 +147,7 @@ double dateGenerator_nextDate(struct dateGenerator_t * dateGen)
       printf_debug(DEBUG_GENE, " Mean = %6.3f\n", probe_mean(dateGen->interArrivalProbe));
    }
 
-   dateGen->lastDate += result;
+   dateGen->lastDate += motSim_secondsToDate(result);
 
    return dateGen->lastDate;
 }
@@ -13,6 +13,7 @@
 #include <event.h>
 
 #include <dvb-s2-ll.h>
+#include <checkpoint.h>
 
 /*
  * Caractérisation d'un MODCOD
@@ -62,6 +63,33 @@ void DVBS2ll_reset(struct DVBS2ll_t * dvbs2ll)
    dvbs2ll->available = 1;
 }
 
+struct PDU_t * DVBS2ll_getPDU(struct DVBS2ll_t * dvbs2ll);
+void DVBS2ll_endTransmission(struct DVBS2ll_t * dvbs2ll);
+
+/*
+ * Sauvegarde de la trame en cours d'émission (cf checkpoint.h). Le
+ * MODCOD d'une PDU est dans son champ privé, il est sauvegardé avec
+ * elle.
+ */
+static void DVBS2ll_checkpointSave(struct checkpoint_t * cp, void * data)
+{
+   struct DVBS2ll_t * dvbs2ll = (struct DVBS2ll_t *)data;
+
+   checkpoint_write(cp, &dvbs2ll->available, sizeof(dvbs2ll->available));
+   checkpoint_writePDU(cp, dvbs2ll->currentPDU);
+}
+
+static void DVBS2ll_checkpointRestore(struct checkpoint_t * cp, void * data)
+{
+   struct DVBS2ll_t * dvbs2ll = (struct DVBS2ll_t *)data;
+
+   if (dvbs2ll->currentPDU) {
+      PDU_free(dvbs2ll->currentPDU);
+   }
+   checkpoint_read(cp, &dvbs2ll->available, sizeof(dvbs2ll->available));
+   dvbs2ll->currentPDU = checkpoint_readPDU(cp);
+}
+
 /*
  * Création d'une entité DVB-S2 couche 2. Attention, elle ne contient
  * aucun MODCOD par défaut, il faut en ajouter.
@@ -84,11 +112,17 @@ struct DVBS2ll_t * DVBS2ll_create(void * destination,
       result->source = NULL;
       result->getPDU = NULL;
       result->dummyFecFrameProbe = NULL;
+      result->currentPDU = NULL;
       result->available = 1;
  
       // Ajout à la liste des choses à réinitialiser avant une prochaine simu
       motsim_addToResetList(result, (void (*)(void *))DVBS2ll_reset);
 
+      // Et à celle des choses à sauvegarder (cf motSim_checkpoint)
+      motSim_addToCheckpointList(result, "DVBS2ll", DVBS2ll_checkpointSave, DVBS2ll_checkpointRestore);
+      checkpoint_registerFunction(DVBS2ll_endTransmission);
+      checkpoint_registerFunction(DVBS2ll_getPDU);
+
       printf_debug(DEBUG_DVB, "%p created\n", result);
    }
    return result;
@@ -236,7 +270,7 @@ void DVBS2ll_endTransmission(struct DVBS2ll_t * dvbs2ll)
    struct PDU_t * pdu;
 
    printf_debug(DEBUG_DVB, "t=%f\n",
-		motSim_getCurrentTime());
+		motSim_dateToSeconds(motSim_getCurrentTime()));
 
    // Si PDU != NULL, on passe la PDU à la destination
    if (dvbs2ll->currentPDU) {
@@ -259,7 +293,7 @@ void DVBS2ll_endTransmission(struct DVBS2ll_t * dvbs2ll)
 void  DVBS2ll_endPropagation(struct DVBS2ll_t * dvbs2ll)
 {
    printf_debug(DEBUG_DVB, "t=%f\n",
-		motSim_getCurrentTime());
+		motSim_dateToSeconds(motSim_getCurrentTime()));
 
 }
 
@@ -313,11 +347,11 @@ void DVBS2ll_sendPDU(struct DVBS2ll_t * dvbs2ll, struct PDU_t * pdu)
    transmissionTime = DVBS2ll_bbframeTransmissionTime(dvbs2ll, mc);
 
    printf_debug(DEBUG_DVB, "t=%f : size %u/%u (BYTES) Modcod %d, tt = %f ms\n",
-		motSim_getCurrentTime(), pdu?PDU_size(pdu):0, bitLength/8, mc, transmissionTime * 1000.0);
+		motSim_dateToSeconds(motSim_getCurrentTime()), pdu?PDU_size(pdu):0, bitLength/8, mc, transmissionTime * 1000.0);
 
    /* Au bout d'un temps d'émission, le support est libre */
    motSim_insertNewEvent((eventAction_t)DVBS2ll_endTransmission, dvbs2ll,
-			 motSim_getCurrentTime() + transmissionTime);
+			 motSim_getCurrentTime() + motSim_secondsToDate(transmissionTime));
 
    /* Au bout d'un temps d'émission plus propagation, le récepteur reçoit */
    //   motSim_insertNewEvent((eventAction_t)DVBS2ll_endPropagation, dvbs2ll,
@@ -1,30 +1,129 @@
+/**
+ * @file event-file.c
+ * @brief Implantation des files d'événements
+ *
+ * Plusieurs implantations sont disponibles, le choix se fait à la
+ * création de la file (cf enum eventFileType_t) :
+ *
+ *  - une liste doublement chaînée triée, historique, dont l'insertion
+ *  est en O(n) ;
+ *  - un tas implicite d'arité 2 ou 4 stocké dans un tableau, en
+ *  O(log n) pour l'insertion comme pour l'extraction ;
+ *  - un tas d'appariement dont les noeuds sont les événements
+ *  eux-mêmes (champs child, prev, next) ;
+ *  - une file calendrier (R. Brown, CACM 1988) en O(1) amorti, dont
+ *  le nombre et la largeur des seaux sont réajustés en fonction du
+ *  nombre d'événements et de l'écart observé entre leurs dates ;
+ *  - une roue hiérarchique, en O(1) pour les échéances proches, où
+ *  attendent les événements périodiques et les temporisateurs (cf
+ *  motSim_addEvent).
+ *
+ * Toutes comparent les événements sur le couple (date, numéro
+ * d'insertion) de sorte que deux événements de même date sortent
+ * dans l'ordre où ils sont entrés.
+ *
+ * Un événement annulé reste dans la file (il est marqué
+ * EVENT_CANCELLED) et n'est libéré que lorsqu'il en atteint la
+ * tête. Un événement déplacé change en revanche de place
+ * immédiatement : par remontée ou descente dans les tas implicites,
+ * par découpage dans le tas d'appariement, et par retrait puis
+ * réinsertion dans les listes.
+ *
+ * Tous les événements de même date peuvent être extraits d'un coup
+ * (cf eventFile_extractSameDate) : ils forment un préfixe de la liste
+ * ou du seau courant de la file calendrier ou de la roue, qu'il
+ * suffit de détacher, et un sous-arbre contenant la racine d'un tas implicite,
+ * qui n'est réorganisé qu'une fois.
+ */
 #include <stdlib.h>    // Malloc, NULL, ...
 #include <assert.h>
+#include <math.h>      // floor
 
 #include <stdio.h>     // printf, ...
 
-#include <event.h>
+#include <event-file.h>
 #include <pdu.h>
 
+/*
+ * Capacité initiale du tableau d'un tas (il est agrandi au besoin)
+ */
+#define EVENT_FILE_HEAP_INIT_SIZE 1024
+#define EVENT_FILE_BATCH_INIT_SIZE 64  // Idem pour les ex aequo
+
+/*
+ * Paramètres de la file calendrier
+ */
+#define EVENT_FILE_CAL_MIN_BUCKETS 16  // Nombre minimal de seaux (puissance de 2)
+#define EVENT_FILE_CAL_NB_SAMPLES  25  // Echantillon pour le calcul de la largeur
+
+/*
+ * Paramètres de la roue hiérarchique : 8 niveaux de 64 seaux couvrent
+ * 2^48 crans d'une nanoseconde, soit 78 heures
+ */
+#define EVENT_FILE_WHEEL_RESOLUTION 1e-9 // Largeur d'un cran (en secondes)
+#define EVENT_FILE_WHEEL_BITS       6
+#define EVENT_FILE_WHEEL_SLOTS      (1 << EVENT_FILE_WHEEL_BITS)
+#define EVENT_FILE_WHEEL_LEVELS     8
+#define EVENT_FILE_WHEEL_OVERFLOW   (EVENT_FILE_WHEEL_LEVELS * EVENT_FILE_WHEEL_SLOTS)
+#define EVENT_FILE_WHEEL_MAX_TICK   (1LL << 62)
+
 struct eventFile_t {
-   int nombre;
+   enum eventFileType_t type;
+   int                  nombre;    // Y compris les événements annulés
+   int                  nbCancelled; // Annulés pas encore balayés
+   unsigned long        nbInsert;  // Compteur pour la numérotation
+   unsigned long      * seq;       // Celui utilisé (cf eventFile_shareSequence)
+
+   // La liste triée
    struct event_t * premier;
    struct event_t * dernier;
-};
 
-struct eventFile_t * eventFile_create()
-{
-   struct eventFile_t * result = (struct eventFile_t *) sim_malloc(sizeof(struct eventFile_t));
+   // Les tas implicites
+   struct event_t ** heap;
+   int               heapSize;    // Taille du tableau
+   int               arity;
+   struct event_t ** batch;       // Les ex aequo extraits d'un coup
+   int             * holes;       // et les places qu'ils libèrent
+   int               batchSize;   // Taille de ces deux tableaux
 
-   result->nombre = 0;
-   result->premier = NULL;
-   result->dernier = NULL;
+   // Le tas d'appariement
+   struct event_t * root;
 
-   return result;
+   // La file calendrier
+   struct event_t ** buckets;     // Un seau est une liste triée
+   int               nbBuckets;   // Toujours une puissance de 2
+   motSimDate_t      width;       // Largeur (en temps) d'un seau
+   long long         currentVB;   // Numéro "absolu" du seau courant
+   unsigned long     nbResize;    // Nombre de réajustements
+   unsigned long     nbDirectSearch; // Nombre d'années parcourues à vide
+
+   // La roue hiérarchique (avec buckets, width et currentVB)
+   struct event_t   ** tails;       // La fin de chaque seau
+   unsigned long long  wheelMap[EVENT_FILE_WHEEL_LEVELS]; // Seaux non vides
+
+   // Les fonctions spécifiques à l'implantation
+   void (*insert)(struct eventFile_t * file, struct event_t * event);
+   struct event_t * (*extract)(struct eventFile_t * file);
+   struct event_t * (*nextEvent)(struct eventFile_t * file);
+   struct event_t * (*extractSameDate)(struct eventFile_t * file, int * nb);
+   void (*reschedule)(struct eventFile_t * file, struct event_t * event, motSimDate_t date);
+   void (*dump)(struct eventFile_t * file);
+};
+
+/*
+ * L'ordre entre deux événements : la date, puis l'ordre d'insertion
+ */
+static inline int eventFile_before(struct event_t * a, struct event_t * b)
+{
+   return (a->date < b->date) || ((a->date == b->date) && (a->seq < b->seq));
 }
 
+/*==========================================================================*/
+/*   La liste triée                                                         */
+/*==========================================================================*/
+
 // WARNING : il faut trier !!
-void eventFile_insert(struct eventFile_t * file, struct event_t * event)
+void eventFile_listInsert(struct eventFile_t * file, struct event_t * event)
 {
    struct event_t * precedent = file->dernier;
 
@@ -58,11 +157,9 @@ void eventFile_insert(struct eventFile_t * file, struct event_t * event)
          file->dernier = event;
       }
    }
-
-   file->nombre++;
 }
 
-struct event_t * eventFile_extract(struct eventFile_t * file)
+struct event_t * eventFile_listExtract(struct eventFile_t * file)
 {
   struct event_t * premier = NULL;
 
@@ -78,36 +175,1421 @@ struct event_t * eventFile_extract(struct eventFile_t * file)
 	 assert(file->premier != NULL);
          file->premier->prev = NULL;
       }
-      file->nombre --;
    }
    return premier;
 }
 
+struct event_t * eventFile_listNextEvent(struct eventFile_t * file)
+{
+   return file->premier;
+}
+
 /*
- * Consultation (sans extraction) du prochain
+ * Les ex aequo de tête forment un préfixe de la liste
  */
-struct event_t * eventFile_nextEvent(struct eventFile_t * file)
+struct event_t * eventFile_listExtractSameDate(struct eventFile_t * file, int * nb)
 {
-   if (file->premier) {
-      return file->premier;
+   struct event_t * premier = file->premier;
+   struct event_t * dernier = premier;
+
+   *nb = 1;
+   while ((dernier->next) && (dernier->next->date == premier->date)) {
+      dernier = dernier->next;
+      (*nb)++;
    }
 
-   return NULL;
+   file->premier = dernier->next;
+   if (file->premier) {
+      file->premier->prev = NULL;
+   } else {
+      file->dernier = NULL;
+   }
+   dernier->next = NULL;
 
+   return premier;
 }
 
-int eventFile_length(struct eventFile_t * file)
+void eventFile_listReschedule(struct eventFile_t * file, struct event_t * event, motSimDate_t date)
 {
-   return file->nombre;
+   if (event->prev) {
+      event->prev->next = event->next;
+   } else {
+      file->premier = event->next;
+   }
+   if (event->next) {
+      event->next->prev = event->prev;
+   } else {
+      file->dernier = event->prev;
+   }
+
+   event->date = date;
+   eventFile_listInsert(file, event);
 }
 
-void eventFile_dump(struct eventFile_t * file)
+void eventFile_listDump(struct eventFile_t * file)
 {
    struct event_t * el;
 
    for (el = file->premier; el != NULL; el = el->next) {
-     //   for (el = file->premier; el != file->dernier; el = el->suivant) {
-      printf("(%p : %6.3f) ", el, event_getDate(el));
+      printf("(%p : %6.3f) ", el, motSim_dateToSeconds(event_getDate(el)));
+   }
+   printf("\n");
+}
+
+/*==========================================================================*/
+/*   Les tas implicites d'arité quelconque                                  */
+/*==========================================================================*/
+
+/*
+ * Placement d'un événement à l'indice i du tas
+ */
+static inline void eventFile_heapSet(struct eventFile_t * file, int i, struct event_t * event)
+{
+   file->heap[i] = event;
+   event->heapIdx = i;
+}
+
+/*
+ * Remontée de l'élément d'indice i
+ */
+void eventFile_heapSiftUp(struct eventFile_t * file, int i)
+{
+   struct event_t * event = file->heap[i];
+   int parent;
+
+   while (i > 0) {
+      parent = (i - 1) / file->arity;
+      if (!eventFile_before(event, file->heap[parent])) {
+         break;
+      }
+      eventFile_heapSet(file, i, file->heap[parent]);
+      i = parent;
+   }
+   eventFile_heapSet(file, i, event);
+}
+
+/*
+ * Descente de l'élément d'indice i dans un tas de taille n
+ */
+void eventFile_heapSiftDown(struct eventFile_t * file, int i, int n)
+{
+   struct event_t * event = file->heap[i];
+   int first, last, c, best;
+
+   while (1) {
+      first = file->arity * i + 1;
+      if (first >= n) {
+         break;
+      }
+      last = min(first + file->arity, n);
+
+      // Le plus petit des fils
+      best = first;
+      for (c = first + 1; c < last; c++) {
+         if (eventFile_before(file->heap[c], file->heap[best])) {
+            best = c;
+         }
+      }
+      if (!eventFile_before(file->heap[best], event)) {
+         break;
+      }
+      eventFile_heapSet(file, i, file->heap[best]);
+      i = best;
+   }
+   eventFile_heapSet(file, i, event);
+}
+
+/*
+ * Dans les fonctions suivantes, file->nombre est le nombre
+ * d'événements avant l'opération (il est mis à jour par l'appelant)
+ */
+void eventFile_heapInsert(struct eventFile_t * file, struct event_t * event)
+{
+   if (file->nombre == file->heapSize) {
+      __totalMallocSize += file->heapSize * sizeof(struct event_t *);
+      file->heapSize *= 2;
+      file->heap = (struct event_t **)realloc(file->heap, file->heapSize * sizeof(struct event_t *));
+      assert(file->heap);
+   }
+   file->heap[file->nombre] = event;
+   eventFile_heapSiftUp(file, file->nombre);
+}
+
+struct event_t * eventFile_heapExtract(struct eventFile_t * file)
+{
+   struct event_t * premier = file->heap[0];
+   int n = file->nombre - 1;
+
+   premier->heapIdx = -1;
+
+   // Le dernier prend la place du premier puis descend
+   if (n) {
+      eventFile_heapSet(file, 0, file->heap[n]);
+      eventFile_heapSiftDown(file, 0, n);
+   }
+   return premier;
+}
+
+struct event_t * eventFile_heapNextEvent(struct eventFile_t * file)
+{
+   return file->heap[0];
+}
+
+static int eventFile_compareSeq(const void * a, const void * b)
+{
+   unsigned long sa = (*(struct event_t **)a)->seq;
+   unsigned long sb = (*(struct event_t **)b)->seq;
+
+   return (sa > sb) - (sa < sb);
+}
+
+/*
+ * Les ex aequo de la racine forment un sous-arbre qui la contient
+ * (leurs ancêtres ne peuvent être plus tardifs). Parcouru en largeur,
+ * il est obtenu par indices croissants. Les places libérées en deçà
+ * de la nouvelle taille sont comblées par les derniers éléments du
+ * tableau, puis redescendues de la plus profonde à la racine : comme
+ * pour la construction d'un tas (Floyd), les sous-arbres de chacune
+ * sont alors déjà des tas.
+ */
+struct event_t * eventFile_heapExtractSameDate(struct eventFile_t * file, int * nb)
+{
+   motSimDate_t date = file->heap[0]->date;
+   int first, last, c, i, j, k, n, t;
+
+   k = 0;
+   file->batch[k++] = file->heap[0];
+   for (j = 0; j < k; j++) {
+      first = file->arity * file->batch[j]->heapIdx + 1;
+      last = min(first + file->arity, file->nombre);
+      for (c = first; c < last; c++) {
+         if (file->heap[c]->date == date) {
+            if (k == file->batchSize) {
+               __totalMallocSize += file->batchSize * (sizeof(struct event_t *) + sizeof(int));
+               file->batchSize *= 2;
+               file->batch = (struct event_t **)realloc(file->batch, file->batchSize * sizeof(struct event_t *));
+               file->holes = (int *)realloc(file->holes, file->batchSize * sizeof(int));
+               assert(file->batch && file->holes);
+            }
+            file->batch[k++] = file->heap[c];
+         }
+      }
+   }
+
+   for (j = 0; j < k; j++) {
+      file->holes[j] = file->batch[j]->heapIdx;
+      file->batch[j]->heapIdx = -1;
+   }
+
+   // On comble les places par la fin du tableau
+   n = file->nombre - k;
+   t = file->nombre - 1;
+   for (j = 0; (j < k) && (file->holes[j] < n); j++) {
+      while (file->heap[t]->heapIdx == -1) {
+         t--;
+      }
+      eventFile_heapSet(file, file->holes[j], file->heap[t--]);
+   }
+
+   // Une seule réorganisation, de bas en haut
+   for (i = j - 1; i >= 0; i--) {
+      eventFile_heapSiftDown(file, file->holes[i], n);
+   }
+
+   // Restent à les remettre dans l'ordre d'insertion
+   qsort(file->batch, k, sizeof(struct event_t *), eventFile_compareSeq);
+   for (j = 0; j < k; j++) {
+      file->batch[j]->prev = j ? file->batch[j - 1] : NULL;
+      file->batch[j]->next = (j < k - 1) ? file->batch[j + 1] : NULL;
+   }
+
+   *nb = k;
+   return file->batch[0];
+}
+
+void eventFile_heapReschedule(struct eventFile_t * file, struct event_t * event, motSimDate_t date)
+{
+   int earlier = (date < event->date);
+
+   event->date = date;
+   if (earlier) {
+      eventFile_heapSiftUp(file, event->heapIdx);
+   } else {
+      eventFile_heapSiftDown(file, event->heapIdx, file->nombre);
+   }
+}
+
+void eventFile_heapDump(struct eventFile_t * file)
+{
+   int i;
+
+   for (i = 0; i < file->nombre; i++) {
+      printf("(%p : %6.3f) ", file->heap[i], motSim_dateToSeconds(event_getDate(file->heap[i])));
+   }
+   printf("\n");
+}
+
+/*==========================================================================*/
+/*   Le tas d'appariement                                                   */
+/*==========================================================================*/
+/*
+ * Les événements sont les noeuds. Pour chaque noeud, child est le
+ * premier fils, next le frère suivant et prev le frère précédent (ou
+ * le père pour un premier fils). La racine n'a ni prev ni next.
+ */
+
+/*
+ * Fusion de deux tas (a et b sont des racines non nulles)
+ */
+static struct event_t * eventFile_pairingMeld(struct event_t * a, struct event_t * b)
+{
+   struct event_t * tmp;
+
+   if (eventFile_before(b, a)) {
+      tmp = a; a = b; b = tmp;
+   }
+
+   // b devient le premier fils de a
+   b->prev = a;
+   b->next = a->child;
+   if (a->child) {
+      a->child->prev = b;
+   }
+   a->child = b;
+
+   return a;
+}
+
+/*
+ * Fusion en deux passes d'une liste de frères
+ */
+static struct event_t * eventFile_pairingMergePairs(struct event_t * first)
+{
+   struct event_t * a, * b, * next;
+   struct event_t * pairs = NULL;
+   struct event_t * result = NULL;
+
+   // Première passe : on apparie de gauche à droite, les résultats
+   // sont empilés (chaînés par next)
+   while (first) {
+      a = first;
+      b = a->next;
+      a->prev = a->next = NULL;
+      if (b) {
+         next = b->next;
+         b->prev = b->next = NULL;
+         a = eventFile_pairingMeld(a, b);
+      } else {
+         next = NULL;
+      }
+      a->next = pairs;
+      pairs = a;
+      first = next;
+   }
+
+   // Seconde passe : on fusionne de droite à gauche
+   while (pairs) {
+      next = pairs->next;
+      pairs->next = NULL;
+      result = result ? eventFile_pairingMeld(result, pairs) : pairs;
+      pairs = next;
+   }
+
+   return result;
+}
+
+void eventFile_pairingInsert(struct eventFile_t * file, struct event_t * event)
+{
+   event->child = NULL;
+   event->prev = NULL;
+   event->next = NULL;
+
+   file->root = file->root ? eventFile_pairingMeld(file->root, event) : event;
+}
+
+struct event_t * eventFile_pairingExtract(struct eventFile_t * file)
+{
+   struct event_t * premier = file->root;
+
+   if (premier) {
+      file->root = eventFile_pairingMergePairs(premier->child);
+      premier->child = NULL;
+   }
+   return premier;
+}
+
+struct event_t * eventFile_pairingNextEvent(struct eventFile_t * file)
+{
+   return file->root;
+}
+
+/*
+ * Rien de mieux que des extractions successives : chaque fusion
+ * dépend de la précédente
+ */
+struct event_t * eventFile_pairingExtractSameDate(struct eventFile_t * file, int * nb)
+{
+   struct event_t * premier = eventFile_pairingExtract(file);
+   struct event_t * dernier = premier;
+
+   *nb = 1;
+   while ((file->root) && (file->root->date == premier->date)) {
+      dernier->next = eventFile_pairingExtract(file);
+      dernier->next->prev = dernier;
+      dernier = dernier->next;
+      (*nb)++;
+   }
+
+   return premier;
+}
+
+/*
+ * Le noeud est détaché de son père. S'il avance, son sous-arbre
+ * reste valide et le suit ; sinon ses fils sont fusionnés à la racine.
+ */
+void eventFile_pairingReschedule(struct eventFile_t * file, struct event_t * event, motSimDate_t date)
+{
+   int earlier = (date < event->date);
+   struct event_t * subtree;
+
+   if (event == file->root) {
+      event->date = date;
+      if (earlier) {
+         return;
+      }
+      file->root = eventFile_pairingMergePairs(event->child);
+      event->child = NULL;
+   } else {
+      if (event->prev->child == event) {
+         event->prev->child = event->next;
+      } else {
+         event->prev->next = event->next;
+      }
+      if (event->next) {
+         event->next->prev = event->prev;
+      }
+      event->prev = NULL;
+      event->next = NULL;
+      event->date = date;
+
+      if (!earlier) {
+         subtree = eventFile_pairingMergePairs(event->child);
+         event->child = NULL;
+         if (subtree) {
+            file->root = eventFile_pairingMeld(file->root, subtree);
+         }
+      }
+   }
+
+   file->root = file->root ? eventFile_pairingMeld(file->root, event) : event;
+}
+
+static void eventFile_pairingDumpNode(struct event_t * node)
+{
+   for (; node != NULL; node = node->next) {
+      printf("(%p : %6.3f) ", node, motSim_dateToSeconds(event_getDate(node)));
+      eventFile_pairingDumpNode(node->child);
    }
+}
+
+void eventFile_pairingDump(struct eventFile_t * file)
+{
+   eventFile_pairingDumpNode(file->root);
    printf("\n");
 }
+
+/*==========================================================================*/
+/*   La file calendrier                                                     */
+/*==========================================================================*/
+/*
+ * Un événement de date d appartient au seau "absolu" vb = d/width
+ * (partie entière) qui est rangé dans le seau vb modulo nbBuckets. On
+ * parcourt les seaux absolus dans l'ordre croissant à partir de
+ * currentVB, ce qui évite toute accumulation d'erreur sur les bornes
+ * des seaux. Les fonctions internes ne modifient pas file->nombre.
+ */
+static inline long long eventFile_calendarVB(struct eventFile_t * file, motSimDate_t date)
+{
+   return (long long)floor((double)(date / file->width));
+}
+
+static inline int eventFile_calendarIdx(struct eventFile_t * file, long long vb)
+{
+   return (int)((unsigned long long)vb & (file->nbBuckets - 1));
+}
+
+/*
+ * Insertion dans le seau sans mise à jour de currentVB
+ */
+static void eventFile_calendarBucketInsert(struct eventFile_t * file, struct event_t * event)
+{
+   int idx = eventFile_calendarIdx(file, eventFile_calendarVB(file, event->date));
+   struct event_t * el = file->buckets[idx];
+   struct event_t * prev = NULL;
+
+   while ((el) && (eventFile_before(el, event))) {
+      prev = el;
+      el = el->next;
+   }
+   event->prev = prev;
+   event->next = el;
+   if (el) {
+      el->prev = event;
+   }
+   if (prev) {
+      prev->next = event;
+   } else {
+      file->buckets[idx] = event;
+   }
+}
+
+/*
+ * Recherche directe du prochain événement parmi les têtes des seaux
+ */
+static struct event_t * eventFile_calendarMin(struct eventFile_t * file)
+{
+   struct event_t * head, * best = NULL;
+   int idx;
+
+   for (idx = 0; idx < file->nbBuckets; idx++) {
+      head = file->buckets[idx];
+      if ((head) && ((best == NULL) || (eventFile_before(head, best)))) {
+         best = head;
+      }
+   }
+   return best;
+}
+
+/*
+ * Recherche du seau contenant le prochain événement. currentVB est
+ * positionné sur ce seau. La file ne doit pas être vide.
+ */
+static struct event_t * eventFile_calendarLocate(struct eventFile_t * file)
+{
+   struct event_t * head, * best;
+   int n;
+
+   // On parcourt au plus une "année"
+   for (n = 0; n < file->nbBuckets; n++) {
+      head = file->buckets[eventFile_calendarIdx(file, file->currentVB)];
+      if ((head) && (eventFile_calendarVB(file, head->date) <= file->currentVB)) {
+         return head;
+      }
+      file->currentVB++;
+   }
+
+   // Rien sur une année complète : recherche directe du minimum
+   file->nbDirectSearch++;
+   best = eventFile_calendarMin(file);
+   assert(best);
+   file->currentVB = eventFile_calendarVB(file, best->date);
+
+   return best;
+}
+
+/*
+ * Extraction de la tête du seau courant
+ */
+static struct event_t * eventFile_calendarPop(struct eventFile_t * file)
+{
+   struct event_t * premier = eventFile_calendarLocate(file);
+   int idx = eventFile_calendarIdx(file, file->currentVB);
+
+   assert(file->buckets[idx] == premier);
+   file->buckets[idx] = premier->next;
+   if (premier->next) {
+      premier->next->prev = NULL;
+   }
+   premier->next = NULL;
+   premier->prev = NULL;
+
+   return premier;
+}
+
+/*
+ * Estimation de la largeur des seaux à partir des écarts entre les
+ * dates des (au plus) EVENT_FILE_CAL_NB_SAMPLES prochains événements,
+ * en ignorant les écarts anormalement grands. Les événements sont
+ * extraits puis réinsérés, leur numéro d'insertion est conservé.
+ */
+static motSimDate_t eventFile_calendarNewWidth(struct eventFile_t * file, int nombre)
+{
+   struct event_t * sample[EVENT_FILE_CAL_NB_SAMPLES];
+   int nb = min(nombre, EVENT_FILE_CAL_NB_SAMPLES);
+   motSimDate_t avg, gap, width, sum = 0.0;
+   int n, count = 0;
+
+   if (nb < 2) {
+      return file->width;
+   }
+
+   for (n = 0; n < nb; n++) {
+      sample[n] = eventFile_calendarPop(file);
+   }
+
+   avg = (sample[nb - 1]->date - sample[0]->date) / (nb - 1);
+   for (n = 1; n < nb; n++) {
+      gap = sample[n]->date - sample[n - 1]->date;
+      if (gap <= 2.0 * avg) {
+         sum += gap;
+         count++;
+      }
+   }
+
+   for (n = 0; n < nb; n++) {
+      eventFile_calendarBucketInsert(file, sample[n]);
+   }
+   file->currentVB = eventFile_calendarVB(file, sample[0]->date);
+
+   if ((count == 0) || (sum <= 0.0)) {
+      // Que des ex aequo : on ne sait rien de mieux
+      return (avg > 0.0) ? 3.0 * avg : file->width;
+   }
+
+   // Des dates entières (cf MOTSIM_TICK_DATE) peuvent l'annuler
+   width = 3.0 * sum / count;
+
+   return (width > 0) ? width : file->width;
+}
+
+/*
+ * Réorganisation de la file avec nbBuckets seaux. La largeur est
+ * recalculée d'après le contenu actuel.
+ */
+static void eventFile_calendarResize(struct eventFile_t * file, int nombre, int nbBuckets)
+{
+   struct event_t ** oldBuckets = file->buckets;
+   int oldNbBuckets = file->nbBuckets;
+   struct event_t * el, * next;
+   motSimDate_t width;
+   int idx;
+
+   width = eventFile_calendarNewWidth(file, nombre);
+
+   printf_debug(DEBUG_EVENT, "calendar resize : %d -> %d buckets, width %f -> %f\n",
+                oldNbBuckets, nbBuckets, motSim_dateToSeconds(file->width), motSim_dateToSeconds(width));
+
+   file->nbResize++;
+   file->nbBuckets = nbBuckets;
+   file->width = width;
+   file->buckets = (struct event_t **)sim_malloc(nbBuckets * sizeof(struct event_t *));
+   for (idx = 0; idx < nbBuckets; idx++) {
+      file->buckets[idx] = NULL;
+   }
+
+   for (idx = 0; idx < oldNbBuckets; idx++) {
+      for (el = oldBuckets[idx]; el != NULL; el = next) {
+         next = el->next;
+         eventFile_calendarBucketInsert(file, el);
+      }
+   }
+   sim_free(oldBuckets);
+
+   // Les numéros de seaux ont changé avec la largeur
+   if (nombre) {
+      file->currentVB = eventFile_calendarVB(file, eventFile_calendarMin(file)->date);
+   }
+}
+
+void eventFile_calendarInsert(struct eventFile_t * file, struct event_t * event)
+{
+   long long vb = eventFile_calendarVB(file, event->date);
+
+   eventFile_calendarBucketInsert(file, event);
+
+   // On ne doit jamais être au delà du prochain événement
+   if ((file->nombre == 0) || (vb < file->currentVB)) {
+      file->currentVB = vb;
+   }
+
+   if (file->nombre + 1 > 2 * file->nbBuckets) {
+      eventFile_calendarResize(file, file->nombre + 1, 2 * file->nbBuckets);
+   }
+}
+
+struct event_t * eventFile_calendarExtract(struct eventFile_t * file)
+{
+   unsigned long nbDirectSearch = file->nbDirectSearch;
+   struct event_t * premier = eventFile_calendarPop(file);
+
+   if ((file->nbBuckets > EVENT_FILE_CAL_MIN_BUCKETS)
+       && (file->nombre - 1 < file->nbBuckets / 2)) {
+      eventFile_calendarResize(file, file->nombre - 1, file->nbBuckets / 2);
+   } else if ((file->nbDirectSearch != nbDirectSearch)
+	      && (file->nombre - 1 > EVENT_FILE_CAL_NB_SAMPLES)) {
+      // Les seaux sont trop étroits pour la distribution actuelle
+      eventFile_calendarResize(file, file->nombre - 1, file->nbBuckets);
+   }
+
+   return premier;
+}
+
+struct event_t * eventFile_calendarNextEvent(struct eventFile_t * file)
+{
+   return eventFile_calendarLocate(file);
+}
+
+/*
+ * Les ex aequo sont tous dans le seau courant, dont ils forment un
+ * préfixe. Le réajustement éventuel n'est fait qu'une fois.
+ */
+struct event_t * eventFile_calendarExtractSameDate(struct eventFile_t * file, int * nb)
+{
+   struct event_t * premier = eventFile_calendarLocate(file);
+   struct event_t * dernier = premier;
+   int idx = eventFile_calendarIdx(file, file->currentVB);
+
+   assert(file->buckets[idx] == premier);
+   *nb = 1;
+   while ((dernier->next) && (dernier->next->date == premier->date)) {
+      dernier = dernier->next;
+      (*nb)++;
+   }
+   file->buckets[idx] = dernier->next;
+   if (dernier->next) {
+      dernier->next->prev = NULL;
+   }
+   dernier->next = NULL;
+
+   if ((file->nbBuckets > EVENT_FILE_CAL_MIN_BUCKETS)
+       && (file->nombre - *nb < file->nbBuckets / 2)) {
+      eventFile_calendarResize(file, file->nombre - *nb, file->nbBuckets / 2);
+   }
+
+   return premier;
+}
+
+void eventFile_calendarReschedule(struct eventFile_t * file, struct event_t * event, motSimDate_t date)
+{
+   long long vb;
+
+   // Retrait de son seau (déterminé par l'ancienne date)
+   if (event->prev) {
+      event->prev->next = event->next;
+   } else {
+      file->buckets[eventFile_calendarIdx(file, eventFile_calendarVB(file, event->date))] = event->next;
+   }
+   if (event->next) {
+      event->next->prev = event->prev;
+   }
+
+   event->date = date;
+   eventFile_calendarBucketInsert(file, event);
+
+   vb = eventFile_calendarVB(file, date);
+   if (vb < file->currentVB) {
+      file->currentVB = vb;
+   }
+}
+
+void eventFile_calendarDump(struct eventFile_t * file)
+{
+   struct event_t * el;
+   int idx;
+
+   printf("%d buckets of %f : ", file->nbBuckets, motSim_dateToSeconds(file->width));
+   for (idx = 0; idx < file->nbBuckets; idx++) {
+      for (el = file->buckets[idx]; el != NULL; el = el->next) {
+         printf("(%p : %6.3f) ", el, motSim_dateToSeconds(event_getDate(el)));
+      }
+   }
+   printf("\n");
+}
+
+/*==========================================================================*/
+/*   La roue hiérarchique                                                   */
+/*==========================================================================*/
+/*
+ * Les dates sont découpées en crans de EVENT_FILE_WHEEL_RESOLUTION
+ * (file->width en unités de date). Un événement de cran t est rangé,
+ * relativement au cran courant currentVB, au niveau du groupe de
+ * EVENT_FILE_WHEEL_BITS bits de poids fort où t diffère de currentVB,
+ * dans le seau désigné par ce groupe de bits de t. Tous les
+ * événements d'un niveau sont donc postérieurs à ceux des niveaux
+ * inférieurs, et au delà du dernier niveau ils attendent dans un
+ * seau de débordement.
+ *
+ * Les seaux du niveau 0 (un seul cran chacun) sont triés sur (date,
+ * numéro d'insertion), les autres ne le sont pas. Un bit par seau non
+ * vide permet de trouver le premier sans parcourir le niveau. Lorsque
+ * le niveau 0 est vide, le premier seau non vide du niveau suivant
+ * est redistribué sur les niveaux inférieurs (après avoir avancé
+ * currentVB jusqu'à son début).
+ *
+ * Une insertion ou la reprogrammation d'un événement périodique est
+ * donc en O(1), chaque événement ne descendant qu'au plus une fois
+ * par niveau. Une insertion avant le cran courant (retour arrière de
+ * la simulation optimiste par exemple) oblige à tout reconstruire,
+ * ce qui est compté dans nbResize.
+ *
+ * La roue utilise buckets (pour les têtes), width et currentVB comme
+ * la file calendrier. root mémorise le prochain événement lorsqu'il
+ * est connu.
+ */
+static inline long long eventFile_wheelTick(struct eventFile_t * file, motSimDate_t date)
+{
+   double tick = floor((double)(date / file->width));
+
+   // Les dates démesurées (cf MOTSIM_DATE_MAX) partagent le dernier cran
+   return (tick < (double)EVENT_FILE_WHEEL_MAX_TICK) ? (long long)tick : EVENT_FILE_WHEEL_MAX_TICK;
+}
+
+/*
+ * Ajout à la fin d'un seau
+ */
+static void eventFile_wheelAppend(struct eventFile_t * file, int idx, struct event_t * event)
+{
+   event->heapIdx = idx;
+   event->next = NULL;
+   event->prev = file->tails[idx];
+   if (event->prev) {
+      event->prev->next = event;
+   } else {
+      file->buckets[idx] = event;
+   }
+   file->tails[idx] = event;
+}
+
+/*
+ * Insertion à sa place dans un seau trié, en partant de la fin : un
+ * nouvel événement passe en général après tous les autres
+ */
+static void eventFile_wheelSortedInsert(struct eventFile_t * file, int idx, struct event_t * event)
+{
+   struct event_t * el = file->tails[idx];
+
+   while ((el) && (eventFile_before(event, el))) {
+      el = el->prev;
+   }
+   if (el == NULL) {
+      event->heapIdx = idx;
+      event->prev = NULL;
+      event->next = file->buckets[idx];
+      if (event->next) {
+         event->next->prev = event;
+      } else {
+         file->tails[idx] = event;
+      }
+      file->buckets[idx] = event;
+   } else if (el->next == NULL) {
+      eventFile_wheelAppend(file, idx, event);
+   } else {
+      event->heapIdx = idx;
+      event->prev = el;
+      event->next = el->next;
+      el->next->prev = event;
+      el->next = event;
+   }
+}
+
+/*
+ * Rangement d'un événement relativement au cran courant (qu'il ne
+ * doit pas précéder)
+ */
+static void eventFile_wheelPlace(struct eventFile_t * file, struct event_t * event)
+{
+   long long tick = eventFile_wheelTick(file, event->date);
+   unsigned long long diff = (unsigned long long)(tick ^ file->currentVB);
+   int level, slot;
+
+   assert(tick >= file->currentVB);
+
+   if (diff >> (EVENT_FILE_WHEEL_BITS * EVENT_FILE_WHEEL_LEVELS)) {
+      eventFile_wheelAppend(file, EVENT_FILE_WHEEL_OVERFLOW, event);
+      return;
+   }
+
+   level = diff ? (63 - __builtin_clzll(diff)) / EVENT_FILE_WHEEL_BITS : 0;
+   slot = (int)(tick >> (level * EVENT_FILE_WHEEL_BITS)) & (EVENT_FILE_WHEEL_SLOTS - 1);
+   file->wheelMap[level] |= 1ULL << slot;
+
+   if (level == 0) {
+      eventFile_wheelSortedInsert(file, slot, event);
+   } else {
+      eventFile_wheelAppend(file, level * EVENT_FILE_WHEEL_SLOTS + slot, event);
+   }
+}
+
+/*
+ * Retrait d'un événement de son seau
+ */
+static void eventFile_wheelRemove(struct eventFile_t * file, struct event_t * event)
+{
+   int idx = event->heapIdx;
+
+   if (event->prev) {
+      event->prev->next = event->next;
+   } else {
+      file->buckets[idx] = event->next;
+   }
+   if (event->next) {
+      event->next->prev = event->prev;
+   } else {
+      file->tails[idx] = event->prev;
+   }
+   event->prev = NULL;
+   event->next = NULL;
+
+   if ((file->buckets[idx] == NULL) && (idx < EVENT_FILE_WHEEL_OVERFLOW)) {
+      file->wheelMap[idx / EVENT_FILE_WHEEL_SLOTS] &= ~(1ULL << (idx % EVENT_FILE_WHEEL_SLOTS));
+   }
+}
+
+/*
+ * Détachement de tout le contenu d'un seau
+ */
+static struct event_t * eventFile_wheelDetach(struct eventFile_t * file, int idx)
+{
+   struct event_t * result = file->buckets[idx];
+
+   file->buckets[idx] = NULL;
+   file->tails[idx] = NULL;
+   if (idx < EVENT_FILE_WHEEL_OVERFLOW) {
+      file->wheelMap[idx / EVENT_FILE_WHEEL_SLOTS] &= ~(1ULL << (idx % EVENT_FILE_WHEEL_SLOTS));
+   }
+
+   return result;
+}
+
+/*
+ * Rangement d'une chaîne d'événements, dans l'ordre
+ */
+static void eventFile_wheelPlaceAll(struct eventFile_t * file, struct event_t * el)
+{
+   struct event_t * next;
+
+   for (; el != NULL; el = next) {
+      next = el->next;
+      eventFile_wheelPlace(file, el);
+   }
+}
+
+/*
+ * Reconstruction complète à partir d'un cran antérieur au cran
+ * courant
+ */
+static void eventFile_wheelRebuild(struct eventFile_t * file, long long tick)
+{
+   struct event_t * chain = NULL, * last = NULL, * el;
+   int idx;
+
+   printf_debug(DEBUG_EVENT, "wheel rebuild from %lld to %lld\n", file->currentVB, tick);
+
+   for (idx = 0; idx <= EVENT_FILE_WHEEL_OVERFLOW; idx++) {
+      el = eventFile_wheelDetach(file, idx);
+      if (el) {
+         if (last) {
+            last->next = el;
+            el->prev = last;
+         } else {
+            chain = el;
+         }
+         for (last = el; last->next != NULL; last = last->next);
+      }
+   }
+
+   file->nbResize++;
+   file->currentVB = tick;
+   eventFile_wheelPlaceAll(file, chain);
+}
+
+/*
+ * Le prochain événement, sans rien déplacer. Un seau qui n'est pas
+ * du niveau 0 doit être parcouru, le résultat est donc mémorisé
+ * (dans root) jusqu'à la prochaine modification. La file ne doit pas
+ * être vide.
+ */
+static struct event_t * eventFile_wheelMin(struct eventFile_t * file)
+{
+   struct event_t * el;
+   int level, idx = EVENT_FILE_WHEEL_OVERFLOW;
+
+   if (file->root) {
+      return file->root;
+   }
+
+   for (level = 0; level < EVENT_FILE_WHEEL_LEVELS; level++) {
+      if (file->wheelMap[level]) {
+         idx = level * EVENT_FILE_WHEEL_SLOTS + __builtin_ctzll(file->wheelMap[level]);
+         break;
+      }
+   }
+
+   file->root = file->buckets[idx];
+   assert(file->root);
+   if (idx >= EVENT_FILE_WHEEL_SLOTS) {
+      for (el = file->root->next; el != NULL; el = el->next) {
+         if (eventFile_before(el, file->root)) {
+            file->root = el;
+         }
+      }
+   }
+
+   return file->root;
+}
+
+/*
+ * Redistribution des seaux jusqu'à ce que le prochain événement soit
+ * en tête d'un seau du niveau 0, dont on renvoie l'indice. La file ne
+ * doit pas être vide.
+ */
+static int eventFile_wheelLocate(struct eventFile_t * file)
+{
+   struct event_t * el;
+   long long tick;
+   int level, slot, shift;
+
+   while (file->wheelMap[0] == 0) {
+      for (level = 1; level < EVENT_FILE_WHEEL_LEVELS; level++) {
+         if (file->wheelMap[level]) {
+            break;
+         }
+      }
+
+      if (level < EVENT_FILE_WHEEL_LEVELS) {
+         // On avance jusqu'au début du premier seau non vide
+         slot = __builtin_ctzll(file->wheelMap[level]);
+         shift = level * EVENT_FILE_WHEEL_BITS;
+         file->currentVB = ((file->currentVB >> (shift + EVENT_FILE_WHEEL_BITS)) << (shift + EVENT_FILE_WHEEL_BITS))
+            | ((long long)slot << shift);
+         eventFile_wheelPlaceAll(file, eventFile_wheelDetach(file, level * EVENT_FILE_WHEEL_SLOTS + slot));
+      } else {
+         // Plus rien dans la roue : on avance jusqu'au premier débordement
+         el = file->buckets[EVENT_FILE_WHEEL_OVERFLOW];
+         assert(el);
+         tick = eventFile_wheelTick(file, el->date);
+         for (el = el->next; el != NULL; el = el->next) {
+            tick = min(tick, eventFile_wheelTick(file, el->date));
+         }
+         file->currentVB = tick;
+         eventFile_wheelPlaceAll(file, eventFile_wheelDetach(file, EVENT_FILE_WHEEL_OVERFLOW));
+      }
+   }
+
+   return __builtin_ctzll(file->wheelMap[0]);
+}
+
+void eventFile_wheelInsert(struct eventFile_t * file, struct event_t * event)
+{
+   long long tick = eventFile_wheelTick(file, event->date);
+
+   if (tick < file->currentVB) {
+      eventFile_wheelRebuild(file, tick);
+   }
+   eventFile_wheelPlace(file, event);
+
+   if ((file->root) && (eventFile_before(event, file->root))) {
+      file->root = event;
+   }
+}
+
+struct event_t * eventFile_wheelExtract(struct eventFile_t * file)
+{
+   struct event_t * premier = file->buckets[eventFile_wheelLocate(file)];
+
+   eventFile_wheelRemove(file, premier);
+   file->root = NULL;
+
+   return premier;
+}
+
+struct event_t * eventFile_wheelNextEvent(struct eventFile_t * file)
+{
+   return eventFile_wheelMin(file);
+}
+
+/*
+ * Les ex aequo forment un préfixe du seau trié qui contient le
+ * prochain
+ */
+struct event_t * eventFile_wheelExtractSameDate(struct eventFile_t * file, int * nb)
+{
+   int idx = eventFile_wheelLocate(file);
+   struct event_t * premier = file->buckets[idx];
+   struct event_t * dernier = premier;
+
+   *nb = 1;
+   while ((dernier->next) && (dernier->next->date == premier->date)) {
+      dernier = dernier->next;
+      (*nb)++;
+   }
+   file->buckets[idx] = dernier->next;
+   if (dernier->next) {
+      dernier->next->prev = NULL;
+   } else {
+      file->tails[idx] = NULL;
+      file->wheelMap[0] &= ~(1ULL << idx);
+   }
+   dernier->next = NULL;
+   file->root = NULL;
+
+   return premier;
+}
+
+void eventFile_wheelReschedule(struct eventFile_t * file, struct event_t * event, motSimDate_t date)
+{
+   eventFile_wheelRemove(file, event);
+   if (file->root == event) {
+      file->root = NULL;
+   }
+
+   event->date = date;
+   eventFile_wheelInsert(file, event);
+}
+
+void eventFile_wheelDump(struct eventFile_t * file)
+{
+   struct event_t * el;
+   int idx;
+
+   printf("tick %f, current %lld : ", motSim_dateToSeconds(file->width), file->currentVB);
+   for (idx = 0; idx <= EVENT_FILE_WHEEL_OVERFLOW; idx++) {
+      if (file->buckets[idx]) {
+         printf("[%d] ", idx);
+      }
+      for (el = file->buckets[idx]; el != NULL; el = el->next) {
+         printf("(%p : %6.3f) ", el, motSim_dateToSeconds(event_getDate(el)));
+      }
+   }
+   printf("\n");
+}
+
+/*==========================================================================*/
+/*   Les fonctions publiques                                                */
+/*==========================================================================*/
+
+struct eventFile_t * eventFile_createType(enum eventFileType_t type)
+{
+   struct eventFile_t * result = (struct eventFile_t *) sim_malloc(sizeof(struct eventFile_t));
+   int i;
+
+   result->type = type;
+   result->nombre = 0;
+   result->nbCancelled = 0;
+   result->nbInsert = 0;
+   result->seq = &result->nbInsert;
+   result->premier = NULL;
+   result->dernier = NULL;
+   result->heap = NULL;
+   result->heapSize = 0;
+   result->arity = 0;
+   result->batch = NULL;
+   result->holes = NULL;
+   result->batchSize = 0;
+   result->root = NULL;
+   result->buckets = NULL;
+   result->nbBuckets = 0;
+   result->width = 1.0;
+   result->currentVB = 0;
+   result->nbResize = 0;
+   result->nbDirectSearch = 0;
+   result->tails = NULL;
+   for (i = 0; i < EVENT_FILE_WHEEL_LEVELS; i++) {
+      result->wheelMap[i] = 0;
+   }
+
+   switch (type) {
+      case eventFileSortedList :
+         result->insert = eventFile_listInsert;
+         result->extract = eventFile_listExtract;
+         result->nextEvent = eventFile_listNextEvent;
+         result->extractSameDate = eventFile_listExtractSameDate;
+         result->reschedule = eventFile_listReschedule;
+         result->dump = eventFile_listDump;
+      break;
+      case eventFileBinaryHeap :
+      case eventFile4aryHeap :
+         result->arity = (type == eventFileBinaryHeap)?2:4;
+         result->heapSize = EVENT_FILE_HEAP_INIT_SIZE;
+         result->heap = (struct event_t **) sim_malloc(result->heapSize * sizeof(struct event_t *));
+         result->batchSize = EVENT_FILE_BATCH_INIT_SIZE;
+         result->batch = (struct event_t **) sim_malloc(result->batchSize * sizeof(struct event_t *));
+         result->holes = (int *) sim_malloc(result->batchSize * sizeof(int));
+         result->insert = eventFile_heapInsert;
+         result->extract = eventFile_heapExtract;
+         result->nextEvent = eventFile_heapNextEvent;
+         result->extractSameDate = eventFile_heapExtractSameDate;
+         result->reschedule = eventFile_heapReschedule;
+         result->dump = eventFile_heapDump;
+      break;
+      case eventFilePairingHeap :
+         result->insert = eventFile_pairingInsert;
+         result->extract = eventFile_pairingExtract;
+         result->nextEvent = eventFile_pairingNextEvent;
+         result->extractSameDate = eventFile_pairingExtractSameDate;
+         result->reschedule = eventFile_pairingReschedule;
+         result->dump = eventFile_pairingDump;
+      break;
+      case eventFileCalendarQueue :
+         result->nbBuckets = EVENT_FILE_CAL_MIN_BUCKETS;
+         result->buckets = (struct event_t **) sim_malloc(result->nbBuckets * sizeof(struct event_t *));
+         for (i = 0; i < result->nbBuckets; i++) {
+            result->buckets[i] = NULL;
+         }
+         result->insert = eventFile_calendarInsert;
+         result->extract = eventFile_calendarExtract;
+         result->nextEvent = eventFile_calendarNextEvent;
+         result->extractSameDate = eventFile_calendarExtractSameDate;
+         result->reschedule = eventFile_calendarReschedule;
+         result->dump = eventFile_calendarDump;
+      break;
+      case eventFileTimingWheel :
+         result->width = motSim_secondsToDate(EVENT_FILE_WHEEL_RESOLUTION);
+         if (result->width <= 0) {
+            result->width = 1; // Des dates entières plus grossières
+         }
+         result->buckets = (struct event_t **) sim_malloc((EVENT_FILE_WHEEL_OVERFLOW + 1) * sizeof(struct event_t *));
+         result->tails = (struct event_t **) sim_malloc((EVENT_FILE_WHEEL_OVERFLOW + 1) * sizeof(struct event_t *));
+         for (i = 0; i <= EVENT_FILE_WHEEL_OVERFLOW; i++) {
+            result->buckets[i] = NULL;
+            result->tails[i] = NULL;
+         }
+         result->insert = eventFile_wheelInsert;
+         result->extract = eventFile_wheelExtract;
+         result->nextEvent = eventFile_wheelNextEvent;
+         result->extractSameDate = eventFile_wheelExtractSameDate;
+         result->reschedule = eventFile_wheelReschedule;
+         result->dump = eventFile_wheelDump;
+      break;
+      default :
+         motSim_error(MS_FATAL, "Unknown event file type %d\n", type);
+      break;
+   }
+
+   printf_debug(DEBUG_EVENT, "%s created\n", eventFile_getTypeName(result));
+
+   return result;
+}
+
+/*
+ * Libération d'une file (les événements qu'elle contient encore ne
+ * sont pas libérés)
+ */
+void eventFile_free(struct eventFile_t * file)
+{
+   if (file->heap) {
+      sim_free(file->heap);
+      sim_free(file->batch);
+      sim_free(file->holes);
+   }
+   if (file->buckets) {
+      sim_free(file->buckets);
+   }
+   if (file->tails) {
+      sim_free(file->tails);
+   }
+   sim_free(file);
+}
+
+struct eventFile_t * eventFile_create()
+{
+   return eventFile_createType(eventFileDefaultType);
+}
+
+enum eventFileType_t eventFile_getType(struct eventFile_t * file)
+{
+   return file->type;
+}
+
+char * eventFile_getTypeName(struct eventFile_t * file)
+{
+   switch (file->type) {
+      case eventFileSortedList :
+         return "sorted list";
+      case eventFileBinaryHeap :
+         return "binary heap";
+      case eventFile4aryHeap :
+         return "4-ary heap";
+      case eventFilePairingHeap :
+         return "pairing heap";
+      case eventFileCalendarQueue :
+         return "calendar queue";
+      case eventFileTimingWheel :
+         return "timing wheel";
+      default :
+         return "???";
+   }
+}
+
+/*
+ * Les deux files numérotent leurs insertions avec le même compteur
+ */
+void eventFile_shareSequence(struct eventFile_t * file, struct eventFile_t * other)
+{
+   file->seq = other->seq;
+}
+
+/*
+ * Nombre de réajustements de la file (toujours nul pour les
+ * implantations qui n'en font pas)
+ */
+unsigned long eventFile_getNbResize(struct eventFile_t * file)
+{
+   return file->nbResize;
+}
+
+void eventFile_insert(struct eventFile_t * file, struct event_t * event)
+{
+   assert(!(event->type & EVENT_CANCELLED));
+
+   event->seq = (*file->seq)++;
+   event->file = file;
+   file->insert(file, event);
+   file->nombre++;
+}
+
+/*
+ * Extraction de la tête, qu'elle soit annulée ou non
+ */
+static inline struct event_t * eventFile_pop(struct eventFile_t * file)
+{
+   struct event_t * premier = file->extract(file);
+
+   assert(premier);
+   file->nombre --;
+   premier->file = NULL;
+
+   return premier;
+}
+
+/*
+ * Libération des événements annulés présents en tête de file
+ */
+static inline void eventFile_sweep(struct eventFile_t * file)
+{
+   while ((file->nbCancelled) && (file->nextEvent(file)->type & EVENT_CANCELLED)) {
+      file->nbCancelled--;
+      event_free(eventFile_pop(file));
+   }
+}
+
+struct event_t * eventFile_extract(struct eventFile_t * file)
+{
+   eventFile_sweep(file);
+
+   if (file->nombre) {
+      return eventFile_pop(file);
+   }
+   return NULL;
+}
+
+/*
+ * Extraction de tous les événements de la date la plus proche. Ceux
+ * qui sont annulés sont libérés au passage.
+ */
+struct event_t * eventFile_extractSameDate(struct eventFile_t * file)
+{
+   struct event_t * premier, * event, * next;
+   int nb;
+
+   eventFile_sweep(file);
+
+   if (file->nombre == 0) {
+      return NULL;
+   }
+
+   // La tête n'est pas annulée, elle reste la première
+   premier = file->extractSameDate(file, &nb);
+   file->nombre -= nb;
+
+   for (event = premier; event != NULL; event = next) {
+      next = event->next;
+      event->file = NULL;
+      if (event->type & EVENT_CANCELLED) {
+         event->prev->next = next;
+         if (next) {
+            next->prev = event->prev;
+         }
+         file->nbCancelled--;
+         event_free(event);
+      }
+   }
+
+   return premier;
+}
+
+/*
+ * Consultation (sans extraction) du prochain
+ */
+struct event_t * eventFile_nextEvent(struct eventFile_t * file)
+{
+   eventFile_sweep(file);
+
+   if (file->nombre) {
+      return file->nextEvent(file);
+   }
+
+   return NULL;
+}
+
+void eventFile_cancel(struct eventFile_t * file, struct event_t * event)
+{
+   assert(event->file == file);
+
+   event->type |= EVENT_CANCELLED;
+   file->nbCancelled++;
+}
+
+void eventFile_reschedule(struct eventFile_t * file, struct event_t * event, motSimDate_t date)
+{
+   assert(event->file == file);
+   assert(!(event->type & EVENT_CANCELLED));
+
+   // Il passe après les événements de même date déjà présents
+   event->seq = (*file->seq)++;
+   file->reschedule(file, event, date);
+}
+
+int eventFile_length(struct eventFile_t * file)
+{
+   return file->nombre - file->nbCancelled;
+}
+
+/*
+ * Nombre d'événements présents, y compris ceux qui sont annulés
+ */
+int eventFile_size(struct eventFile_t * file)
+{
+   return file->nombre;
+}
+
+/*
+ * La file est vidée sans que les événements soient extraits : seules
+ * ses propres structures (têtes de listes et de seaux) sont remises à
+ * zéro, les tableaux sont conservés avec leur taille. Les événements
+ * ne sont pas libérés, ce qui n'a de sens que si leurs blocs sont
+ * récupérés d'un coup (cf event_reclaimSlabs).
+ */
+void eventFile_clear(struct eventFile_t * file)
+{
+   int i, nbBuckets;
+
+   file->nombre = 0;
+   file->nbCancelled = 0;
+   file->premier = NULL;
+   file->dernier = NULL;
+   file->root = NULL;
+
+   if (file->buckets) {
+      nbBuckets = file->tails ? EVENT_FILE_WHEEL_OVERFLOW + 1 : file->nbBuckets;
+      for (i = 0; i < nbBuckets; i++) {
+         file->buckets[i] = NULL;
+      }
+      file->currentVB = 0;
+   }
+   if (file->tails) {
+      for (i = 0; i <= EVENT_FILE_WHEEL_OVERFLOW; i++) {
+         file->tails[i] = NULL;
+      }
+      for (i = 0; i < EVENT_FILE_WHEEL_LEVELS; i++) {
+         file->wheelMap[i] = 0;
+      }
+   }
+}
+
+void eventFile_dump(struct eventFile_t * file)
+{
+   printf("%s, %d events (%d cancelled) : ", eventFile_getTypeName(file),
+          file->nombre, file->nbCancelled);
+   file->dump(file);
+}
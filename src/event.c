@@ -3,32 +3,132 @@
 #include <assert.h>
 
 #include <event.h>
+#include <event-file.h>
 #include <motsim.h>
+#include <motsim-context.h>
+#include <pdes.h>
+#include <profiler.h>
 
 /*
- * Une file d'événements libres
+ * Les événements sont découpés dans des blocs de EVENT_SLAB_SIZE,
+ * alignés sur les lignes de cache, plutôt qu'alloués un par un. Les
+ * événements libérés sont réutilisés en priorité (file des libres),
+ * puis on poursuit la découpe du bloc courant. Les blocs ne sont
+ * rendus qu'à la destruction du contexte, motSim_reset se contente de
+ * les rembobiner.
+ *
+ * Les blocs, la file des événements libres et les compteurs sont dans
+ * le contexte de simulation courant.
  */
-struct event_t * freeEvent = NULL;
+#define EVENT_SLAB_SIZE 128
 
-unsigned long event_nbCreate = 0;
-unsigned long event_nbMalloc = 0;
-unsigned long event_nbReuse = 0;
-unsigned long event_nbFree = 0;
+struct eventSlab_t {
+   struct event_t       events[EVENT_SLAB_SIZE];
+   int                  nbUsed; // Nombre d'événements déjà découpés
+   struct eventSlab_t * next;
+};
+
+/*
+ * Un nouvel événement pris dans le bloc courant, ou dans le suivant
+ * (qui est créé si besoin)
+ */
+static struct event_t * event_slabAlloc()
+{
+   struct eventSlab_t * slab = __motSim->currentSlab;
+   void * mem = NULL;
+
+   if ((slab == NULL) || (slab->nbUsed == EVENT_SLAB_SIZE)) {
+      if ((slab) && (slab->next)) {
+         slab = slab->next;
+      } else {
+         if (posix_memalign(&mem, EVENT_CACHE_LINE, sizeof(struct eventSlab_t))) {
+            motSim_error(MS_FATAL, "Event slab allocation failed\n");
+         }
+         __totalMallocSize += sizeof(struct eventSlab_t);
+         __motSim->event_nbSlabs++;
+
+         slab = (struct eventSlab_t *)mem;
+         slab->next = NULL;
+         if (__motSim->currentSlab) {
+            __motSim->currentSlab->next = slab;
+         } else {
+            __motSim->eventSlabs = slab;
+         }
+      }
+      slab->nbUsed = 0;
+      __motSim->currentSlab = slab;
+   }
+
+   return &slab->events[slab->nbUsed++];
+}
+
+void event_resetSlabs()
+{
+   struct eventSlab_t * slab;
+
+   if (__motSim->event_nbCreate != __motSim->event_nbFree) {
+      return;
+   }
+
+   for (slab = __motSim->eventSlabs; slab != NULL; slab = slab->next) {
+      slab->nbUsed = 0;
+   }
+   __motSim->currentSlab = __motSim->eventSlabs;
+   __motSim->freeEvent = NULL;
+}
+
+int event_reclaimSlabs(long nbLost)
+{
+   struct eventSlab_t * slab;
+   int n;
+
+   if ((long)(__motSim->event_nbCreate - __motSim->event_nbFree) != nbLost) {
+      return 0;
+   }
+
+   // Seuls les blocs déjà entamés peuvent contenir des événements
+   for (slab = __motSim->eventSlabs; slab != NULL; slab = slab->next) {
+      for (n = 0; n < slab->nbUsed; n++) {
+         slab->events[n].id = 0;
+      }
+      if (slab == __motSim->currentSlab) {
+         break;
+      }
+   }
+   __motSim->event_nbFree += nbLost;
+
+   event_resetSlabs();
+
+   return 1;
+}
+
+void event_freeSlabs(struct motsim_t * ctx)
+{
+   struct eventSlab_t * slab;
+
+   while ((slab = ctx->eventSlabs) != NULL) {
+      ctx->eventSlabs = slab->next;
+      free(slab);
+   }
+   ctx->currentSlab = NULL;
+   ctx->freeEvent = NULL;
+}
 
 struct event_t * event_create(void (*run)(void *data), void * data, motSimDate_t date)
 {
    struct event_t * result;
+   int n;
 
-   if (freeEvent) {
-      result = freeEvent;
-      freeEvent = result->next;
-      event_nbReuse++;
+   if (__motSim->freeEvent) {
+      result = __motSim->freeEvent;
+      __motSim->freeEvent = result->next;
+      __motSim->event_nbReuse++;
    } else {
-      result = (struct event_t *)sim_malloc(sizeof(struct event_t));
-      event_nbMalloc ++;
+      result = event_slabAlloc();
+      __motSim->event_nbMalloc ++;
    }
    assert(result);
-   event_nbCreate ++;
+   __motSim->event_nbCreate ++;
 
    result->type = 0;
    result->period = 0.0;
@@ -37,6 +137,16 @@ struct event_t * event_create(void (*run)(void *data), void * data, motSimDate_t
    result->data = data;
    result->date = date;
 
+   // L'identifiant ne vaut jamais 0 (cf event_free)
+   result->id = __motSim->event_nbCreate;
+
+   result->file = NULL;
+   result->seq = 0;
+   result->child = NULL;
+   result->origin = NULL;
+   for (n = 0; n < EVENT_NB_ARGS; n++) {
+      result->args[n].ptr = NULL;
+   }
    result->prev = NULL;
    result->next = NULL;
 
@@ -58,7 +168,7 @@ struct event_t * event_periodicCreate(void (*run)(void *data), void * data, motS
 
    result = event_create(run, data, date);
 
-   result->type = EVENT_PERIODIC;
+   result->type = EVENT_PERIODIC | EVENT_TIMER;
    result->period = period;
 
    return result;
@@ -72,24 +182,80 @@ void event_periodicAdd(void (*run)(void *data), void * data, motSimDate_t date,
   motSim_addEvent(event_periodicCreate(run, data, date, period));
 }
 
-void free_event(struct event_t * ev)
+struct event_t * event_timerCreate(void (*run)(void *data), void * data, motSimDate_t date)
+{
+   struct event_t * result = event_create(run, data, date);
+
+   result->type = EVENT_TIMER;
+
+   return result;
+}
+
+void event_timerAdd(void (*run)(void *data), void * data, motSimDate_t date)
+{
+   motSim_addEvent(event_timerCreate(run, data, date));
+}
+
+void event_free(struct event_t * ev)
 {
-  event_nbFree++;
-   ev->next = freeEvent;
-   freeEvent = ev;
+   __motSim->event_nbFree++;
+   ev->id = 0; // Les poignées deviennent caduques
+   ev->next = __motSim->freeEvent;
+   __motSim->freeEvent = ev;
+}
+
+void event_setArg(struct event_t * event, int n, void * arg)
+{
+   assert((n >= 0) && (n < EVENT_NB_ARGS));
+   event->args[n].ptr = arg;
+}
+
+void event_setArgDouble(struct event_t * event, int n, double arg)
+{
+   assert((n >= 0) && (n < EVENT_NB_ARGS));
+   event->args[n].real = arg;
+}
+
+void * event_getArg(int n)
+{
+   assert(__motSim->runningEvent);
+   assert((n >= 0) && (n < EVENT_NB_ARGS));
+   return __motSim->runningEvent->args[n].ptr;
+}
+
+double event_getArgDouble(int n)
+{
+   assert(__motSim->runningEvent);
+   assert((n >= 0) && (n < EVENT_NB_ARGS));
+   return __motSim->runningEvent->args[n].real;
+}
+
+struct event_t * event_getCurrent()
+{
+   return __motSim->runningEvent;
 }
 
 void event_run(struct event_t * event)
 {
-   printf_debug(DEBUG_EVENT, " running ev %p at %f\n", event, event->date);
+   struct event_t * running = __motSim->runningEvent;
+
+   printf_debug(DEBUG_EVENT, " running ev %p at %f\n", event, motSim_dateToSeconds(event->date));
  
+   __motSim->runningEvent = event;
+#ifdef MOTSIM_PROFILE
+   if (__motSim->profiling) {
+      profiler_runEvent(event);
+   } else
+#endif
    event->run(event->data);
+   __motSim->runningEvent = running;
 
-   if (event->type &EVENT_PERIODIC) {
+   // Un événement périodique a pu être annulé par sa propre fonction
+   if ((event->type & EVENT_PERIODIC) && !(event->type & EVENT_CANCELLED)) {
       event->date += event->period;
       motSim_addEvent(event);
    } else {
-      free_event(event);
+      event_free(event);
    }
 }
 
@@ -98,3 +264,114 @@ motSimDate_t event_getDate(struct event_t * event)
    return event->date;
 }
 
+
+struct eventHandle_t event_getHandle(struct event_t * event)
+{
+   struct eventHandle_t result;
+
+   result.event = event;
+   result.id = event->id;
+
+   return result;
+}
+
+struct eventHandle_t event_addWithHandle(void (*run)(void *data), void * data, motSimDate_t date)
+{
+   struct event_t * event = event_create(run, data, date);
+
+   motSim_addEvent(event);
+
+   return event_getHandle(event);
+}
+
+/*
+ * La poignée désigne-t-elle toujours le même événement (non annulé) ?
+ */
+static inline int event_handleIsValid(struct eventHandle_t handle)
+{
+   return (handle.event)
+      && (handle.event->id == handle.id)
+      && !(handle.event->type & EVENT_CANCELLED);
+}
+
+/*
+ * Un événement extrait avec ses ex aequo (cf motSim_runUntil) est
+ * toujours considéré en attente : on le retire du groupe courant.
+ */
+static void event_unbatch(struct event_t * event)
+{
+   if (event->prev) {
+      event->prev->next = event->next;
+   } else {
+      __motSim->batch = event->next;
+   }
+   if (event->next) {
+      event->next->prev = event->prev;
+   }
+   event->prev = NULL;
+   event->next = NULL;
+   event->type &= ~EVENT_BATCHED;
+}
+
+int event_isPending(struct eventHandle_t handle)
+{
+   return event_handleIsValid(handle)
+      && ((handle.event->file != NULL) || (handle.event->type & EVENT_BATCHED));
+}
+
+int event_cancel(struct eventHandle_t handle)
+{
+   struct event_t * event = handle.event;
+
+   if (pdes_isSpeculative()) {
+      motSim_error(MS_FATAL, "Events can't be cancelled in optimistic mode\n");
+   }
+
+   if (!event_handleIsValid(handle)) {
+      return 0;
+   }
+
+   if (event->file) {
+      // Il sera balayé lors de son extraction
+      eventFile_cancel(event->file, event);
+   } else if (event->type & EVENT_BATCHED) {
+      event_unbatch(event);
+      event_free(event);
+   } else if (event->type & EVENT_PERIODIC) {
+      // En cours d'exécution : il ne sera pas reprogrammé
+      event->type |= EVENT_CANCELLED;
+   } else {
+      // Déjà extrait de sa file, il est trop tard
+      return 0;
+   }
+   __motSim->event_nbCancel++;
+
+   printf_debug(DEBUG_EVENT, "ev %p cancelled\n", event);
+
+   return 1;
+}
+
+int event_reschedule(struct eventHandle_t handle, motSimDate_t date)
+{
+   if (pdes_isSpeculative()) {
+      motSim_error(MS_FATAL, "Events can't be rescheduled in optimistic mode\n");
+   }
+
+   if (!event_isPending(handle)) {
+      return 0;
+   }
+
+   printf_debug(DEBUG_EVENT, "ev %p moved from %f to %f\n", handle.event,
+                motSim_dateToSeconds(handle.event->date), motSim_dateToSeconds(date));
+
+   if (handle.event->type & EVENT_BATCHED) {
+      event_unbatch(handle.event);
+      handle.event->date = date;
+      eventFile_insert(motSim_getEventFile(handle.event), handle.event);
+   } else {
+      eventFile_reschedule(handle.event->file, handle.event, date);
+   }
+   __motSim->event_nbReschedule++;
+
+   return 1;
+}
@@ -4,21 +4,15 @@
  *
  */
 #include <stdlib.h>    // Malloc, NULL, ...
+#include <string.h>    // memcpy
 #include <assert.h>
 
 #include <file_pdu.h>
 #include <motsim.h>
 #include <ndesObject.h>
 #include <log.h>
+#include <checkpoint.h>
 
-/*
-struct filePDU_t_elt {
-   struct PDU_t         * PDU;
-   motSimDate_t           date_in;
-   struct filePDU_t_elt * suivant;
-   struct filePDU_t_elt * precedent;
-};
-*/
 /**
  * @brief Structure d'une file
  */
@@ -34,9 +28,17 @@ struct filePDU_t {
    int           maxLength;  //!< Nombre maximal d'Ã©lÃ©ments
    int           maxSize ;   //!< Le volume maximal
 
-   /* Gestion de la file */
-   struct PDU_t * premier;
-   struct PDU_t * dernier;
+   /* Gestion de la file : un anneau de PDU dont la capacité est une
+      puissance de 2, avec leurs dates d'arrivée dans un anneau parallèle */
+   struct PDU_t ** PDUs;
+   motSimDate_t  * dates;
+   int             capacite;
+   int             tete;       //!< Indice de la première PDU
+
+   /* Les volumes cumulés : pour chaque PDU, le volume total inséré
+      jusqu'à elle comprise (un troisième anneau), cf filePDU_size_n_PDU */
+   unsigned long long * cumuls;
+   unsigned long long   volumeEntre; //!< Le cumul de la dernière PDU
 
    /* Mesure des dÃ©bits d'entrÃ©e et sortie */
    struct probe_t * throuhputIn;
@@ -62,18 +64,86 @@ struct ndesObjectType_t filePDUType = {
    ndesObjectTypeDefaultValues(filePDU)
 };
 
+/*
+ * La capacité initiale de l'anneau, qui double ensuite à chaque fois
+ * qu'il est plein. Il n'est jamais réduit.
+ */
+#define FILE_PDU_INITIAL_CAPACITY 16
+
+/*
+ * Indice dans l'anneau de la PDU de rang n (à partir de 0)
+ */
+#define filePDU_index(file, n) (((file)->tete + (n)) & ((file)->capacite - 1))
+
+/*
+ * Doublement de la capacité de l'anneau (plein), les PDU sont remises
+ * dans l'ordre à partir de l'indice 0
+ */
+static void filePDU_grow(struct filePDU_t * file)
+{
+   int             capacite = 2 * file->capacite;
+   int             fin = file->capacite - file->tete; // De la tête au bout
+   struct PDU_t ** PDUs = (struct PDU_t **)sim_malloc(capacite * sizeof(struct PDU_t *));
+   motSimDate_t  * dates = (motSimDate_t *)sim_malloc(capacite * sizeof(motSimDate_t));
+   unsigned long long * cumuls = (unsigned long long *)sim_malloc(capacite * sizeof(unsigned long long));
+
+   memcpy(PDUs, file->PDUs + file->tete, fin * sizeof(struct PDU_t *));
+   memcpy(PDUs + fin, file->PDUs, file->tete * sizeof(struct PDU_t *));
+   memcpy(dates, file->dates + file->tete, fin * sizeof(motSimDate_t));
+   memcpy(dates + fin, file->dates, file->tete * sizeof(motSimDate_t));
+   memcpy(cumuls, file->cumuls + file->tete, fin * sizeof(unsigned long long));
+   memcpy(cumuls + fin, file->cumuls, file->tete * sizeof(unsigned long long));
+
+   sim_free(file->PDUs);
+   sim_free(file->dates);
+   sim_free(file->cumuls);
+   file->PDUs = PDUs;
+   file->dates = dates;
+   file->cumuls = cumuls;
+   file->capacite = capacite;
+   file->tete = 0;
+}
+
+/*
+ * Ajout d'une PDU en queue, sans aucun contrôle ni sonde
+ */
+static void filePDU_push(struct filePDU_t * file, struct PDU_t * PDU, motSimDate_t date)
+{
+   int i;
+
+   if (file->nombre == file->capacite) {
+      filePDU_grow(file);
+   }
+   i = filePDU_index(file, file->nombre);
+   file->PDUs[i] = PDU;
+   file->dates[i] = date;
+   file->volumeEntre += PDU_size(PDU);
+   file->cumuls[i] = file->volumeEntre;
+   file->nombre++;
+   file->size += PDU_size(PDU);
+}
+
+/*
+ * Le volume cumulé des n premières PDU (0 <= n <= nombre). Le volume
+ * entré avant la première est celui de la dernière moins le contenu
+ * de la file.
+ */
+#define filePDU_prefix(file, n)						\
+   ((n) ? (file)->cumuls[filePDU_index(file, (n) - 1)] - ((file)->volumeEntre - (file)->size) : 0)
+
 /*
  * Un affichage un peu moche de la file. Peut Ãªtre utile dans des
  * phases de dÃ©bogage.
  */
 void filePDU_dump(struct filePDU_t * file)
 {
-  struct PDU_t * pq;
+  struct PDU_t * pdu;
+  int n;
 
   printf("DUMP %2d elts (id:size/data) : ", file->nombre);
-  for (pq=file->premier; pq != NULL; pq=PDU_getNext(pq)){
-    printf("[%d:%d/%p] ", PDU_id(PDU_private(pq)), PDU_size(PDU_private(pq)),
-	   PDU_private((struct PDU_t *)PDU_private(pq)));
+  for (n = 0; n < file->nombre; n++) {
+    pdu = file->PDUs[filePDU_index(file, n)];
+    printf("[%d:%d/%p] ", PDU_id(pdu), PDU_size(pdu), PDU_private(pdu));
   }
   printf("\n");
 }
@@ -87,42 +157,30 @@ void filePDU_dump(struct filePDU_t * file)
  */
 struct PDU_t * filePDU_extract(struct filePDU_t * file)
 {
-   void * PDU = NULL;
-   struct PDU_t * premier;
+   struct PDU_t * PDU = NULL;
+   motSimDate_t   date;
 
-   printf_debug(DEBUG_FILE, " file %p extracting PDU (out of %d) at %6.3f\n", file, file->nombre, motSim_getCurrentTime());
+   printf_debug(DEBUG_FILE, " file %p extracting PDU (out of %d) at %6.3f\n", file, file->nombre, motSim_dateToSeconds(motSim_getCurrentTime()));
    //  filePDU_dump(file);
 
-   if (file->premier) {
-      PDU = PDU_private(file->premier);
-      premier = file->premier;
-      file->premier = PDU_getNext(premier);
-      // Si c'Ã©tait le seul
-      if (file->dernier == premier) {
-         assert(PDU_getNext(premier) == NULL);
-	 assert(file->nombre == 1);
-         file->dernier = NULL;
-      } else {
-	 assert(file->premier != NULL);
-         PDU_setPrev(file->premier, NULL);
-      }
+   if (file->nombre) {
+      PDU = file->PDUs[file->tete];
+      date = file->dates[file->tete];
+      file->tete = filePDU_index(file, 1);
       file->nombre --;
-      file->size -= PDU_size(PDU_private(premier));
+      file->size -= PDU_size(PDU);
 
       /* Gestion des sondes */
       if (file->extractProbe) {
-         probe_sampleValuePDUFilter(file->extractProbe, PDU_size(PDU_private(premier)), PDU_private(premier));
-         //probe_sample(file->extractProbe, PDU_size(premier->data));
+         probe_sampleValuePDUFilter(file->extractProbe, PDU_size(PDU), PDU);
       }
       if (file->sejournProbe) {
-         if(motSim_getCurrentTime() <  PDU_getCreationDate(premier)){
+         if(motSim_getCurrentTime() < date){
 	    printf_debug(DEBUG_WARN, "Attention, quand on purge, il ne faut pas mettre dans les sondes\n");
          } else {
-	    probe_sampleValuePDUFilter(file->sejournProbe, motSim_getCurrentTime() - PDU_getCreationDate(premier), PDU);
-            //probe_sample(file->sejournProbe, motSim_getCurrentTime() - premier->creationDate);
+	    probe_sampleValuePDUFilter(file->sejournProbe, motSim_dateToSeconds(motSim_getCurrentTime() - date), PDU);
 	 }
       }
-      PDU_free(premier);
    }
    printf_debug(DEBUG_FILE, "out (pdu id %d)\n", PDU?PDU_id(PDU):-1);
    //   filePDU_dump(file);
@@ -181,20 +239,72 @@ void filePDU_setDropStrategy(struct filePDU_t * file, enum filePDU_dropStrategy
 void filePDU_reset(struct filePDU_t * file)
 {
    struct PDU_t * PDU;
-
-   PDU = filePDU_extract(file);
-
-   while (PDU) {
-      PDU_free(PDU);
-      PDU = filePDU_extract(file);
+   struct PDU_t * first = NULL, * last = NULL;
+   int n;
+
+   // Les PDU sont chaînées entre elles au passage, sans passer par
+   // filePDU_extract (ni sondes, ni traces)
+   for (n = 0; n < file->nombre; n++) {
+      PDU = file->PDUs[filePDU_index(file, n)];
+      PDU_setNext(PDU, first);
+      first = PDU;
+      if (last == NULL) {
+         last = PDU;
+      }
    }
 
+   // La chaîne rejoint les PDU libres d'un coup
+   PDU_freeChain(first, last, file->nombre);
+
+   file->tete = 0;
+   file->nombre = 0;
+   file->size = 0;
    file->nbOverflow = 0;
+}
 
-   assert(file->premier == NULL);
-   assert(file->dernier == NULL);
-   assert(file->nombre == 0);
-   assert(file->size == 0);
+/*
+ * Sauvegarde du contenu d'une file (cf checkpoint.h) : pour chaque
+ * PDU, sa date d'insertion puis la PDU elle-même
+ */
+static void filePDU_checkpointSave(struct checkpoint_t * cp, void * data)
+{
+   struct filePDU_t * file = (struct filePDU_t *)data;
+   int                n, i;
+
+   checkpoint_write(cp, &file->nombre, sizeof(file->nombre));
+   checkpoint_write(cp, &file->nbOverflow, sizeof(file->nbOverflow));
+   for (n = 0; n < file->nombre; n++) {
+      i = filePDU_index(file, n);
+      checkpoint_write(cp, &file->dates[i], sizeof(motSimDate_t));
+      checkpoint_writePDU(cp, file->PDUs[i]);
+   }
+}
+
+static void filePDU_checkpointRestore(struct checkpoint_t * cp, void * data)
+{
+   struct filePDU_t * file = (struct filePDU_t *)data;
+   struct PDU_t     * PDU;
+   motSimDate_t       date;
+   int                n, nombre;
+
+   // On vide la file sans passer par les sondes
+   for (n = 0; n < file->nombre; n++) {
+      PDU_free(file->PDUs[filePDU_index(file, n)]);
+   }
+   file->tete = 0;
+   file->nombre = 0;
+   file->size = 0;
+
+   checkpoint_read(cp, &nombre, sizeof(nombre));
+   checkpoint_read(cp, &file->nbOverflow, sizeof(file->nbOverflow));
+   for (n = 0; n < nombre; n++) {
+      checkpoint_read(cp, &date, sizeof(date));
+      if ((PDU = checkpoint_readPDU(cp)) == NULL) {
+	 checkpoint_setError(cp);
+	 return;
+      }
+      filePDU_push(file, PDU, date);
+   }
 }
 
 /** @brief Création d'une file.
@@ -229,8 +339,12 @@ struct filePDU_t * filePDU_create(void * destination,
    //   result->throughputIn = ;
    //   result->throughputOut = ;
 
-   result->premier = NULL;
-   result->dernier = NULL;
+   result->capacite = FILE_PDU_INITIAL_CAPACITY;
+   result->tete = 0;
+   result->PDUs = (struct PDU_t **)sim_malloc(result->capacite * sizeof(struct PDU_t *));
+   result->dates = (motSimDate_t *)sim_malloc(result->capacite * sizeof(motSimDate_t));
+   result->cumuls = (unsigned long long *)sim_malloc(result->capacite * sizeof(unsigned long long));
+   result->volumeEntre = 0;
 
    result->destProcessPDU = destProcessPDU;
    result->destination = destination;
@@ -238,12 +352,17 @@ struct filePDU_t * filePDU_create(void * destination,
    // A priori, pas de sonde
    result->insertProbe = NULL;
    result->extractProbe = NULL;
+   result->dropProbe = NULL;
    result->sejournProbe = NULL;
    result->lengthProbe = NULL;
 
    // Ajout Ã  la liste des choses Ã  rÃ©initialiser avant une prochaine simu
    motsim_addToResetList(result, (void (*)(void *))filePDU_reset);
 
+   // Et à celle des choses à sauvegarder (cf motSim_checkpoint)
+   motSim_addToCheckpointList(result, "filePDU", filePDU_checkpointSave, filePDU_checkpointRestore);
+   checkpoint_registerFunction(filePDU_extract);
+
    printf_debug(DEBUG_FILE, "out\n");
 
    return result;
@@ -251,7 +370,6 @@ struct filePDU_t * filePDU_create(void * destination,
 
 void filePDU_insert(struct filePDU_t * file, struct PDU_t * PDU)
 {
-   struct PDU_t * pq;
    struct PDU_t * pduDel;
  
    printf_debug(DEBUG_FILE, " file %p insert PDU %d size %d (Length = %d/%d, size = %lu/%d, strat %d)\n",
@@ -286,21 +404,7 @@ void filePDU_insert(struct filePDU_t * file, struct PDU_t * PDU)
    // WARNING a mieux expliquer, voire re écrire
    if (((file->maxSize == 0)||(file->size + PDU_size(PDU) <= file->maxSize))
        && ((file->maxLength == 0)||(file->nombre + 1 <= file->maxLength))) {
-      pq = PDU_create(0, PDU);// Oui, les PDUs servent de chainons de liste !
-
-      PDU_setNext(pq, NULL);
-      PDU_setPrev(pq, file->dernier);
-
-      if (file->dernier)
-         PDU_setNext(file->dernier, pq);
-
-      file->dernier = pq;
-
-      if (!file->premier)
-         file->premier = pq;
-
-      file->nombre++;
-      file->size += PDU_size(PDU);
+      filePDU_push(file, PDU, motSim_getCurrentTime());
 
       ndesLog_logLineF(PDU_getObject(PDU), "IN %d", filePDU_getObjectId(file));
 
@@ -386,23 +490,11 @@ int filePDU_length(struct filePDU_t * file)
  */
 int filePDU_size_n_PDU(struct filePDU_t * file, int n)
 {
-   int i = 1;
    int result;
-   if (n == 0) {
-      return 0;
-   }
 
-   struct PDU_t * pq = file->premier;
+   assert((n >= 0) && (n <= file->nombre));
 
-   assert(pq);
-   result = PDU_size((struct PDU_t *)PDU_private(pq));
-
-   while (i < n) {
-      pq = PDU_getNext(pq);
-      assert(pq);
-      result += PDU_size((struct PDU_t *)PDU_private(pq));
-      i++;
-   }
+   result = filePDU_prefix(file, n);
 
    printf_debug(DEBUG_FILE, "PDU - to %d : size %d\n", n, result);
 
@@ -418,31 +510,39 @@ int filePDU_size(struct filePDU_t * file)
   //   return filePDU_size_n_PDU(file, filePDU_length(file));
 }
 
-/* WARNING : il vaudrait mieux une fonction qui donne un
- * pointeur vers la neme PDU, non ?
+/**
+ * @brief Nombre de PDU de tête dont la taille cumulée ne dépasse pas
+ * volume
+ *
+ * Les cumuls croissent le long de l'anneau, on procède donc par
+ * dichotomie.
  */
+int filePDU_nb_PDU_in(struct filePDU_t * file, unsigned long volume)
+{
+   int min = 0, max = file->nombre, n; // prefix(min) <= volume
+
+   if (file->size <= volume) {
+      return file->nombre;
+   }
+   while (max - min > 1) {
+      n = (min + max) / 2;
+      if (filePDU_prefix(file, n) <= volume) {
+         min = n;
+      } else {
+         max = n;
+      }
+   }
+   return min;
+}
 
 /*
  * Taille du enieme paquet de la file (n>=1)
  */
 int filePDU_size_PDU_n(struct filePDU_t * file, int n)
 {
-   int i = 1;
-   struct PDU_t * pq = file->premier;
-
-   assert(pq);
-
-   while (i < n) {
-      pq = PDU_getNext(pq);
-      assert(pq);
-      i++;
-   }
+   assert((n >= 1) && (n <= file->nombre));
 
-   assert(PDU_private(pq));
-
-   //   printf_debug(DEBUG_FILE, "PDU %d : size %d\n", n, PDU_size(pq->PDU));
-
-   return PDU_size((struct PDU_t *)PDU_private(pq));
+   return PDU_size(file->PDUs[filePDU_index(file, n - 1)]);
 }
 
 /*
@@ -450,22 +550,9 @@ int filePDU_size_PDU_n(struct filePDU_t * file, int n)
  */
 int filePDU_id_PDU_n(struct filePDU_t * file, int n)
 {
-   int i = 1;
-   struct PDU_t * pq = file->premier;
-
-   assert(pq);
-
-   while (i < n) {
-      pq = PDU_getNext(pq);
-      assert(pq);
-      i++;
-   }
-
-   assert(PDU_private(pq));
-
-   //   printf_debug(DEBUG_FILE, "PDU %d : id %d\n", n, PDU_id(pq->PDU));
+   assert((n >= 1) && (n <= file->nombre));
 
-   return PDU_id((struct PDU_t *)PDU_private(pq));
+   return PDU_id(file->PDUs[filePDU_index(file, n - 1)]);
 }
 
 /*
@@ -512,6 +599,18 @@ void filePDU_addFileLengthProbe(struct filePDU_t * file, struct probe_t * length
    file->lengthProbe = probe_chain(length, file->lengthProbe);
 }
 
+struct probe_t * filePDU_addInstabilityDetector(struct filePDU_t * file,
+						void (*unstable)(struct probe_t * p, void * data),
+						void * data)
+{
+   struct probe_t * length = probe_createMean();
+
+   probe_setInstabilityDetector(length, unstable, data);
+   filePDU_addFileLengthProbe(file, length);
+
+   return length;
+}
+
 
 /*
  * Mesure du dÃ©bit d'entrÃ©e sur les n-1 derniÃ¨res PDUs, oÃ¹ n est le
@@ -523,14 +622,17 @@ void filePDU_addFileLengthProbe(struct filePDU_t * file, struct probe_t * length
 double filePDU_getInputThroughput(struct filePDU_t * file)
 {
    double result = 0.0;
+   motSimDate_t debut, fin;
 
    if (file->nombre > 1) {
-      // Volume reÃ§u depuis la premiÃ¨re PDU
-      result = filePDU_size_n_PDU(file, filePDU_length(file)) - PDU_size(PDU_private(file->premier));
-      printf_debug(DEBUG_ALWAYS, "%f de %f a %f\n", result, PDU_getCreationDate(file->premier), PDU_getCreationDate(file->dernier));
-
-      // On divise par le temps entre la premiÃ¨re et la derniÃ¨re
-      result = result/(PDU_getCreationDate(file->dernier) - PDU_getCreationDate(file->premier));
+      // Volume reçu depuis la première PDU
+      result = filePDU_size(file) - PDU_size(file->PDUs[file->tete]);
+      debut = file->dates[file->tete];
+      fin = file->dates[filePDU_index(file, file->nombre - 1)];
+      printf_debug(DEBUG_ALWAYS, "%f de %f a %f\n", result, motSim_dateToSeconds(debut), motSim_dateToSeconds(fin));
+
+      // On divise par le temps entre la première et la dernière
+      result = result/motSim_dateToSeconds(fin - debut);
    }
 
    return result;
@@ -2,13 +2,14 @@
 #include <event.h>
 #include <ll-simplex.h>
 #include <file_pdu.h>
+#include <pdes.h>
 /*
  * Caractéristiques d'une couche liaison simplex
  */
 struct llSimplex_t {
    // Les caractérisques
    unsigned long throughput; // Débit en bits/s
-   double propagation;       // Temps de propagation en secondes
+   motSimDate_t propagation; // Temps de propagation (cf motSim_secondsToDate)
 
    // L'état
    int idle; //  Pret à émettre ou pas
@@ -17,6 +18,9 @@ struct llSimplex_t {
    struct filePDU_t * flyingPDUs;  // Les PDUs "en vol"
    struct PDU_t     * pduOut; // Une PDU qui vient de sortir
 
+   // Le canal vers le LP destinataire (NULL si c'est le même)
+   struct pdesChannel_t * channel;
+
    // L'entité aval
    void * destination;
    processPDU_t destProcessPDU;
@@ -40,18 +44,31 @@ struct llSimplex_t * llSimplex_create(void * destination,
    result->destination = destination;
    result->destProcessPDU = destProcessPDU;
    result->throughput = throughput;
-   result->propagation = propagation;
+   result->propagation = motSim_secondsToDate(propagation);
    result->lastSource = NULL;
 
    result->lastGetPDU = NULL;
    result->pduOut = NULL;
    result->flyingPDUs = filePDU_create(NULL, NULL);
+   result->channel = NULL;
 
    result->idle = 1;
 
    return result;
 }
 
+/*
+ * Le destinataire est dans un autre LP
+ */
+void llSimplex_setDestinationLP(struct llSimplex_t * lls,
+				struct pdes_t * pdes,
+				int destLP)
+{
+   lls->channel = pdes_channelCreate(pdes, destLP,
+				     lls->destination, lls->destProcessPDU,
+				     lls->propagation);
+}
+
 /*
  * Destruction
  */
@@ -92,8 +109,20 @@ void llSimplex_endOfTransmission(void * l)
 
    printf_debug(DEBUG_PDU, "in\n");
 
-   // La PDU est en l'air !
-   filePDU_insert(lls->flyingPDUs, lls->pdu);
+   // La PDU est en l'air ! Si le destinataire est dans un autre LP,
+   // c'est lui qui prépare son arrivée
+   if (lls->channel) {
+      pdes_channelSend(lls->channel, lls->pdu,
+		       motSim_getCurrentTime() + lls->propagation);
+   } else {
+      filePDU_insert(lls->flyingPDUs, lls->pdu);
+
+      // On prépare son arrivée
+      printf_debug(DEBUG_PDU, "On prepare la fin de propagation a %lf\n", motSim_dateToSeconds(motSim_getCurrentTime() + lls->propagation));
+      event_add(llSimplex_endOfPropagation,
+	        l,
+	        motSim_getCurrentTime() + lls->propagation);
+   }
 
    // On est dispo du coup !
    lls->idle = 1;
@@ -101,12 +130,6 @@ void llSimplex_endOfTransmission(void * l)
    // Elle est partie !
    lls->pdu = NULL;
 
-   // On prépare son arrivée
-   printf_debug(DEBUG_PDU, "On prepare la fin de propagation a %lf\n", motSim_getCurrentTime() + lls->propagation);
-   event_add(llSimplex_endOfPropagation,
-	     l,
-	     motSim_getCurrentTime() + lls->propagation);
-
    // On va voir en amont si par hasard une nouvelle PDU n'attend pas ...
    if ((lls->lastSource) && (lls->lastGetPDU)){
       (void)llSimplex_processPDU(lls, lls->lastGetPDU, lls->lastSource); 
@@ -141,10 +164,10 @@ int llSimplex_processPDU(void * l,
             lls->idle = 0;   // Je ne suis plus pret !
             lls->pdu = pdu; 
             printf_debug(DEBUG_PDU, "On prepare la fin de transmission a %lf\n",
-		      motSim_getCurrentTime() + PDU_size(pdu)*8.0/lls->throughput);
+		      motSim_dateToSeconds(motSim_getCurrentTime()) + PDU_size(pdu)*8.0/lls->throughput);
             event_add(llSimplex_endOfTransmission,
    		l, 
-		motSim_getCurrentTime() + PDU_size(pdu)*8.0/lls->throughput);
+		motSim_getCurrentTime() + motSim_secondsToDate(PDU_size(pdu)*8.0/lls->throughput));
 	 } else {
             lls->lastSource = NULL;
             lls->lastGetPDU = NULL;
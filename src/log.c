@@ -30,6 +30,7 @@
 
 
 #include <ndesObjectFile.h>
+#include <motsim-context.h>
 
 /**
  * @brief définition d'une entrée dans les log
@@ -96,9 +97,9 @@ struct ndesLog_t {
 } ndesLog_t;
 
 /**
- * Le log général
+ * Le log général est propre à chaque simulation, il est dans le
+ * contexte de simulation (__motSim->ndesLog)
  */
-struct ndesLog_t * ndesLog;
 
 /**
  * @brief Activation du log
@@ -135,7 +136,7 @@ struct ndesLog_t * ndesLog_create()
  */
 void ndesLog_init()
 {
-   ndesLog = ndesLog_create();
+   __motSim->ndesLog = ndesLog_create();
 }
 
 /**
@@ -146,7 +147,7 @@ void ndesLog_logLine(struct ndesObject_t * ndesObject, char * line)
    struct ndesLogEntry_t * le;
 
    le = ndesLogEntry_create(ndesObject, line);
-   ndesObjectFile_insert(ndesLog->journal, le);
+   ndesObjectFile_insert(__motSim->ndesLog->journal, le);
 }
 
 /**
@@ -179,11 +180,11 @@ int ndesLog_dump(char * fileName)
    struct ndesObject_t             * obj;
    struct ndesLogEntry_t           * le;
 
-   ofi = ndesObjectFile_createIterator(ndesLog->journal);
+   ofi = ndesObjectFile_createIterator(__motSim->ndesLog->journal);
    while ((obj = ndesObjectFile_iteratorGetNext(ofi))) {
       assert(ndesObject_getType(obj) == &ndesLogEntryType);
       le = ndesObject_getPrivate(obj);
-      printf("[LOG] %f %d \"%s\" !\n", le->date, ndesObject_getId(le->object), le->msg);
+      printf("[LOG] %f %d \"%s\" !\n", motSim_dateToSeconds(le->date), ndesObject_getId(le->object), le->msg);
    }
    ndesObjectFile_deleteIterator(ofi);
    
@@ -4,69 +4,29 @@
 #include <signal.h>    // sigaction
 #include <strings.h>   // bzero
 #include <time.h>
-#include <unistd.h>    // alarm
 
 #include <event-file.h>
 #include <pdu.h>
 #include <log.h>
-
-struct resetClient_t {
-   void * data;
-   void (*resetFunc)(void * data);
-
-   struct resetClient_t * next;
-};
+#include <motsim-context.h>
+#include <pdes.h>
+#include <profiler.h>
+#include <telemetry.h>
+#include <checkpoint.h>
+#include <region.h>
 
 /*
- * La quantité de données demandée à malloc
+ * La quantité de données demandée à malloc (par le thread courant)
  */
-unsigned long __totalMallocSize = 0;
+__thread unsigned long __totalMallocSize = 0;
 
 /*
- * Caractéristiques d'une instance du simulateur (à voir : ne
- * seraient-ce pas les caractéristiques d'une simulation ?)
+ * Le contexte de simulation courant, propre à chaque thread. Ses
+ * caractéristiques sont décrites dans motsim-context.h
  */
-struct motsim_t {
-   time_t               actualStartTime;
-   motSimDate_t               currentTime;
-   motSimDate_t               finishTime; // Heure simulée de fin prévue
-   struct eventFile_t * events;
-   int                  nbInsertedEvents;
-   int                  nbRanEvents;
-
-   struct probe_t       * dureeSimulation;
-   struct resetClient_t * resetClient;
-};
-
-struct motsim_t * __motSim;
-
-/*
- * Caractéristiques d'une campagne de simulation. Une campagne sert à
- * instancier à plusieurs reprises une même simulation.
- */
-struct motSimCampaign_t {
-   int nbSimulations;   // Nombre d'instances de la simulation à
-			// répliquer
-
-   // La liste des sondes de moyenne (permettant d'établir des
-   // intervalles de confiance sur des sondes de la simulation)
-
-   // La liste des clients à ré-initialiser en début de campagne
-   struct resetClient_t * resetClient;
-};
+__thread struct motsim_t * __motSim = NULL;
 
 
-void motSim_periodicMessage(void * foo)
-{
-     printf("\r[%6.2f%%] t = %8.2f, ev : %6d in %6d out %6d pre",
-	    100.00*__motSim->currentTime/__motSim->finishTime,
-	    __motSim->currentTime,
-	    __motSim->nbInsertedEvents,
-	    __motSim->nbRanEvents,
-	    eventFile_length(__motSim->events));
-     fflush(stdout);
-}
-
 void mainHandler(int sig)
 {
    if (sig == SIGCHLD) {
@@ -75,14 +35,6 @@ void mainHandler(int sig)
    }
 }
 
-void periodicHandler(int sig)
-{
-   if (__motSim->currentTime<= __motSim->finishTime) {
-      motSim_periodicMessage(NULL);
-      alarm(1);
-   }
-}
-
 /*
  * Terminaison "propre"
  */
@@ -97,14 +49,27 @@ void motSim_exit(int retValue)
  * lancer plusieurs simulations consécutives
  */
 void motSim_create()
+{
+   motSim_createWithEventFile(eventFileDefaultType);
+}
+
+/*
+ * La même, en choisissant l'implantation de l'échéancier
+ */
+void motSim_createWithEventFile(enum eventFileType_t eventFileType)
 {
    struct sigaction act;
 
+   // Le nouveau contexte devient le contexte courant. Les réserves,
+   // compteurs et sondes sont vides
    __motSim = (struct motsim_t * )sim_malloc(sizeof(struct motsim_t));
+   bzero(__motSim, sizeof(struct motsim_t));
    __motSim->currentTime = 0.0;
 
    printf_debug(DEBUG_MOTSIM, "Initialisation du simulateur ...\n");
-   __motSim->events = eventFile_create();
+   __motSim->events = eventFile_createType(eventFileType);
+   __motSim->timers = eventFile_createType(eventFileTimingWheel);
+   eventFile_shareSequence(__motSim->timers, __motSim->events);
    __motSim->nbInsertedEvents = 0;
    __motSim->nbRanEvents = 0;
    __motSim->resetClient = NULL;
@@ -120,43 +85,241 @@ void motSim_create()
    sigaction(SIGQUIT, &act,NULL);
    sigaction(SIGCHLD, &act,NULL);
 
-   // For periodic ping
-   act.sa_handler = periodicHandler;
-   sigaction(SIGALRM, &act,NULL);
-
    printf_debug(DEBUG_MOTSIM, "creation des sondes systeme\n");
    // Calcul de la durée moyenne des simulations
    __motSim->dureeSimulation = probe_createExhaustive();
    probe_setPersistent(__motSim->dureeSimulation);
 
-   // Les sondes systeme
-   PDU_createProbe = probe_createMean();
-   probe_setName(PDU_createProbe, "created PDUs");
-
-   PDU_reuseProbe = probe_createMean();
-   probe_setName(PDU_reuseProbe, "reused PDUs");
-
-   PDU_mallocProbe = probe_createMean();
-   probe_setName(PDU_mallocProbe, "mallocd PDUs");
-
-   PDU_releaseProbe = probe_createMean();
-   probe_setName(PDU_releaseProbe, "released PDUs");
+   // Les PDU sont comptées dans le contexte, les sondes système ne
+   // sont créées qu'à la demande (cf PDU_setSystemProbes)
 
    // Intialisation des log
    printf_debug(DEBUG_MOTSIM, "Initialisation des log ...\n");
    ndesLog_init();
 
+   // Le contexte est suivi par le thread de telemetry_start
+   telemetry_register(__motSim);
+
    printf_debug(DEBUG_MOTSIM, "Simulateur pret ...\n");
 }
 
+struct motsim_t * motSim_getCurrentContext()
+{
+   return __motSim;
+}
+
+struct motsim_t * motSim_setCurrentContext(struct motsim_t * ctx)
+{
+   struct motsim_t * previous = __motSim;
+
+   __motSim = ctx;
+
+   return previous;
+}
+
+void motSim_destroyContext(struct motsim_t * ctx)
+{
+   struct motsim_t      * current = motSim_setCurrentContext(ctx);
+   struct resetClient_t * resetClient;
+   struct event_t       * event;
+
+   assert(current != ctx);
+
+   telemetry_unregister(ctx);
+
+   // Les événements en attente rejoignent la réserve
+   while ((event = motSim_extractEvent()) != NULL) {
+      event_free(event);
+   }
+   eventFile_free(ctx->events);
+   eventFile_free(ctx->timers);
+
+   event_freeSlabs(ctx);
+   profiler_free(ctx);
+   checkpoint_free(ctx);
+
+   PDU_freeSlabs(ctx);
+   region_free(ctx);
+
+   while ((resetClient = ctx->resetClient) != NULL) {
+      ctx->resetClient = resetClient->next;
+      sim_free(resetClient);
+   }
+
+   motSim_setCurrentContext(current);
+   sim_free(ctx);
+}
+
+/*
+ * Mélange d'un entier 64 bits (splitmix64). Deux entrées voisines
+ * donnent des sorties sans rapport apparent.
+ */
+static unsigned long long motSim_mix64(unsigned long long x)
+{
+   x += 0x9E3779B97F4A7C15ULL;
+   x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+   x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+   return x ^ (x >> 31);
+}
+
+void motSim_setSeed(unsigned long long seed)
+{
+   __motSim->rngSeeded = 1;
+   __motSim->rngSeed = motSim_mix64(seed);
+   __motSim->rngNbStreams = 0;
+}
+
+/*
+ * erand48 ne permet pas de sauter dans sa suite, chaque source part
+ * donc d'un état obtenu en mélangeant la graine et le rang de la
+ * source.
+ */
+int motSim_getSubstreamSeed(unsigned short xsubi[3])
+{
+   unsigned long long x;
+
+   if ((__motSim == NULL) || (!__motSim->rngSeeded)) {
+      return 0;
+   }
+
+   x = motSim_mix64(__motSim->rngSeed + __motSim->rngNbStreams++);
+   xsubi[0] = (unsigned short)(x);
+   xsubi[1] = (unsigned short)(x >> 16);
+   xsubi[2] = (unsigned short)(x >> 32);
+
+   return 1;
+}
+
+/*
+ * L'identifiant est mélangé avant d'être combiné à la graine, les
+ * sous-suites nommées ne recoupent donc pas celles qui sont
+ * numérotées par rang de création
+ */
+void motSim_getStreamSeed(unsigned long long stream, unsigned short xsubi[3])
+{
+   unsigned long long x;
+
+   x = motSim_mix64(motSim_mix64(stream) ^ __motSim->rngSeed);
+   xsubi[0] = (unsigned short)(x);
+   xsubi[1] = (unsigned short)(x >> 16);
+   xsubi[2] = (unsigned short)(x >> 32);
+}
+
+void motSim_setAntithetic(int antithetic)
+{
+   __motSim->rngAntithetic = antithetic;
+}
+
+int motSim_getAntithetic()
+{
+   return (__motSim != NULL) && (__motSim->rngAntithetic);
+}
+
+/*
+ * Les temporisateurs (EVENT_TIMER, dont les événements périodiques)
+ * attendent dans une roue hiérarchique où leur insertion est en
+ * O(1), les autres dans l'échéancier. Les deux files partagent leur
+ * numérotation, le prochain événement est le premier des deux sur le
+ * couple (date, numéro d'insertion).
+ */
+struct eventFile_t * motSim_getEventFile(struct event_t * event)
+{
+   return (event->type & EVENT_TIMER) ? __motSim->timers : __motSim->events;
+}
+
+/*
+ * La file qui contient le prochain événement, NULL si les deux sont
+ * vides
+ */
+static struct eventFile_t * motSim_nextFile()
+{
+   struct event_t * event = eventFile_nextEvent(__motSim->events);
+   struct event_t * timer = eventFile_nextEvent(__motSim->timers);
+
+   if ((timer) && ((event == NULL)
+		   || (timer->date < event->date)
+		   || ((timer->date == event->date) && (timer->seq < event->seq)))) {
+      return __motSim->timers;
+   }
+   return event ? __motSim->events : NULL;
+}
+
+struct event_t * motSim_nextEvent()
+{
+   struct eventFile_t * file = motSim_nextFile();
+
+   return file ? eventFile_nextEvent(file) : NULL;
+}
+
+struct event_t * motSim_extractEvent()
+{
+   struct eventFile_t * file = motSim_nextFile();
+
+   return file ? eventFile_extract(file) : NULL;
+}
+
+/*
+ * Extraction de tous les événements de la date la plus proche. S'il
+ * y en a dans les deux files, leurs groupes sont fusionnés dans
+ * l'ordre d'insertion.
+ */
+static struct event_t * motSim_extractSameDate()
+{
+   struct event_t * event = eventFile_nextEvent(__motSim->events);
+   struct event_t * timer = eventFile_nextEvent(__motSim->timers);
+   struct event_t * result = NULL, * last = NULL, * next;
+
+   if (timer == NULL) {
+      return eventFile_extractSameDate(__motSim->events);
+   }
+   if ((event == NULL) || (timer->date < event->date)) {
+      return eventFile_extractSameDate(__motSim->timers);
+   }
+   if (event->date < timer->date) {
+      return eventFile_extractSameDate(__motSim->events);
+   }
+
+   event = eventFile_extractSameDate(__motSim->events);
+   timer = eventFile_extractSameDate(__motSim->timers);
+   while ((event) || (timer)) {
+      if ((timer == NULL) || ((event) && (event->seq < timer->seq))) {
+	 next = event;
+	 event = event->next;
+      } else {
+	 next = timer;
+	 timer = timer->next;
+      }
+      next->prev = last;
+      next->next = NULL;
+      if (last) {
+	 last->next = next;
+      } else {
+	 result = next;
+      }
+      last = next;
+   }
+
+   return result;
+}
+
 void motSim_addEvent(struct event_t * event)
 {
  
-  printf_debug(DEBUG_EVENT, "New event (%p) at %6.3f (%d ev)\n", event, event_getDate(event), __motSim->nbInsertedEvents);
+  printf_debug(DEBUG_EVENT, "New event (%p) at %6.3f (%d ev)\n", event, motSim_dateToSeconds(event_getDate(event)), __motSim->nbInsertedEvents);
    assert(__motSim->currentTime <= event_getDate(event));
 
-   eventFile_insert(__motSim->events, event);
+   eventFile_insert(motSim_getEventFile(event), event);
    __motSim->nbInsertedEvents++;
+
+#ifdef MOTSIM_PROFILE
+   if (__motSim->profiling) {
+      profiler_eventScheduled();
+   }
+#endif
+
+   if (__motSim->pdesLP) {
+      pdes_eventInserted(event);
+   }
  
 }
 
@@ -167,44 +330,74 @@ void motSim_runNevents(int nbEvents)
    if (!__motSim->nbRanEvents) {
       __motSim->actualStartTime = time(NULL);
    }
-   while (nbEvents) {
-      event = eventFile_extract(__motSim->events);
+   while ((nbEvents) && (__motSim->status == MOTSIM_STATUS_OK)) {
+      event = motSim_extractEvent();
       if (event) {
          nbEvents--;
-         printf_debug(DEBUG_EVENT, "next event (%p) at %f\n", event, event_getDate(event));
+         printf_debug(DEBUG_EVENT, "next event (%p) at %f\n", event, motSim_dateToSeconds(event_getDate(event)));
          assert(__motSim->currentTime <= event_getDate(event));
          __motSim->currentTime = event_getDate(event);
          event_run(event);
          __motSim->nbRanEvents ++;
       } else {
          printf_debug(DEBUG_MOTSIM, "no more event !\n");
-         return ;
+         break;
       }
    }
+   telemetry_publish(__motSim);
+}
+
+/*
+ * Exécution, dans l'ordre d'insertion, d'un groupe d'événements de
+ * même date obtenu par eventFile_extractSameDate. L'horloge n'est
+ * avancée qu'une fois. Le groupe reste accessible dans le contexte
+ * car un événement peut encore annuler ou déplacer l'un des suivants
+ * (cf event_cancel). Ceux qu'il programme à la même date passeront
+ * après tout le groupe, comme s'ils avaient été extraits un à un.
+ */
+static void motSim_runBatch(struct event_t * batch)
+{
+   struct event_t * event;
+
+   printf_debug(DEBUG_EVENT, "next events at %f\n", motSim_dateToSeconds(event_getDate(batch)));
+   assert(__motSim->currentTime <= event_getDate(batch));
+   __motSim->currentTime = event_getDate(batch);
+   __motSim->nbBatches++;
+
+   for (event = batch; event != NULL; event = event->next) {
+      event->type |= EVENT_BATCHED;
+   }
+   __motSim->batch = batch;
+
+   while ((event = __motSim->batch) != NULL) {
+      __motSim->batch = event->next;
+      if (event->next) {
+         event->next->prev = NULL;
+      }
+      event->next = NULL;
+      event->type &= ~EVENT_BATCHED;
+
+      event_run(event);
+      __motSim->nbRanEvents ++;
+   }
+
+   telemetry_poll(__motSim);
 }
 
 /** brief Simulation jusqu'à épuisement des événements
  */
 void motSim_runUntilTheEnd()
 {
-   struct event_t * event;
+   struct event_t * batch;
 
    if (!__motSim->nbRanEvents) {
       __motSim->actualStartTime = time(NULL);
    }
-   while (1) {
-      event = eventFile_extract(__motSim->events);
-      if (event) {
-         printf_debug(DEBUG_EVENT, "next event at %f\n", event_getDate(event));
-         assert(__motSim->currentTime <= event_getDate(event));
-         __motSim->currentTime = event_getDate(event);
-         event_run(event);
-         __motSim->nbRanEvents ++;
-      } else {
-         printf_debug(DEBUG_MOTSIM, "no more event !\n");
-         return ;
-      }
+   while ((__motSim->status == MOTSIM_STATUS_OK) && ((batch = motSim_extractSameDate()) != NULL)) {
+      motSim_runBatch(batch);
    }
+   telemetry_publish(__motSim);
+   printf_debug(DEBUG_MOTSIM, "no more event !\n");
 }
 
 /*
@@ -231,32 +424,83 @@ void motSim_runUntil(motSimDate_t date)
 {
    struct event_t * event;
 
-   //event_periodicAdd(motSim_periodicMessage, NULL, 0.0, date/200.0);
-   alarm(1);
-
    __motSim->finishTime=date;
    if (!__motSim->nbRanEvents) {
       __motSim->actualStartTime = time(NULL);
    }
-   event = eventFile_nextEvent(__motSim->events);
+   event = motSim_nextEvent();
+
+   // Tous les événements de même date sont extraits d'un coup
+   while ((event) && (event_getDate(event) <= date) && (__motSim->status == MOTSIM_STATUS_OK)) {
+      motSim_runBatch(motSim_extractSameDate());
+      event = motSim_nextEvent();
+   }
+   telemetry_publish(__motSim);
+}
 
-   while ((event) && (event_getDate(event) <= date)) {
-      event = eventFile_extract(__motSim->events);
+void motSim_stop(int status)
+{
+   __motSim->status = status;
+}
 
-      printf_debug(DEBUG_EVENT, "next event at %f\n", event_getDate(event));
-      assert(__motSim->currentTime <= event_getDate(event));
-      __motSim->currentTime = event_getDate(event);
-      event_run(event);
-      __motSim->nbRanEvents ++;
-      /*
-afficher le message toutes les 
-      n secondes de temps réel
- ou x % du temps simule passe
-
-   Bof : moins on en rajoute à chaque event, mieux c'est !
-      */
-      event = eventFile_nextEvent(__motSim->events);
+int motSim_getStatus()
+{
+   return __motSim->status;
+}
+
+/*
+ * La précision est évaluée à des dates espacées d'au moins
+ * maxDate/PRECISION_NB_CHECKS et d'au plus 1/PRECISION_STEP_RATIO
+ * de la date courante, ce qui borne le dépassement
+ */
+#define PRECISION_NB_CHECKS  1000
+#define PRECISION_STEP_RATIO   20
+
+static int motSim_precisionReached(struct probe_t ** probes, int nbProbes, double relHalfWidth)
+{
+   double halfWidth, mean;
+   int    n;
+
+   for (n = 0; n < nbProbes; n++) {
+      halfWidth = probe_batchMeansHalfWidth(probes[n]);
+      mean = probe_batchMeansMean(probes[n]);
+      if ((halfWidth < 0.0) || (halfWidth > relHalfWidth * fabs(mean))) {
+         return 0;
+      }
    }
+   return 1;
+}
+
+int motSim_runUntilPrecision(struct probe_t ** probes, int nbProbes,
+			     double relHalfWidth, motSimDate_t maxDate)
+{
+   motSimDate_t step, date;
+   int          n;
+
+   for (n = 0; n < nbProbes; n++) {
+      probe_setBatchMeans(probes[n]);
+   }
+
+   date = __motSim->currentTime;
+   while (date < maxDate) {
+      step = maxDate / PRECISION_NB_CHECKS;
+      if (date / PRECISION_STEP_RATIO > step) {
+         step = date / PRECISION_STEP_RATIO;
+      }
+      date = (step > 0) ? min(date + step, maxDate) : maxDate;
+
+      motSim_runUntil(date);
+      if (motSim_precisionReached(probes, nbProbes, relHalfWidth)) {
+         return 0;
+      }
+
+      // Plus rien à simuler
+      if ((motSim_nextEvent() == NULL) || (__motSim->status != MOTSIM_STATUS_OK)) {
+         break;
+      }
+   }
+
+   return 1;
 }
 
 /*
@@ -268,11 +512,11 @@ void motSim_purge()
    int warnDone = 0;
    printf_debug(DEBUG_MOTSIM, "about to purge events\n");
 
-   event = eventFile_extract(__motSim->events);
+   event = motSim_extractEvent();
 
    while (event){
 
-      printf_debug(DEBUG_MOTSIM, "next event at %f\n", event_getDate(event));
+      printf_debug(DEBUG_MOTSIM, "next event at %f\n", motSim_dateToSeconds(event_getDate(event)));
       assert(__motSim->currentTime <= event_getDate(event));
       __motSim->currentTime = event_getDate(event);
       //      event_run(event);
@@ -281,7 +525,8 @@ void motSim_purge()
          printf_debug(DEBUG_TBD, "Some events have been purged !!\n");
       };
       __motSim->nbRanEvents ++;
-      event = eventFile_extract(__motSim->events);
+      event_free(event);
+      event = motSim_extractEvent();
    }
    printf_debug(DEBUG_MOTSIM, "no more event\n");
 
@@ -315,15 +560,34 @@ void motsim_addToResetList(void * data, void (*resetFunc)(void * data))
 void motSim_reset()
 {
    struct resetClient_t * resetClient;
-
-   // Les événements
-   motSim_purge();
+   long nbQueued;
+
+   // Les événements, qui retournent dans leurs blocs. Si tous ceux
+   // qui sont en vie sont dans les files, elles sont simplement
+   // vidées et les blocs récupérés d'un coup, sinon (un lot en cours
+   // par exemple) on les extrait un par un.
+   nbQueued = eventFile_size(__motSim->events) + eventFile_size(__motSim->timers);
+   if ((!__motSim->pdesLP)
+       && ((long)(__motSim->event_nbCreate - __motSim->event_nbFree) == nbQueued)) {
+      eventFile_clear(__motSim->events);
+      eventFile_clear(__motSim->timers);
+      event_reclaimSlabs(nbQueued);
+   } else {
+      motSim_purge();
+      event_resetSlabs();
+   }
 
    // Le simulateur lui-même
    printf_debug(DEBUG_MOTSIM, "ho yes, once again !\n");
    __motSim->currentTime = 0.0;
    __motSim->nbInsertedEvents = 0;
    __motSim->nbRanEvents = 0;
+   __motSim->nbBatches = 0;
+   __motSim->status = MOTSIM_STATUS_OK;
+
+   // Ce qui était propre à la simulation est rendu d'un coup, avant
+   // que les clients n'y reprennent de la mémoire
+   region_reset();
 
    // Les clients identifiés (probes et autres)
    // Attention, ils vont éventuellement insérer de nouveaux événements
@@ -352,47 +616,73 @@ void motSim_insertNewEvent(void (*run)(void *data), void * data, motSimDate_t da
 
 void motSim_printStatus()
 {
-   printf("[MOTSI] Date = %f\n", __motSim->currentTime);
-   printf("[MOTSI] Events : %ld created (%ld m + %ld r)/%ld freed\n", 
-	  event_nbCreate, event_nbMalloc, event_nbReuse, event_nbFree);
+   printf("[MOTSI] Date = %f\n", motSim_dateToSeconds(__motSim->currentTime));
+   printf("[MOTSI] Event file : %s (%lu resizes), timers : %s (%lu rebuilds)\n",
+	  eventFile_getTypeName(__motSim->events),
+	  eventFile_getNbResize(__motSim->events),
+	  eventFile_getTypeName(__motSim->timers),
+	  eventFile_getNbResize(__motSim->timers));
+   printf("[MOTSI] Events : %ld created (%ld m + %ld r)/%ld freed, %lu slabs of %lu bytes\n", 
+	  __motSim->event_nbCreate, __motSim->event_nbMalloc,
+	  __motSim->event_nbReuse, __motSim->event_nbFree,
+	  __motSim->event_nbSlabs, (unsigned long)sizeof(struct event_t));
    printf("[MOTSI] Simulated events : %d in, %d out, %d pr.\n",
-	  __motSim->nbInsertedEvents, __motSim->nbRanEvents, eventFile_length(__motSim->events));
-   printf("[MOTSI] PDU : %ld created (%ld m + %ld r)/%ld released\n",
-	  probe_nbSamples(PDU_createProbe),
-	  probe_nbSamples(PDU_mallocProbe),
-	  probe_nbSamples(PDU_reuseProbe),
-	  probe_nbSamples(PDU_releaseProbe));
+	  __motSim->nbInsertedEvents, __motSim->nbRanEvents, eventFile_length(__motSim->events)
+	  + eventFile_length(__motSim->timers));
+   printf("[MOTSI] Simulated events : %d executed, %ld cancelled, %ld rescheduled\n",
+	  __motSim->nbRanEvents, __motSim->event_nbCancel, __motSim->event_nbReschedule);
+   printf("[MOTSI] Simulated events : %lu dates (%.2f events per date)\n",
+	  __motSim->nbBatches,
+	  __motSim->nbBatches ? (double)__motSim->nbRanEvents / __motSim->nbBatches : 0.0);
+   printf("[MOTSI] PDU : %ld created (%ld m + %ld r)/%ld released, %lu slabs\n",
+	  __motSim->PDU_nbCreate, __motSim->PDU_nbMalloc,
+	  __motSim->PDU_nbReuse, __motSim->PDU_nbFree,
+	  __motSim->PDU_nbSlabs);
    printf("[MOTSI] Total malloc'ed memory : %ld bytes\n",
 	  __totalMallocSize);
    printf("[MOTSI] Realtime duration : %ld sec\n", time(NULL) - __motSim->actualStartTime);
+#ifdef MOTSIM_PROFILE
+   if (__motSim->profiling) {
+      profiler_printReport(10);
+   }
+#endif
 }
 
-
-/*==========================================================================*/
-/*      Mise en oeuvre de la notion de campagne.                            */ 
-/*==========================================================================*/
-void motSim_campaignRun(struct motSimCampaign_t * c)
+void motSim_getCounters(struct motsim_t * ctx, struct motSimCounters_t * counters)
 {
-   int n;
-   struct resetClient_t * resetClient;
-
-   for (n = 0 ; n < c->nbSimulations; n++){
-      // On réinitialise  tous les éléments liés à la campagne dans sa
-      // globalité. A priori il ne s'agit que des sondes
-      // inter-simulation utilisées pour les intervalles de confiance
-
-
-      for (resetClient = c->resetClient; resetClient; resetClient = resetClient->next) {
-         resetClient->resetFunc(resetClient->data);
-      }
+   if (ctx == NULL) {
+      ctx = __motSim;
+   }
 
+   counters->eventCreated = ctx->event_nbCreate;
+   counters->eventMalloced = ctx->event_nbMalloc;
+   counters->eventReused = ctx->event_nbReuse;
+   counters->eventFreed = ctx->event_nbFree;
+   counters->eventCancelled = ctx->event_nbCancel;
+   counters->eventRescheduled = ctx->event_nbReschedule;
+   counters->PDUCreated = ctx->PDU_nbCreate;
+   counters->PDUMalloced = ctx->PDU_nbMalloc;
+   counters->PDUReused = ctx->PDU_nbReuse;
+   counters->PDUFreed = ctx->PDU_nbFree;
+}
 
-      // On lance l'instance de simulation
- 
-      // On échantillonne les mesures inter-simu
-   }
+void motSim_addCounters(struct motSimCounters_t * total, const struct motSimCounters_t * counters)
+{
+   total->eventCreated += counters->eventCreated;
+   total->eventMalloced += counters->eventMalloced;
+   total->eventReused += counters->eventReused;
+   total->eventFreed += counters->eventFreed;
+   total->eventCancelled += counters->eventCancelled;
+   total->eventRescheduled += counters->eventRescheduled;
+   total->PDUCreated += counters->PDUCreated;
+   total->PDUMalloced += counters->PDUMalloced;
+   total->PDUReused += counters->PDUReused;
+   total->PDUFreed += counters->PDUFreed;
 }
 
+/*==========================================================================*/
+/*      Mise en oeuvre de la notion de campagne (cf campaign.c)             */ 
+/*==========================================================================*/
 void motSim_campaignStat()
 {
    printf("[MOTSI] Number of simulations : %ld\n", probe_nbSamples(__motSim->dureeSimulation));
@@ -7,6 +7,7 @@
 #include <muxdemux.h>
 #include <ndesObject.h>
 #include <ndesObjectFile.h>
+#include <region.h>
 
 /**
  * @brief A multiplexing sender
@@ -55,10 +56,15 @@ struct muxDemuxEncaps_t {
    struct PDU_t * pdu;
 };
 
+/*
+ * An encapsulation only lives during the current simulation, it is
+ * taken from the simulation region (cf region.h) and released by the
+ * next reset
+ */
 struct muxDemuxEncaps_t * muxDemuxEncaps_create(struct muxDemuxSenderSAP_t * sap,
 						struct PDU_t * pdu)
 {
-   struct muxDemuxEncaps_t * result = (struct muxDemuxEncaps_t * )sim_malloc(sizeof(struct muxDemuxEncaps_t ));
+   struct muxDemuxEncaps_t * result = (struct muxDemuxEncaps_t * )motSim_runMalloc(sizeof(struct muxDemuxEncaps_t ));
 
    printf_debug(DEBUG_MUX, "IN for PDU %d in SAPI %d\n", PDU_id(pdu), sap->identifier);
 
@@ -71,7 +77,7 @@ struct muxDemuxEncaps_t * muxDemuxEncaps_create(struct muxDemuxSenderSAP_t * sap
 
 void muxDemuxEncaps_delete(struct muxDemuxEncaps_t * encaps)
 {
-   free(encaps);
+   // Released with the simulation region
 }
 
 /**
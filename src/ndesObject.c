@@ -2,8 +2,10 @@
  
 #include <ndesObject.h>
 #include <log.h>
+#include <motsim-context.h>
+#include <profiler.h>
 
-static int ndesObject_nb = 0;
+// Le compteur d'identifiants est dans le contexte de simulation
 
 /*-----------------------------------------------------------------------
  * Les fonctions de manipulation des ndesObject
@@ -16,7 +18,7 @@ struct ndesObject_t * ndesObject_create(void * private,
 
    result = (struct ndesObject_t *)sim_malloc(sizeof(struct ndesObject_t));
 
-   result->id = ndesObject_nb++;
+   result->id = __motSim->ndesObject_nb++;
    result->name = NULL;
 
    result->creationDate = motSim_getCurrentTime();
@@ -29,6 +31,9 @@ struct ndesObject_t * ndesObject_create(void * private,
                 result->type->name);
    if (result->type != &ndesLogEntryType) {
       ndesLog_logLineF(result, "TYPE %s", result->type->name);
+#ifdef MOTSIM_PROFILE
+      profiler_registerObject(result);
+#endif
    };
 
    return result;
@@ -0,0 +1,1169 @@
+/**
+ * @file pdes.c
+ * @brief Implantation de la simulation parallèle
+ *
+ * Chaque LP est exécuté par un thread.
+ *
+ * En mode conservateur, l'exécution est découpée en fenêtres séparées
+ * par deux barrières :
+ *  - chaque LP récupère les PDU reçues sur ses canaux (elles
+ * deviennent des événements de son échéancier) puis publie la date
+ * de son prochain événement ;
+ *  - après la première barrière, chacun calcule le minimum T de ces
+ * dates et exécute ses événements de date strictement inférieure à
+ * T + L (et inférieure ou égale à la date de fin) ;
+ *  - la seconde barrière garantit que toutes les PDU émises pendant
+ * la fenêtre sont dans les canaux avant qu'on ne les récupère.
+ *
+ * Tous les LP calculent le même T à partir des mêmes valeurs, ils
+ * s'arrêtent donc ensemble lorsque T dépasse la date de fin.
+ *
+ * En mode optimiste, chaque LP exécute jusqu'à batch événements (sans
+ * dépasser le GVT de plus de window) en traitant les messages reçus
+ * au fil de l'eau, puis tous se
+ * retrouvent pour calculer le GVT : après une première barrière plus
+ * personne n'émet, chacun publie le minimum des dates de ses
+ * événements en attente et des messages encore dans ses canaux, et
+ * après la seconde chacun en déduit le même GVT. Les événements
+ * antérieurs au GVT sont alors validés et leur historique libéré.
+ *
+ * Chaque événement exécuté de façon spéculative laisse dans
+ * l'historique de son LP de quoi être défait : une copie de
+ * l'événement, les mots de l'état enregistré qu'il a modifiés (avec
+ * leur ancienne valeur), les événements qu'il a programmés, les
+ * messages qu'il a émis et les PDU qu'il a créées ou libérées (ces
+ * dernières ne sont vraiment libérées qu'à la validation).
+ *
+ * Lors d'un retour arrière, un événement défait est reprogrammé sauf
+ * s'il avait été programmé par un événement lui-même défait : il sera
+ * reprogrammé par la nouvelle exécution de ce dernier.
+ *
+ * Un canal est une liste de segments. L'émetteur écrit en queue et
+ * publie le nombre d'entrées du segment (release), le destinataire
+ * lit en tête (acquire) et libère les segments épuisés. Aucun verrou
+ * n'est nécessaire puisqu'il n'y a qu'un écrivain et qu'un lecteur.
+ */
+#include <stdlib.h>    // Malloc, NULL, ...
+#include <string.h>    // memcmp, memcpy
+#include <assert.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <time.h>      // clock_gettime
+
+#include <pdes.h>
+#include <event.h>
+#include <event-file.h>
+#include <probe.h>
+#include <ndesObject.h>
+#include <motsim-context.h>
+
+#define PDES_SEGMENT_SIZE 256
+
+/*
+ * Un message en mode optimiste. Il est alloué par l'émetteur et
+ * libéré par le destinataire lorsqu'il est validé ou annihilé.
+ */
+struct pdesTWMessage_t {
+   struct pdesChannel_t * channel;
+   struct PDU_t         * pdu;
+   motSimDate_t           date;
+
+   // Côté destinataire
+   struct eventHandle_t   handle;     // L'événement de livraison
+   int                    annihilated;
+   int                    taken;      // La PDU a été prise
+};
+
+/*
+ * Une entrée d'un canal : une PDU et sa date d'arrivée, ou en mode
+ * optimiste un message ou son anti-message
+ */
+struct pdesMessage_t {
+   struct PDU_t           * pdu;
+   motSimDate_t             date;
+   struct pdesTWMessage_t * tw;
+   int                      anti;
+};
+
+struct pdesSegment_t {
+   struct pdesMessage_t            messages[PDES_SEGMENT_SIZE];
+   atomic_int                      nbMessages; // Publiés par l'émetteur
+   struct pdesSegment_t * _Atomic next;
+};
+
+struct pdesChannel_t {
+   struct pdes_t * pdes;
+   int             srcLP, destLP;
+   motSimDate_t    lookahead;
+
+   // L'entité destinataire
+   void          * destination;
+   processPDU_t    destProcessPDU;
+
+   // Côté émetteur
+   struct pdesSegment_t * tail;
+   int                    tailIdx;
+
+   // Côté destinataire
+   struct pdesSegment_t  * head;
+   int                     headIdx;
+
+   struct pdesChannel_t * nextIn; // Canal suivant vers le même LP
+};
+
+/*
+ * Une zone de l'état d'un LP, et sa copie à la fin du dernier
+ * événement exécuté
+ */
+struct pdesState_t {
+   char               * data;
+   char               * shadow;
+   size_t               size;
+   struct pdesState_t * next;
+};
+
+/*
+ * L'ancienne valeur d'un mot de l'état
+ */
+struct pdesUndo_t {
+   char        * data;
+   char        * shadow;
+   int           len;
+   unsigned long old;
+};
+
+struct pdesHistory_t;
+
+/*
+ * Un événement programmé par un événement spéculatif
+ */
+struct pdesChild_t {
+   struct eventHandle_t   handle;
+   struct pdesHistory_t * creator;
+   struct pdesHistory_t * entry;   // Son exécution, le cas échéant
+   struct pdesChild_t   * next;
+};
+
+/*
+ * Une PDU créée, libérée ou émise par un événement spéculatif
+ */
+struct pdesPDURef_t {
+   struct PDU_t           * pdu;
+   struct pdesTWMessage_t * tw;     // Pour une émission
+   motSimDate_t             horizon; // Dans les limbes
+   struct pdesPDURef_t    * next;
+};
+
+/*
+ * Un événement exécuté de façon spéculative
+ */
+struct pdesHistory_t {
+   // Une copie de l'événement
+   motSimDate_t         date;
+   void              (* run)(void * data);
+   void               * data;
+   int                  type;
+   motSimDate_t         period;
+   struct pdesChild_t * origin;  // Qui l'avait programmé
+
+   // Ce qu'il faut défaire
+   struct pdesUndo_t   * undo;
+   int                   nbUndo, maxUndo;
+   struct pdesChild_t  * children;
+   struct pdesPDURef_t * sent;
+   struct pdesPDURef_t * created;
+   struct pdesPDURef_t * freed;
+   motSimDate_t          horizon; // Date du dernier message émis
+
+   int                   undoing;
+   struct pdesHistory_t * prev, * next;
+};
+
+/*
+ * Un processus logique
+ */
+struct pdesLP_t {
+   struct pdes_t        * pdes;
+   struct motsim_t      * ctx;
+   pthread_t              thread;
+   struct pdesChannel_t * in; // Les canaux qui arrivent ici
+
+   // L'état enregistré et l'historique (mode optimiste)
+   struct pdesState_t   * states;
+   struct pdesHistory_t * first, * last;
+   struct pdesHistory_t * executing;
+   struct pdesPDURef_t  * limbo;    // PDU d'événements défaits
+   motSimDate_t           committedTime;
+
+   // Les statistiques
+   unsigned long nbEvents;       // Evénements exécutés
+   unsigned long nbWindows;      // Fenêtres (calculs du GVT)
+   unsigned long nbEmptyWindows; // dont sans aucun événement
+   unsigned long nbSent;         // PDU émises vers d'autres LP
+   unsigned long nbReceived;     // PDU reçues d'autres LP
+   double        blockedTime;    // Temps réel passé aux barrières (s)
+
+   unsigned long nbCommitted;    // Evénements validés
+   unsigned long nbRollbacks;    // Retours arrière
+   unsigned long nbRolledBack;   // Evénements défaits
+   unsigned long nbAntiMessages; // Anti-messages émis
+   struct probe_t * rollbackProbe;
+   struct probe_t * efficiencyProbe;
+};
+
+struct pdes_t {
+   int                nbLP;
+   struct pdesLP_t  * lp;
+   int                currentLP;
+
+   motSimDate_t       lookahead; // Minimum sur tous les canaux
+   int                nbChannels;
+
+   int                optimistic;
+   int                batch;     // Evénements entre deux GVT
+   motSimDate_t       window;    // Avance maximale sur le GVT
+
+   // Pour l'exécution
+   motSimDate_t       finishTime;
+   motSimDate_t     * nextDate;  // Prochain événement de chaque LP
+   pthread_barrier_t  barrier;
+};
+
+struct pdes_t * pdes_create(int nbLP)
+{
+   struct pdes_t * result = (struct pdes_t *)sim_malloc(sizeof(struct pdes_t));
+   int l;
+
+   assert(nbLP > 0);
+
+   result->nbLP = nbLP;
+   result->lp = (struct pdesLP_t *)sim_malloc(nbLP * sizeof(struct pdesLP_t));
+   result->nextDate = (motSimDate_t *)sim_malloc(nbLP * sizeof(motSimDate_t));
+   result->lookahead = MOTSIM_DATE_MAX;
+   result->nbChannels = 0;
+   result->optimistic = 0;
+   result->batch = 0;
+   result->window = MOTSIM_DATE_MAX;
+
+   for (l = 0; l < nbLP; l++) {
+      result->lp[l].pdes = result;
+      motSim_create();
+      result->lp[l].ctx = motSim_getCurrentContext();
+      result->lp[l].in = NULL;
+      result->lp[l].states = NULL;
+      result->lp[l].first = NULL;
+      result->lp[l].last = NULL;
+      result->lp[l].executing = NULL;
+      result->lp[l].limbo = NULL;
+      result->lp[l].committedTime = 0.0;
+      result->lp[l].nbEvents = 0;
+      result->lp[l].nbWindows = 0;
+      result->lp[l].nbEmptyWindows = 0;
+      result->lp[l].nbSent = 0;
+      result->lp[l].nbReceived = 0;
+      result->lp[l].blockedTime = 0.0;
+      result->lp[l].nbCommitted = 0;
+      result->lp[l].nbRollbacks = 0;
+      result->lp[l].nbRolledBack = 0;
+      result->lp[l].nbAntiMessages = 0;
+
+      result->lp[l].rollbackProbe = probe_createMean();
+      probe_setName(result->lp[l].rollbackProbe, "rolled back events");
+      result->lp[l].efficiencyProbe = probe_createMean();
+      probe_setName(result->lp[l].efficiencyProbe, "efficiency");
+   }
+   result->currentLP = 0;
+   motSim_setCurrentContext(result->lp[0].ctx);
+
+   return result;
+}
+
+void pdes_setOptimistic(struct pdes_t * pdes, int batch, motSimDate_t window)
+{
+   assert(batch > 0);
+   assert(window > 0.0);
+   assert(pdes->nbChannels == 0);
+
+   pdes->optimistic = 1;
+   pdes->batch = batch;
+   pdes->window = window;
+}
+
+void pdes_setCurrentLP(struct pdes_t * pdes, int lp)
+{
+   struct motsim_t * from, * to;
+
+   assert((lp >= 0) && (lp < pdes->nbLP));
+   from = pdes->lp[pdes->currentLP].ctx;
+   to = pdes->lp[lp].ctx;
+
+   // Les sources d'aléa sont numérotées comme dans un seul contexte
+   if (from != to) {
+      to->rngSeeded = from->rngSeeded;
+      to->rngSeed = from->rngSeed;
+      to->rngNbStreams = from->rngNbStreams;
+      to->rngAntithetic = from->rngAntithetic;
+   }
+
+   pdes->currentLP = lp;
+   motSim_setCurrentContext(to);
+}
+
+void pdes_registerState(struct pdes_t * pdes, void * data, size_t size)
+{
+   struct pdesLP_t * lp = &pdes->lp[pdes->currentLP];
+   struct pdesState_t * state;
+
+   if (!pdes->optimistic) {
+      return;
+   }
+
+   state = (struct pdesState_t *)sim_malloc(sizeof(struct pdesState_t));
+   state->data = (char *)data;
+   state->shadow = (char *)sim_malloc(size);
+   state->size = size;
+   state->next = lp->states;
+   lp->states = state;
+}
+
+void pdes_registerObject(struct pdes_t * pdes, struct ndesObject_t * object)
+{
+   pdes_registerState(pdes, ndesObject_getPrivate(object),
+		      ndesObject_getType(object)->size);
+}
+
+/*
+ * Somme de deux dates, bornée par MOTSIM_DATE_MAX (qui représente
+ * l'infini, y compris lorsque les dates sont entières)
+ */
+static inline motSimDate_t pdes_dateAdd(motSimDate_t a, motSimDate_t b)
+{
+   return (b >= MOTSIM_DATE_MAX - a) ? MOTSIM_DATE_MAX : a + b;
+}
+
+static struct pdesSegment_t * pdes_segmentCreate()
+{
+   struct pdesSegment_t * result = (struct pdesSegment_t *)sim_malloc(sizeof(struct pdesSegment_t));
+
+   atomic_init(&result->nbMessages, 0);
+   atomic_init(&result->next, NULL);
+
+   return result;
+}
+
+struct pdesChannel_t * pdes_channelCreate(struct pdes_t * pdes,
+					  int destLP,
+					  void * destination,
+					  processPDU_t destProcessPDU,
+					  motSimDate_t lookahead)
+{
+   struct pdesChannel_t * result;
+
+   assert((destLP >= 0) && (destLP < pdes->nbLP));
+   if ((lookahead < 0.0) || ((lookahead == 0.0) && (!pdes->optimistic))) {
+      motSim_error(MS_FATAL, "A channel between LPs needs a positive lookahead\n");
+   }
+
+   result = (struct pdesChannel_t *)sim_malloc(sizeof(struct pdesChannel_t));
+   result->pdes = pdes;
+   result->srcLP = pdes->currentLP;
+   result->destLP = destLP;
+   result->lookahead = lookahead;
+   result->destination = destination;
+   result->destProcessPDU = destProcessPDU;
+
+   result->tail = pdes_segmentCreate();
+   result->tailIdx = 0;
+   result->head = result->tail;
+   result->headIdx = 0;
+
+   result->nextIn = pdes->lp[destLP].in;
+   pdes->lp[destLP].in = result;
+
+   pdes->lookahead = min(pdes->lookahead, lookahead);
+   pdes->nbChannels++;
+
+   return result;
+}
+
+/*
+ * Ajout d'une entrée dans un canal, par le LP émetteur uniquement
+ */
+static void pdes_channelPush(struct pdesChannel_t * channel,
+			     struct pdesMessage_t * message)
+{
+   struct pdesSegment_t * segment = channel->tail;
+
+   if (channel->tailIdx == PDES_SEGMENT_SIZE) {
+      segment = pdes_segmentCreate();
+      atomic_store_explicit(&channel->tail->next, segment, memory_order_release);
+      channel->tail = segment;
+      channel->tailIdx = 0;
+   }
+   segment->messages[channel->tailIdx] = *message;
+   channel->tailIdx++;
+   atomic_store_explicit(&segment->nbMessages, channel->tailIdx, memory_order_release);
+}
+
+void pdes_channelSend(struct pdesChannel_t * channel,
+		      struct PDU_t * pdu,
+		      motSimDate_t date)
+{
+   struct pdesLP_t      * lp = &channel->pdes->lp[channel->srcLP];
+   struct pdesMessage_t   message;
+   struct pdesPDURef_t  * ref;
+
+   assert(date >= motSim_getCurrentTime() + channel->lookahead);
+
+   message.pdu = pdu;
+   message.date = date;
+   message.tw = NULL;
+   message.anti = 0;
+
+   if (channel->pdes->optimistic) {
+      message.tw = (struct pdesTWMessage_t *)sim_malloc(sizeof(struct pdesTWMessage_t));
+      message.tw->channel = channel;
+      message.tw->pdu = pdu;
+      message.tw->date = date;
+      message.tw->annihilated = 0;
+
+      // Pour pouvoir l'annuler
+      if (lp->executing) {
+	 ref = (struct pdesPDURef_t *)sim_malloc(sizeof(struct pdesPDURef_t));
+	 ref->pdu = pdu;
+	 ref->tw = message.tw;
+	 ref->next = lp->executing->sent;
+	 lp->executing->sent = ref;
+	 lp->executing->horizon = max(lp->executing->horizon, date);
+      }
+   }
+
+   pdes_channelPush(channel, &message);
+
+   lp->nbSent++;
+}
+
+/*
+ * Appelée par le LP destinataire uniquement. Renvoie 0 si le canal
+ * est vide.
+ */
+static int pdes_channelReceive(struct pdesChannel_t * channel,
+			       struct pdesMessage_t * message)
+{
+   struct pdesSegment_t * next;
+
+   while (1) {
+      if (channel->headIdx < atomic_load_explicit(&channel->head->nbMessages, memory_order_acquire)) {
+	 *message = channel->head->messages[channel->headIdx++];
+	 return 1;
+      }
+      if (channel->headIdx < PDES_SEGMENT_SIZE) {
+	 return 0;
+      }
+      // Segment épuisé, l'émetteur n'y touchera plus s'il y a une suite
+      next = atomic_load_explicit(&channel->head->next, memory_order_acquire);
+      if (next == NULL) {
+	 return 0;
+      }
+      sim_free(channel->head);
+      channel->head = next;
+      channel->headIdx = 0;
+   }
+}
+
+/*
+ * Plus petite date des entrées d'un canal, sans les retirer. Appelée
+ * par le destinataire lorsque plus personne n'émet.
+ */
+static motSimDate_t pdes_channelMinDate(struct pdesChannel_t * channel)
+{
+   struct pdesSegment_t * segment = channel->head;
+   motSimDate_t result = MOTSIM_DATE_MAX;
+   int idx = channel->headIdx;
+   int n;
+
+   while (segment) {
+      n = atomic_load_explicit(&segment->nbMessages, memory_order_acquire);
+      for (; idx < n; idx++) {
+	 result = min(result, segment->messages[idx].date);
+      }
+      segment = atomic_load_explicit(&segment->next, memory_order_acquire);
+      idx = 0;
+   }
+
+   return result;
+}
+
+/*
+ * Fourniture de la PDU livrée au destinataire (cf llSimplex_getPDU).
+ * Elle est transportée par l'événement de livraison.
+ */
+static struct PDU_t * pdes_deliveryGetPDU(void * e)
+{
+   struct event_t * event = (struct event_t *)e;
+   struct PDU_t * result = (struct PDU_t *)event->args[0].ptr;
+
+   event->args[0].ptr = NULL; // Ce n'est plus à nous de la gérer
+
+   return result;
+}
+
+/*
+ * Arrivée d'une PDU dans le LP destinataire
+ */
+static void pdes_deliver(void * c)
+{
+   struct pdesChannel_t * channel = (struct pdesChannel_t *)c;
+   struct event_t * event = event_getCurrent();
+
+   channel->destProcessPDU(channel->destination, pdes_deliveryGetPDU, event);
+
+   // S'il ne l'a pas prise tout de suite, elle est perdue !
+   PDU_free((struct PDU_t *)event->args[0].ptr);
+}
+
+/*
+ * Les PDU reçues par un LP deviennent des événements de son
+ * échéancier. Les canaux sont toujours parcourus dans le même ordre.
+ */
+static void pdes_drain(struct pdesLP_t * lp)
+{
+   struct pdesChannel_t * channel;
+   struct pdesMessage_t   message;
+   struct event_t       * event;
+
+   for (channel = lp->in; channel; channel = channel->nextIn) {
+      while (pdes_channelReceive(channel, &message)) {
+	 event = event_create(pdes_deliver, channel, message.date);
+	 event_setArg(event, 0, message.pdu);
+	 motSim_addEvent(event);
+	 lp->nbReceived++;
+      }
+   }
+}
+
+static void pdes_barrierWait(struct pdesLP_t * lp)
+{
+   struct timespec before, after;
+
+   clock_gettime(CLOCK_MONOTONIC, &before);
+   pthread_barrier_wait(&lp->pdes->barrier);
+   clock_gettime(CLOCK_MONOTONIC, &after);
+
+   lp->blockedTime += (after.tv_sec - before.tv_sec)
+      + (after.tv_nsec - before.tv_nsec) / 1e9;
+}
+
+static void pdes_runConservativeLP(struct pdesLP_t * lp)
+{
+   struct pdes_t   * pdes = lp->pdes;
+   struct motsim_t * ctx = lp->ctx;
+   struct event_t  * event;
+   motSimDate_t      windowEnd;
+   unsigned long     nbEvents;
+   int l;
+
+   while (1) {
+      pdes_drain(lp);
+
+      event = motSim_nextEvent();
+      pdes->nextDate[lp - pdes->lp] = event ? event_getDate(event) : MOTSIM_DATE_MAX;
+      pdes_barrierWait(lp);
+
+      windowEnd = MOTSIM_DATE_MAX;
+      for (l = 0; l < pdes->nbLP; l++) {
+	 windowEnd = min(windowEnd, pdes->nextDate[l]);
+      }
+      if (windowEnd > pdes->finishTime) {
+	 break;
+      }
+      windowEnd = pdes_dateAdd(windowEnd, pdes->lookahead);
+
+      // Aucune PDU ne peut nous arriver avant windowEnd
+      nbEvents = 0;
+      while ((event) && (event_getDate(event) < windowEnd)
+	     && (event_getDate(event) <= pdes->finishTime)) {
+	 event = motSim_extractEvent();
+	 assert(ctx->currentTime <= event_getDate(event));
+	 ctx->currentTime = event_getDate(event);
+	 event_run(event);
+	 ctx->nbRanEvents++;
+	 nbEvents++;
+	 event = motSim_nextEvent();
+      }
+      lp->nbEvents += nbEvents;
+      lp->nbWindows++;
+      if (!nbEvents) {
+	 lp->nbEmptyWindows++;
+      }
+      telemetry_poll(ctx);
+
+      pdes_barrierWait(lp);
+   }
+}
+
+/*==========================================================================*/
+/*      Le mode optimiste                                                   */
+/*==========================================================================*/
+
+/*
+ * Le LP optimiste dont l'exécution est en cours dans ce thread
+ */
+static inline struct pdesLP_t * pdes_currentLP()
+{
+   return __motSim ? __motSim->pdesLP : NULL;
+}
+
+int pdes_isSpeculative()
+{
+   struct pdesLP_t * lp = pdes_currentLP();
+
+   return (lp) && (lp->executing);
+}
+
+void pdes_eventInserted(struct event_t * event)
+{
+   struct pdesLP_t * lp = pdes_currentLP();
+   struct pdesChild_t * child;
+
+   if ((lp == NULL) || (lp->executing == NULL)) {
+      return;
+   }
+
+   child = (struct pdesChild_t *)sim_malloc(sizeof(struct pdesChild_t));
+   child->handle = event_getHandle(event);
+   child->creator = lp->executing;
+   child->entry = NULL;
+   child->next = lp->executing->children;
+   lp->executing->children = child;
+
+   event->origin = child;
+}
+
+static struct pdesPDURef_t * pdes_PDURefCreate(struct PDU_t * pdu,
+					       struct pdesPDURef_t * next)
+{
+   struct pdesPDURef_t * result = (struct pdesPDURef_t *)sim_malloc(sizeof(struct pdesPDURef_t));
+
+   result->pdu = pdu;
+   result->tw = NULL;
+   result->next = next;
+
+   return result;
+}
+
+void pdes_PDUCreated(struct PDU_t * pdu)
+{
+   struct pdesLP_t * lp = pdes_currentLP();
+
+   if ((lp) && (lp->executing)) {
+      lp->executing->created = pdes_PDURefCreate(pdu, lp->executing->created);
+   }
+}
+
+/*
+ * Une PDU libérée par un événement spéculatif ne l'est vraiment qu'à
+ * sa validation. Renvoie 1 si la libération est différée.
+ */
+int pdes_PDUFreed(struct PDU_t * pdu)
+{
+   struct pdesLP_t * lp = pdes_currentLP();
+
+   if ((lp) && (lp->executing)) {
+      lp->executing->freed = pdes_PDURefCreate(pdu, lp->executing->freed);
+      return 1;
+   }
+   return 0;
+}
+
+static void pdes_PDURefFree(struct pdesPDURef_t * ref, int freePDU)
+{
+   struct pdesPDURef_t * next;
+
+   for (; ref; ref = next) {
+      next = ref->next;
+      if (freePDU) {
+	 PDU_free(ref->pdu);
+      }
+      sim_free(ref);
+   }
+}
+
+/*
+ * Sauvegarde des mots de l'état modifiés par le dernier événement
+ */
+static void pdes_saveState(struct pdesLP_t * lp, struct pdesHistory_t * entry)
+{
+   struct pdesState_t * state;
+   struct pdesUndo_t  * undo;
+   size_t i;
+   int len;
+
+   for (state = lp->states; state; state = state->next) {
+      if (!memcmp(state->data, state->shadow, state->size)) {
+	 continue;
+      }
+      for (i = 0; i < state->size; i += sizeof(unsigned long)) {
+	 len = min(sizeof(unsigned long), state->size - i);
+	 if (!memcmp(state->data + i, state->shadow + i, len)) {
+	    continue;
+	 }
+	 if (entry->nbUndo == entry->maxUndo) {
+	    entry->maxUndo = max(2 * entry->maxUndo, 8);
+	    entry->undo = (struct pdesUndo_t *)realloc(entry->undo, entry->maxUndo * sizeof(struct pdesUndo_t));
+	    assert(entry->undo);
+	 }
+	 undo = &entry->undo[entry->nbUndo++];
+	 undo->data = state->data + i;
+	 undo->shadow = state->shadow + i;
+	 undo->len = len;
+	 memcpy(&undo->old, state->shadow + i, len);
+	 memcpy(state->shadow + i, state->data + i, len);
+      }
+   }
+}
+
+static void pdes_syncState(struct pdesLP_t * lp)
+{
+   struct pdesState_t * state;
+
+   for (state = lp->states; state; state = state->next) {
+      memcpy(state->shadow, state->data, state->size);
+   }
+}
+
+static void pdes_TWDeliver(void * m);
+
+/*
+ * Exécution spéculative du prochain événement
+ */
+static void pdes_executeEvent(struct pdesLP_t * lp)
+{
+   struct motsim_t      * ctx = lp->ctx;
+   struct event_t       * event = motSim_extractEvent();
+   struct pdesHistory_t * entry = (struct pdesHistory_t *)sim_malloc(sizeof(struct pdesHistory_t));
+
+   entry->date = event_getDate(event);
+   entry->run = event->run;
+   entry->data = event->data;
+   entry->type = event->type & (EVENT_PERIODIC | EVENT_TIMER);
+   entry->period = event->period;
+   entry->origin = (struct pdesChild_t *)event->origin;
+   if (entry->origin) {
+      entry->origin->entry = entry;
+   }
+   entry->undo = NULL;
+   entry->nbUndo = 0;
+   entry->maxUndo = 0;
+   entry->children = NULL;
+   entry->sent = NULL;
+   entry->created = NULL;
+   entry->freed = NULL;
+   entry->horizon = entry->date;
+   entry->undoing = 0;
+
+   assert(ctx->currentTime <= entry->date);
+   ctx->currentTime = entry->date;
+
+   lp->executing = entry;
+   event_run(event);
+   lp->executing = NULL;
+
+   pdes_saveState(lp, entry);
+
+   entry->next = NULL;
+   entry->prev = lp->last;
+   if (lp->last) {
+      lp->last->next = entry;
+   } else {
+      lp->first = entry;
+   }
+   lp->last = entry;
+
+   ctx->nbRanEvents++;
+   lp->nbEvents++;
+}
+
+/*
+ * Un événement défait est reprogrammé
+ */
+static void pdes_reinsert(struct pdesLP_t * lp, struct pdesHistory_t * entry)
+{
+   struct event_t * event = event_create(entry->run, entry->data, entry->date);
+
+   event->type = entry->type;
+   event->period = entry->period;
+   event->origin = entry->origin;
+   if (entry->origin) {
+      entry->origin->handle = event_getHandle(event);
+      entry->origin->entry = NULL;
+   }
+   if (entry->run == pdes_TWDeliver) {
+      ((struct pdesTWMessage_t *)entry->data)->handle = event_getHandle(event);
+   }
+   motSim_addEvent(event);
+}
+
+static void pdes_undo(struct pdesLP_t * lp, struct pdesHistory_t * entry)
+{
+   struct pdesChild_t   * child, * nextChild;
+   struct pdesPDURef_t  * ref, * nextRef;
+   struct pdesMessage_t   anti;
+   int i;
+
+   // L'état
+   for (i = entry->nbUndo - 1; i >= 0; i--) {
+      memcpy(entry->undo[i].data, &entry->undo[i].old, entry->undo[i].len);
+      memcpy(entry->undo[i].shadow, &entry->undo[i].old, entry->undo[i].len);
+   }
+   free(entry->undo);
+
+   // Les événements qu'il a programmés et qui attendent encore
+   for (child = entry->children; child; child = nextChild) {
+      nextChild = child->next;
+      event_cancel(child->handle);
+      sim_free(child);
+   }
+
+   // Les messages qu'il a émis
+   for (ref = entry->sent; ref; ref = nextRef) {
+      nextRef = ref->next;
+      anti.pdu = ref->pdu;
+      anti.date = ref->tw->date;
+      anti.tw = ref->tw;
+      anti.anti = 1;
+      pdes_channelPush(ref->tw->channel, &anti);
+      lp->nbAntiMessages++;
+      sim_free(ref);
+   }
+
+   // Les PDU qu'il a libérées sont de nouveau utilisées, celles qu'il
+   // a créées ne le sont plus, mais peuvent encore être désignées par
+   // un message jusqu'à son annihilation
+   pdes_PDURefFree(entry->freed, 0);
+   for (ref = entry->created; ref; ref = nextRef) {
+      nextRef = ref->next;
+      ref->horizon = entry->horizon;
+      ref->next = lp->limbo;
+      lp->limbo = ref;
+   }
+
+   // Il sera reprogrammé par son créateur si celui-ci est défait
+   if (((entry->origin == NULL) || (!entry->origin->creator->undoing))
+       && ((entry->run != pdes_TWDeliver) || (!((struct pdesTWMessage_t *)entry->data)->annihilated))) {
+      pdes_reinsert(lp, entry);
+   }
+
+   lp->ctx->nbRanEvents--;
+   lp->nbRolledBack++;
+}
+
+/*
+ * Retour arrière : les événements de date supérieure à date (ou
+ * égale si inclusive) sont défaits, du plus récent au plus ancien
+ */
+static void pdes_rollback(struct pdesLP_t * lp, motSimDate_t date, int inclusive)
+{
+   struct pdesHistory_t * entry, * stop;
+   int nb = 0;
+
+   for (stop = lp->last;
+	(stop) && ((stop->date > date) || ((inclusive) && (stop->date == date)));
+	stop = stop->prev) {
+      stop->undoing = 1;
+      nb++;
+   }
+   if (nb == 0) {
+      return;
+   }
+
+   lp->ctx->currentTime = stop ? stop->date : lp->committedTime;
+
+   while (lp->last != stop) {
+      entry = lp->last;
+      lp->last = entry->prev;
+      pdes_undo(lp, entry);
+      sim_free(entry);
+   }
+   if (lp->last) {
+      lp->last->next = NULL;
+   } else {
+      lp->first = NULL;
+   }
+
+   lp->nbRollbacks++;
+   probe_sample(lp->rollbackProbe, (double)nb);
+}
+
+/*
+ * Fourniture de la PDU livrée au destinataire. Le message reste
+ * intact pour une éventuelle nouvelle exécution.
+ */
+static struct PDU_t * pdes_TWGetPDU(void * m)
+{
+   struct pdesTWMessage_t * message = (struct pdesTWMessage_t *)m;
+
+   message->taken = 1;
+
+   return message->pdu;
+}
+
+static void pdes_TWDeliver(void * m)
+{
+   struct pdesTWMessage_t * message = (struct pdesTWMessage_t *)m;
+   struct pdesChannel_t * channel = message->channel;
+
+   message->taken = 0;
+   channel->destProcessPDU(channel->destination, pdes_TWGetPDU, message);
+
+   // S'il ne l'a pas prise tout de suite, elle est perdue !
+   if (!message->taken) {
+      PDU_free(message->pdu);
+   }
+}
+
+/*
+ * Traitement des messages et anti-messages reçus
+ */
+static void pdes_TWDrain(struct pdesLP_t * lp)
+{
+   struct pdesChannel_t   * channel;
+   struct pdesMessage_t     message;
+   struct pdesTWMessage_t * tw;
+   struct event_t         * event;
+
+   for (channel = lp->in; channel; channel = channel->nextIn) {
+      while (pdes_channelReceive(channel, &message)) {
+	 tw = message.tw;
+	 if (!message.anti) {
+	    // Un retardataire ?
+	    if (tw->date < lp->ctx->currentTime) {
+	       pdes_rollback(lp, tw->date, 0);
+	    }
+	    event = event_create(pdes_TWDeliver, tw, tw->date);
+	    tw->handle = event_getHandle(event);
+	    motSim_addEvent(event);
+	    lp->nbReceived++;
+	 } else {
+	    // Annihilation, avec retour arrière s'il a déjà été livré
+	    tw->annihilated = 1;
+	    if (!event_cancel(tw->handle)) {
+	       pdes_rollback(lp, tw->date, 1);
+	    }
+	    sim_free(tw);
+	 }
+      }
+   }
+}
+
+/*
+ * Validation des événements antérieurs au GVT
+ */
+static void pdes_fossilCollect(struct pdesLP_t * lp, motSimDate_t gvt)
+{
+   struct pdesHistory_t * entry;
+   struct pdesChild_t   * child, * nextChild;
+   struct pdesPDURef_t  * ref, ** prev;
+
+   while ((lp->first) && (lp->first->date < gvt)) {
+      entry = lp->first;
+      lp->first = entry->next;
+
+      free(entry->undo);
+      for (child = entry->children; child; child = nextChild) {
+	 nextChild = child->next;
+	 // Il n'est plus défaisable, son créateur non plus
+	 if (event_isPending(child->handle)) {
+	    child->handle.event->origin = NULL;
+	 }
+	 if (child->entry) {
+	    child->entry->origin = NULL;
+	 }
+	 sim_free(child);
+      }
+      pdes_PDURefFree(entry->sent, 0);
+      pdes_PDURefFree(entry->created, 0);
+      pdes_PDURefFree(entry->freed, 1);
+      if (entry->run == pdes_TWDeliver) {
+	 sim_free(entry->data);
+      }
+
+      lp->committedTime = entry->date;
+      lp->nbCommitted++;
+      sim_free(entry);
+   }
+   if (lp->first) {
+      lp->first->prev = NULL;
+   } else {
+      lp->last = NULL;
+   }
+
+   // Les PDU qu'aucun message ne peut plus désigner
+   prev = &lp->limbo;
+   while ((ref = *prev) != NULL) {
+      if (ref->horizon < gvt) {
+	 *prev = ref->next;
+	 PDU_free(ref->pdu);
+	 sim_free(ref);
+      } else {
+	 prev = &ref->next;
+      }
+   }
+}
+
+static void pdes_runOptimisticLP(struct pdesLP_t * lp)
+{
+   struct pdes_t   * pdes = lp->pdes;
+   struct motsim_t * ctx = lp->ctx;
+   struct event_t  * event;
+   struct pdesChannel_t * channel;
+   motSimDate_t      gvt, local, horizon;
+   unsigned long     nbEvents, nbCommitted;
+   int l;
+
+   ctx->pdesLP = lp;
+   pdes_syncState(lp);
+   horizon = min(pdes_dateAdd(lp->committedTime, pdes->window), pdes->finishTime);
+
+   while (1) {
+      nbEvents = lp->nbEvents;
+      nbCommitted = lp->nbCommitted;
+
+      // Exécution spéculative
+      for (l = 0; l < pdes->batch; l++) {
+	 pdes_TWDrain(lp);
+	 event = motSim_nextEvent();
+	 if ((event == NULL) || (event_getDate(event) > horizon)) {
+	    break;
+	 }
+	 pdes_executeEvent(lp);
+      }
+
+      // Calcul du GVT
+      pdes_barrierWait(lp);
+      event = motSim_nextEvent();
+      local = event ? event_getDate(event) : MOTSIM_DATE_MAX;
+      for (channel = lp->in; channel; channel = channel->nextIn) {
+	 local = min(local, pdes_channelMinDate(channel));
+      }
+      pdes->nextDate[lp - pdes->lp] = local;
+      pdes_barrierWait(lp);
+
+      gvt = MOTSIM_DATE_MAX;
+      for (l = 0; l < pdes->nbLP; l++) {
+	 gvt = min(gvt, pdes->nextDate[l]);
+      }
+      pdes_fossilCollect(lp, gvt);
+
+      lp->nbWindows++;
+      if (lp->nbEvents == nbEvents) {
+	 lp->nbEmptyWindows++;
+      } else {
+	 probe_sample(lp->efficiencyProbe,
+		      (double)(lp->nbCommitted - nbCommitted) / (lp->nbEvents - nbEvents));
+      }
+      telemetry_poll(ctx);
+
+      if (gvt > pdes->finishTime) {
+	 break;
+      }
+      horizon = min(pdes_dateAdd(gvt, pdes->window), pdes->finishTime);
+   }
+
+   // Tout ce qui a été exécuté est validé
+   pdes_fossilCollect(lp, MOTSIM_DATE_MAX);
+   ctx->pdesLP = NULL;
+}
+
+static void * pdes_runLP(void * arg)
+{
+   struct pdesLP_t * lp = (struct pdesLP_t *)arg;
+   struct pdes_t   * pdes = lp->pdes;
+   struct motsim_t * ctx = lp->ctx;
+
+   motSim_setCurrentContext(ctx);
+   ctx->finishTime = pdes->finishTime;
+   if (!ctx->nbRanEvents) {
+      ctx->actualStartTime = time(NULL);
+   }
+
+   if (pdes->optimistic) {
+      pdes_runOptimisticLP(lp);
+   } else {
+      pdes_runConservativeLP(lp);
+   }
+   telemetry_publish(ctx);
+
+   motSim_setCurrentContext(NULL);
+
+   return NULL;
+}
+
+void pdes_reset(struct pdes_t * pdes)
+{
+   struct motsim_t * current = motSim_getCurrentContext();
+   int l;
+
+   for (l = 0; l < pdes->nbLP; l++) {
+      motSim_setCurrentContext(pdes->lp[l].ctx);
+      motSim_reset();
+      pdes->lp[l].committedTime = 0.0;
+   }
+   motSim_setCurrentContext(current);
+}
+
+void pdes_runUntil(struct pdes_t * pdes, motSimDate_t date)
+{
+   struct motsim_t * current;
+   int l;
+
+   pdes->finishTime = date;
+   pthread_barrier_init(&pdes->barrier, NULL, pdes->nbLP);
+
+   // Les contextes des LP ne sont manipulés que par leur thread
+   current = motSim_setCurrentContext(NULL);
+
+   for (l = 0; l < pdes->nbLP; l++) {
+      if (pthread_create(&pdes->lp[l].thread, NULL, pdes_runLP, &pdes->lp[l])) {
+         motSim_error(MS_FATAL, "Can't create thread for LP %d\n", l);
+      }
+   }
+   for (l = 0; l < pdes->nbLP; l++) {
+      pthread_join(pdes->lp[l].thread, NULL);
+   }
+
+   motSim_setCurrentContext(current);
+   pthread_barrier_destroy(&pdes->barrier);
+}
+
+struct probe_t * pdes_getRollbackProbe(struct pdes_t * pdes, int lp)
+{
+   return pdes->lp[lp].rollbackProbe;
+}
+
+struct probe_t * pdes_getEfficiencyProbe(struct pdes_t * pdes, int lp)
+{
+   return pdes->lp[lp].efficiencyProbe;
+}
+
+void pdes_printStatus(struct pdes_t * pdes)
+{
+   struct pdesLP_t * lp;
+   int l;
+
+   printf("[PDES ] %d LP (%s), %d channels, lookahead %f\n",
+	  pdes->nbLP, pdes->optimistic ? "optimistic" : "conservative",
+	  pdes->nbChannels, motSim_dateToSeconds(pdes->lookahead));
+   for (l = 0; l < pdes->nbLP; l++) {
+      lp = &pdes->lp[l];
+      printf("[PDES ] LP %d : %lu events, %lu windows (%lu empty), %lu PDU sent, %lu received, %.3f sec blocked\n",
+	     l, lp->nbEvents, lp->nbWindows, lp->nbEmptyWindows,
+	     lp->nbSent, lp->nbReceived, lp->blockedTime);
+      if (pdes->optimistic) {
+	 printf("[PDES ] LP %d : %lu committed, %lu rolled back in %lu rollbacks, %lu anti-messages, efficiency %f\n",
+		l, lp->nbCommitted, lp->nbRolledBack, lp->nbRollbacks,
+		lp->nbAntiMessages,
+		lp->nbEvents ? (double)lp->nbCommitted / lp->nbEvents : 1.0);
+      }
+   }
+}
@@ -16,6 +16,7 @@
 
 #include <event.h>
 #include <pdu-source.h>
+#include <checkpoint.h>
 
 #include <log.h>
 
@@ -46,6 +47,56 @@ struct ndesObjectType_t PDUSourceType = {
   ndesObjectTypeDefaultValues(PDUSource)
 };
 
+void PDUSource_buildNewPDU(struct PDUSource_t * source);
+
+/*
+ * Sauvegarde des PDU en cours (cf checkpoint.h), la date de la
+ * prochaine émission est celle de l'événement en attente
+ */
+static void PDUSource_checkpointSave(struct checkpoint_t * cp, void * data)
+{
+   struct PDUSource_t * source = (struct PDUSource_t *)data;
+
+   checkpoint_writePDU(cp, source->pdu);
+   checkpoint_writePDU(cp, source->nextPdu);
+   checkpoint_write(cp, &source->detNextIdx, sizeof(source->detNextIdx));
+}
+
+static void PDUSource_checkpointRestore(struct checkpoint_t * cp, void * data)
+{
+   struct PDUSource_t * source = (struct PDUSource_t *)data;
+
+   if (source->pdu) {
+      PDU_free(source->pdu);
+   }
+   if (source->nextPdu) {
+      PDU_free(source->nextPdu);
+   }
+   source->pdu = checkpoint_readPDU(cp);
+   source->nextPdu = checkpoint_readPDU(cp);
+   checkpoint_read(cp, &source->detNextIdx, sizeof(source->detNextIdx));
+}
+
+/*
+ * Réinitialisation avant une nouvelle simulation (cf motSim_reset) :
+ * les PDU en attente sont abandonnées et la source repart de sa date
+ * de démarrage
+ */
+static void PDUSource_reset(struct PDUSource_t * source)
+{
+   if (source->nextPdu) {
+      PDU_free(source->nextPdu);
+      source->nextPdu = NULL;
+   }
+   if (source->dateGen) {
+      dateGenerator_rewind(source->dateGen);
+   } else {
+      source->detNextIdx = 0;
+   }
+
+   PDUSource_start(source);
+}
+
 struct PDUSource_t * PDUSource_create(struct dateGenerator_t * dateGen,
 				      void * destination,
 				      processPDU_t destProcessPDU)
@@ -68,7 +119,12 @@ struct PDUSource_t * PDUSource_create(struct dateGenerator_t * dateGen,
    result->detNextIdx = 0;
 
    // Ajout à la liste des choses à réinitialiser avant une prochaine simu
-   motsim_addToResetList(result, (void (*)(void *))PDUSource_start);
+   motsim_addToResetList(result, (void (*)(void *))PDUSource_reset);
+
+   // Et à celle des choses à sauvegarder (cf motSim_checkpoint)
+   motSim_addToCheckpointList(result, "PDUSource", PDUSource_checkpointSave, PDUSource_checkpointRestore);
+   checkpoint_registerFunction(PDUSource_buildNewPDU);
+   checkpoint_registerFunction(PDUSource_getPDU);
    
    return result;
 }
@@ -226,7 +282,7 @@ void PDUSource_buildNewPDU(struct PDUSource_t * source)
    if (source->pdu) { // La première fois, c'est un coup à blanc
       // Transmission de la nouvelle PDU
       printf_debug(DEBUG_SRC, " PDU %d (size %u) sent at %6.3f\n",
-                   PDU_id(source->pdu), PDU_size(source->pdu),motSim_getCurrentTime());
+                   PDU_id(source->pdu), PDU_size(source->pdu),motSim_dateToSeconds(motSim_getCurrentTime()));
 
       // On enregistre dans la probe s'il y en a une
       if (source->PDUGenerationSizeProbe) {
@@ -273,7 +329,7 @@ void PDUSource_buildNewPDU(struct PDUSource_t * source)
       size = source->sizeGen?randomGenerator_getNextUInt(source->sizeGen):0;
    }
 
-   printf_debug(DEBUG_SRC, " next PDU to be sent at %f\n", date);
+   printf_debug(DEBUG_SRC, " next PDU to be sent at %f\n", motSim_dateToSeconds(date));
 
    // 3 - Création de la PDU et programmation de sa transmission si la
    // date n'est pas dépassée. Si elle l'est, la source s'arrète
@@ -282,7 +338,7 @@ void PDUSource_buildNewPDU(struct PDUSource_t * source)
       source->nextPdu = PDU_create(size, NULL); 
 
       printf_debug(DEBUG_SRC, " next PDU %d (size %u) created at %6.3f\n",  
-                PDU_id(source->nextPdu), size,motSim_getCurrentTime());
+                PDU_id(source->nextPdu), size,motSim_dateToSeconds(motSim_getCurrentTime()));
 
       // On crée un événement pour cette date
       event = event_create((eventAction_t)PDUSource_buildNewPDU, source, date);
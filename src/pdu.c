@@ -3,6 +3,8 @@
 
 #include <pdu.h>
 #include <ndesObject.h>
+#include <motsim-context.h>
+#include <pdes.h>
 
 /* WARNING
  * Le type est visible car utilisé par différents modules vu que c'est
@@ -11,40 +13,72 @@
  * fournies plus bas.
  */
 struct PDU_t {
-   declareAsNdesObject;
-
-   int      id;    // Un identifiant général
-   motSimDate_t  creationDate;
-
-   void   * data;  // Des donnees privées
-   int      taille ;
+   declareAsNdesObject;    // Créé à la demande, cf PDU_getObject
 
    // Les pointeurs suivants sont à la discrétion du propriétaire de la PDU
    // WARNING c'est une horreur à virer
-   struct PDU_t * prev;
    struct PDU_t * next;
+   struct PDU_t * prev;
+
+   void   * data;  // Des donnees privées
+
+   unsigned long long id;    // Un identifiant général
+   motSimDate_t  creationDate;
+
+   int      taille ;  // En dernier, seul champ de 4 octets
 };
 
-/**
- * @brief Déclaration des fonctions spécifiques liées au ndesObject
+/*
+ * Les PDU sont découpées dans des blocs de PDU_SLAB_SIZE, alignés sur
+ * les lignes de cache, plutôt qu'allouées une par une. Les PDU
+ * libérées sont réutilisées en priorité (liste des libres), puis on
+ * poursuit la découpe du bloc courant. Les blocs ne sont rendus qu'à
+ * la destruction du contexte (cf PDU_freeSlabs).
  */
-declareObjectFunctions(PDU);
+#define PDU_SLAB_SIZE   256
+#define PDU_CACHE_LINE   64
 
-/**
- * @brief Définition des fonctions spécifiques liées au ndesObject
+struct PDUSlab_t {
+   struct PDU_t       PDUs[PDU_SLAB_SIZE];
+   int                nbUsed; // Nombre de PDU déjà découpées
+   struct PDUSlab_t * next;
+};
+
+/*
+ * Une nouvelle PDU prise dans le bloc courant, qui est le premier de
+ * la liste, ou dans un nouveau bloc
  */
-defineObjectFunctions(PDU);
+static struct PDU_t * PDU_slabAlloc()
+{
+   struct PDUSlab_t * slab = __motSim->PDUSlabs;
+   void * mem = NULL;
+
+   if ((slab == NULL) || (slab->nbUsed == PDU_SLAB_SIZE)) {
+      if (posix_memalign(&mem, PDU_CACHE_LINE, sizeof(struct PDUSlab_t))) {
+         motSim_error(MS_FATAL, "PDU slab allocation failed\n");
+      }
+      __totalMallocSize += sizeof(struct PDUSlab_t);
+      __motSim->PDU_nbSlabs++;
 
-static int pduNB = 0;
+      slab = (struct PDUSlab_t *)mem;
+      slab->nbUsed = 0;
+      slab->next = __motSim->PDUSlabs;
+      __motSim->PDUSlabs = slab;
+   }
 
-// Pour suivre un peu l'origine des PDU
-struct probe_t * PDU_createProbe;
-struct probe_t * PDU_reuseProbe;
-struct probe_t * PDU_mallocProbe;
-struct probe_t * PDU_releaseProbe;
+   return &slab->PDUs[slab->nbUsed++];
+}
 
-// Pointeur sur une PDU libre (pour accélerer alloc/free)
-struct PDU_t * firstFreePDU = NULL;
+void PDU_freeSlabs(struct motsim_t * ctx)
+{
+   struct PDUSlab_t * slab;
+
+   while ((slab = ctx->PDUSlabs) != NULL) {
+      ctx->PDUSlabs = slab->next;
+      free(slab);
+   }
+   ctx->firstFreePDU = NULL;
+}
 
 /**
  * @brief Les entrées de log sont des ndesObject
@@ -53,11 +87,56 @@ struct ndesObjectType_t PDUType = {
   ndesObjectTypeDefaultValues(PDU)
 };
 
+/*
+ * L'en-tête ndesObject n'est créé que si on le demande (pour le log,
+ * le profilage ou un nom) : la plupart des PDU n'en ont jamais
+ * besoin. Le log et le profileur gardent un pointeur sur l'en-tête,
+ * il est donc abandonné à la libération de la PDU plutôt que détruit.
+ */
+struct ndesObject_t * PDU_getObject(struct PDU_t * o)
+{
+   if (o->ndesObject == NULL) {
+      ndesObjectInit(o, PDU);
+   }
+   return o->ndesObject;
+}
+
+void PDU_setObject(struct PDU_t * o, struct ndesObject_t * ndesObject)
+{
+   o->ndesObject = ndesObject;
+}
+
+int PDU_getObjectId(struct PDU_t * o)
+{
+   return PDU_getObject(o)->id;
+}
+
+void PDU_setName(struct PDU_t * o, const char * n)
+{
+   PDU_getObject(o)->name = strdup(n);
+}
+
+char * PDU_getName(struct PDU_t * o)
+{
+   return o->ndesObject ? o->ndesObject->name : NULL;
+}
+
+/*
+ * Le compteur d'identifiants, les PDU libres (pour accélerer
+ * alloc/free), les compteurs et les éventuelles sondes qui permettent
+ * de suivre un peu l'origine des PDU sont dans le contexte de
+ * simulation courant
+ */
+
 int PDU_size(struct PDU_t * PDU){
    return PDU->taille;
 }
 
 int PDU_id(struct PDU_t * PDU){
+   return (int)PDU->id;
+}
+
+unsigned long long PDU_getId(struct PDU_t * PDU){
    return PDU->id;
 }
 
@@ -73,28 +152,52 @@ struct PDU_t * PDU_create(int size, void * private)
 {
    struct PDU_t * PDU ;
 
-   if (firstFreePDU){
-      PDU = firstFreePDU;
-      firstFreePDU = PDU->next;
+   if (__motSim->firstFreePDU){
+      PDU = __motSim->firstFreePDU;
+      __motSim->firstFreePDU = PDU->next;
       assert(PDU);
-      probe_sample(PDU_reuseProbe, (double)PDU->id);
+      __motSim->PDU_nbReuse++;
+      if (__motSim->PDU_reuseProbe) {
+         probe_sample(__motSim->PDU_reuseProbe, (double)PDU->id);
+      }
    } else {
-      PDU = (struct PDU_t *)sim_malloc(sizeof(struct PDU_t));
-      assert(PDU);
-      probe_sample(PDU_mallocProbe, (double)PDU->id);
+      PDU = PDU_slabAlloc();
+      __motSim->PDU_nbMalloc++;
+      if (__motSim->PDU_mallocProbe) {
+         probe_sample(__motSim->PDU_mallocProbe, (double)__motSim->pduNB);
+      }
    }
 
-   ndesObjectInit(PDU, PDU);
+   PDU->ndesObject = NULL;
    PDU->taille = size;
-   PDU->id = pduNB ++;
+   PDU->id = __motSim->pduNB ++;
    PDU->data = private;
    PDU->creationDate = motSim_getCurrentTime();
    PDU->next = NULL;
    PDU->prev = NULL;
 
-   probe_sample(PDU_createProbe, (double)PDU->id);
+   // Les sondes sont détachées pendant une restauration (cf checkpoint.c)
+   __motSim->PDU_nbCreate++;
+   if (__motSim->PDU_createProbe) {
+      probe_sample(__motSim->PDU_createProbe, (double)PDU->id);
+   }
 
-   printf_debug(DEBUG_FILE, "PDU %d created (size %d)\n", PDU->id, PDU->taille);
+   if (__motSim->pdesLP) {
+      pdes_PDUCreated(PDU);
+   }
+
+   printf_debug(DEBUG_FILE, "PDU %llu created (size %d)\n", PDU->id, PDU->taille);
+
+   return PDU;
+}
+
+struct PDU_t * PDU_restore(int size, void * private, unsigned long long id,
+                           motSimDate_t creationDate)
+{
+   struct PDU_t * PDU = PDU_create(size, private);
+
+   PDU->id = id;
+   PDU->creationDate = creationDate;
 
    return PDU;
 }
@@ -105,12 +208,51 @@ struct PDU_t * PDU_create(int size, void * private)
  */
 void PDU_free(struct PDU_t * pdu)
 {
+   // En mode optimiste, la libération peut être différée
+   if ((pdu != NULL) && (__motSim->pdesLP) && (pdes_PDUFreed(pdu))) {
+      return;
+   }
+
    if (pdu != NULL) {
-      probe_sample(PDU_releaseProbe, (double)pdu->id);
+      __motSim->PDU_nbFree++;
+      if (__motSim->PDU_releaseProbe) {
+         probe_sample(__motSim->PDU_releaseProbe, (double)pdu->id);
+      }
+
+      pdu->next = __motSim->firstFreePDU;
+      __motSim->firstFreePDU = pdu;
+   }
+}
+
+void PDU_freeChain(struct PDU_t * first, struct PDU_t * last, int nb)
+{
+   struct PDU_t * pdu, * next;
+
+   if (first == NULL) {
+      return;
+   }
+
+   // Dans un LP, chacune doit passer par pdes_PDUFreed
+   if (__motSim->pdesLP) {
+      for (pdu = first; pdu != NULL; pdu = next) {
+         next = (pdu == last) ? NULL : pdu->next;
+         PDU_free(pdu);
+      }
+      return;
+   }
 
-      pdu->next = firstFreePDU;
-      firstFreePDU = pdu;
+   __motSim->PDU_nbFree += nb;
+   if (__motSim->PDU_releaseProbe) {
+      for (pdu = first; ; pdu = pdu->next) {
+         probe_sample(__motSim->PDU_releaseProbe, (double)pdu->id);
+         if (pdu == last) {
+            break;
+         }
+      }
    }
+
+   last->next = __motSim->firstFreePDU;
+   __motSim->firstFreePDU = first;
 }
 
 /**
@@ -150,3 +292,15 @@ void PDU_setPrev(struct PDU_t * pdu, struct PDU_t * prev)
 {
    pdu->prev = prev;
 }
+
+/*
+ * Les sondes système ne sont alimentées que si on les attache
+ */
+void PDU_setSystemProbes(struct probe_t * create, struct probe_t * reuse,
+                         struct probe_t * alloc, struct probe_t * release)
+{
+   __motSim->PDU_createProbe = create;
+   __motSim->PDU_reuseProbe = reuse;
+   __motSim->PDU_mallocProbe = alloc;
+   __motSim->PDU_releaseProbe = release;
+}
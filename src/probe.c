@@ -4,9 +4,10 @@
  * Attention à la structure des sondes exhaustives, le parcours en
  * lecture n'est pas forcément intuitif ...
  *
- * De plus, lors du reset, on libère la mémoire, ce qui prend du temps
- * et nécessite de les réallouer pour la simulation suivante. On
- * pourrait les conserver, non ?
+ * Lors du reset, les blocs d'une sonde exhaustive sont conservés : la
+ * sonde est simplement rembobinée sur le premier, et les suivants sont
+ * réutilisés au fil des échantillons de la simulation suivante (cf
+ * probe_exhaustiveNextSet).
  */
 
 
@@ -24,6 +25,17 @@
 #include <motsim.h>
 #include <event.h>
 #include <probe.h>
+#include <checkpoint.h>
+#include <motsim-context.h>
+
+/*
+ * Les sondes conservent leurs dates en secondes, quelle que soit la
+ * représentation des dates du simulateur (cf motSim_dateToSeconds)
+ */
+static inline double probe_now()
+{
+   return motSim_dateToSeconds(motSim_getCurrentTime());
+}
 
 /**
  * @brief Structure permettant la gestion des sondes exhaustives
@@ -98,6 +110,89 @@ struct EMA_t {
    double previousAvg, previousBwAvg;
 };
 
+/*
+ * Fenêtre de mesure : les échantillons pris hors de [start, end[ (ou
+ * avant la détection de la fin du régime transitoire par la sonde
+ * detector) sont ignorés
+ */
+struct measureWindow_t {
+   double           start;
+   double           end;       // Pas de fin si end <= start
+   struct probe_t * detector;  // NULL si la fenêtre ne dépend que des dates
+};
+
+/*
+ * Une suite de lots d'échantillons, dont seule la moyenne est
+ * conservée dans un tableau de capacity lots fourni par le
+ * propriétaire. Lorsque tous les lots sont remplis, ils sont
+ * fusionnés deux à deux et la taille des lots double : la mémoire
+ * utilisée est bornée. Sert à la détection du régime transitoire, aux
+ * intervalles par lots et à la détection d'instabilité.
+ */
+struct batchSeries_t {
+   unsigned long batchSize;
+   unsigned long initialSize;
+   int           nbBatches;
+   int           capacity;
+   double        batchSum;       // Le lot en cours
+   unsigned long nbInBatch;
+   double      * means;
+};
+
+/*
+ * Détection en ligne de la fin du régime transitoire (MSER-5) sur une
+ * suite de PROBE_WARMUP_NB_BATCHES lots de 5 échantillons au départ.
+ */
+#define PROBE_WARMUP_BATCH_SIZE   5
+#define PROBE_WARMUP_NB_BATCHES 512
+#define PROBE_WARMUP_MIN_TAIL    16  // Nombre minimal de lots conservés
+#define PROBE_WARMUP_CHECK       16  // Le test est fait tous les 16 lots
+
+struct warmup_t {
+   struct batchSeries_t series;
+   int           detected;
+   double        date;           // Date de la détection
+   unsigned long truncation;     // Nombre d'échantillons à écarter
+   double        means[PROBE_WARMUP_NB_BATCHES];
+};
+
+/*
+ * Intervalle de confiance par la méthode des lots (batch means). Le
+ * nombre de lots reste entre PROBE_BM_NB_BATCHES/2 et
+ * PROBE_BM_NB_BATCHES, les lots deviennent ainsi assez longs pour que
+ * leurs moyennes soient indépendantes, ce qui est vérifié sur leur
+ * autocorrélation.
+ */
+#define PROBE_BM_NB_BATCHES 64
+
+struct batchMeans_t {
+   struct batchSeries_t series;
+   double        means[PROBE_BM_NB_BATCHES];
+};
+
+/*
+ * Détection d'une croissance durable (d'une file instable par
+ * exemple). A chaque fusion des lots, on applique le test de
+ * tendance de Mann-Kendall à leurs moyennes : la croissance doit être
+ * significative à PROBE_INSTAB_CONFIRM fusions successives, donc sur
+ * un horizon multiplié par 2^PROBE_INSTAB_CONFIRM, pour qu'un simple
+ * régime transitoire ne soit pas pris pour une instabilité.
+ */
+#define PROBE_INSTAB_NB_BATCHES   64
+#define PROBE_INSTAB_MIN_SAMPLES 1024  // Avant le premier test
+#define PROBE_INSTAB_CONFIRM        4
+#define PROBE_INSTAB_THRESHOLD    3.0  // Sur la statistique normalisée
+
+struct instability_t {
+   struct batchSeries_t series;
+   unsigned long nbSamples;
+   int           nbConfirmed;   // Tests successifs positifs
+   int           detected;
+   void (*unstable)(struct probe_t * p, void * data);
+   void        * data;
+   double        means[PROBE_INSTAB_NB_BATCHES];
+};
+
 /*
  * Structure générale d'une sonde
  */
@@ -126,6 +221,16 @@ struct probe_t {
    // Une sonde persistante n'est jamais réinitialisée
    int persistent;
 
+   // Fenêtre de mesure et détection du régime permanent (ou NULL)
+   struct measureWindow_t * measureWindow;
+   struct warmup_t        * warmup;
+
+   // Intervalle de confiance par lots (ou NULL)
+   struct batchMeans_t    * batchMeans;
+
+   // Détection d'instabilité (ou NULL)
+   struct instability_t   * instability;
+
    // Les métas sondes
    struct probe_t * sampleProbe;      // Sur les échantillons
    struct probe_t * meanProbe;        // Sur la moyenne
@@ -140,9 +245,374 @@ struct probe_t {
    struct probe_t * next;
 };
 
+/*
+ * La chaine de toutes les probes du système est dans le contexte de
+ * simulation courant (__motSim->firstProbe)
+ */
+
+/*==========================================================================*/
+/*      Suites de lots                                                      */
+/*==========================================================================*/
+
+static void batchSeries_reset(struct batchSeries_t * bs)
+{
+   bs->batchSize = bs->initialSize;
+   bs->nbBatches = 0;
+   bs->batchSum = 0.0;
+   bs->nbInBatch = 0;
+}
+
+static void batchSeries_init(struct batchSeries_t * bs, double * means,
+			     int capacity, unsigned long initialSize)
+{
+   bs->means = means;
+   bs->capacity = capacity;
+   bs->initialSize = initialSize;
+   batchSeries_reset(bs);
+}
+
+/*
+ * Ajout d'un échantillon. Renvoie 1 s'il complète un lot, que
+ * l'appelant peut alors examiner avant batchSeries_merge.
+ */
+static int batchSeries_sample(struct batchSeries_t * bs, double value)
+{
+   bs->batchSum += value;
+   if (++bs->nbInBatch < bs->batchSize) {
+      return 0;
+   }
+   bs->means[bs->nbBatches++] = bs->batchSum / bs->batchSize;
+   bs->batchSum = 0.0;
+   bs->nbInBatch = 0;
+
+   return 1;
+}
+
+/*
+ * Plus de place : les lots sont fusionnés deux à deux
+ */
+static void batchSeries_merge(struct batchSeries_t * bs)
+{
+   int n;
+
+   if (bs->nbBatches < bs->capacity) {
+      return;
+   }
+   for (n = 0; n < bs->capacity / 2; n++) {
+      bs->means[n] = (bs->means[2 * n] + bs->means[2 * n + 1]) / 2.0;
+   }
+   bs->nbBatches = bs->capacity / 2;
+   bs->batchSize *= 2;
+}
+
+/*
+ * Seuls les lots remplis sont sauvegardés, la capacité est celle du
+ * modèle
+ */
+static void batchSeries_checkpointSave(struct checkpoint_t * cp, struct batchSeries_t * bs)
+{
+   checkpoint_write(cp, &bs->batchSize, sizeof(bs->batchSize));
+   checkpoint_write(cp, &bs->nbBatches, sizeof(bs->nbBatches));
+   checkpoint_write(cp, &bs->batchSum, sizeof(bs->batchSum));
+   checkpoint_write(cp, &bs->nbInBatch, sizeof(bs->nbInBatch));
+   checkpoint_write(cp, bs->means, bs->nbBatches * sizeof(double));
+}
+
+static void batchSeries_checkpointRestore(struct checkpoint_t * cp, struct batchSeries_t * bs)
+{
+   checkpoint_read(cp, &bs->batchSize, sizeof(bs->batchSize));
+   checkpoint_read(cp, &bs->nbBatches, sizeof(bs->nbBatches));
+   checkpoint_read(cp, &bs->batchSum, sizeof(bs->batchSum));
+   checkpoint_read(cp, &bs->nbInBatch, sizeof(bs->nbInBatch));
+   if ((bs->nbBatches < 0) || (bs->nbBatches > bs->capacity)) {
+      checkpoint_setError(cp);
+      batchSeries_reset(bs);
+   }
+   checkpoint_read(cp, bs->means, bs->nbBatches * sizeof(double));
+}
+
+/*==========================================================================*/
+/*      Fenêtres de mesure et régime transitoire                            */
+/*==========================================================================*/
+
+static void probe_warmupReset(struct warmup_t * w)
+{
+   batchSeries_reset(&w->series);
+   w->detected = 0;
+   w->date = 0.0;
+   w->truncation = 0;
+}
+
+/*
+ * Le critère MSER : pour chaque troncature d (en lots), on calcule la
+ * variance de la moyenne des lots restants, divisée par leur
+ * nombre. Le régime transitoire est considéré terminé si le minimum
+ * est atteint dans la première moitié des lots, sinon il faut encore
+ * attendre.
+ */
+static void probe_warmupTest(struct warmup_t * w)
+{
+   struct batchSeries_t * bs = &w->series;
+   double sum = 0.0, sumSq = 0.0, x, mser, best = 0.0;
+   double ref = bs->means[bs->nbBatches - 1]; // Contre les erreurs d'arrondi
+   int    d, k, bestD = -1;
+
+   // Les sommes sur [d, nbBatches[ sont faites de la fin vers le début
+   for (d = bs->nbBatches - 1; d >= 0; d--) {
+      x = bs->means[d] - ref;
+      sum += x;
+      sumSq += x * x;
+      k = bs->nbBatches - d;
+      if (k < PROBE_WARMUP_MIN_TAIL) {
+         continue;
+      }
+      mser = (sumSq - sum * sum / k) / ((double)k * k);
+      if ((bestD < 0) || (mser <= best)) {
+         best = mser;
+         bestD = d;
+      }
+   }
+
+   if ((bestD >= 0) && (bestD < bs->nbBatches / 2)) {
+      w->detected = 1;
+      w->date = probe_now();
+      w->truncation = bestD * bs->batchSize;
+   }
+}
+
+static void probe_warmupSample(struct warmup_t * w, double value)
+{
+   struct batchSeries_t * bs = &w->series;
+
+   if ((w->detected) || (!batchSeries_sample(bs, value))) {
+      return;
+   }
+
+   if ((!(bs->nbBatches % PROBE_WARMUP_CHECK)) && (bs->nbBatches >= 4 * PROBE_WARMUP_MIN_TAIL)) {
+      probe_warmupTest(w);
+   }
+   batchSeries_merge(bs);
+}
+
+static int probe_inMeasureWindow(struct probe_t * probe)
+{
+   struct measureWindow_t * w = probe->measureWindow;
+   double now = probe_now();
+
+   if (now < w->start) {
+      return 0;
+   }
+   if ((w->end > w->start) && (now >= w->end)) {
+      return 0;
+   }
+   if ((w->detector) && (!probe_warmupDetected(w->detector))) {
+      return 0;
+   }
+   return 1;
+}
+
+static struct measureWindow_t * probe_getMeasureWindow(struct probe_t * p)
+{
+   if (p->measureWindow == NULL) {
+      p->measureWindow = (struct measureWindow_t *)sim_malloc(sizeof(struct measureWindow_t));
+      p->measureWindow->start = 0.0;
+      p->measureWindow->end = 0.0;
+      p->measureWindow->detector = NULL;
+   }
+   return p->measureWindow;
+}
+
+void probe_setMeasureWindow(struct probe_t * p, double start, double end)
+{
+   struct measureWindow_t * w = probe_getMeasureWindow(p);
+
+   w->start = start;
+   w->end = end;
+}
+
+void probe_setWarmupDetector(struct probe_t * p)
+{
+   if (p->warmup == NULL) {
+      p->warmup = (struct warmup_t *)sim_malloc(sizeof(struct warmup_t));
+      batchSeries_init(&p->warmup->series, p->warmup->means,
+		       PROBE_WARMUP_NB_BATCHES, PROBE_WARMUP_BATCH_SIZE);
+      probe_warmupReset(p->warmup);
+   }
+}
+
+void probe_startAfterWarmup(struct probe_t * p, struct probe_t * detector)
+{
+   assert(detector != p);
+
+   probe_setWarmupDetector(detector);
+   probe_getMeasureWindow(p)->detector = detector;
+}
+
+int probe_warmupDetected(struct probe_t * p)
+{
+   return (p->warmup) && (p->warmup->detected);
+}
+
+double probe_warmupDate(struct probe_t * p)
+{
+   return probe_warmupDetected(p) ? p->warmup->date : 0.0;
+}
+
+unsigned long probe_warmupTruncation(struct probe_t * p)
+{
+   return probe_warmupDetected(p) ? p->warmup->truncation : 0;
+}
+
+/*==========================================================================*/
+/*      Intervalles de confiance par lots                                   */
+/*==========================================================================*/
+
+static void probe_batchMeansSample(struct batchMeans_t * bm, double value)
+{
+   if (batchSeries_sample(&bm->series, value)) {
+      batchSeries_merge(&bm->series);
+   }
+}
+
+void probe_setBatchMeans(struct probe_t * p)
+{
+   if (p->batchMeans == NULL) {
+      p->batchMeans = (struct batchMeans_t *)sim_malloc(sizeof(struct batchMeans_t));
+      batchSeries_init(&p->batchMeans->series, p->batchMeans->means, PROBE_BM_NB_BATCHES, 1);
+   }
+}
+
+double probe_batchMeansMean(struct probe_t * p)
+{
+   struct batchMeans_t * bm = p->batchMeans;
+   double sum = 0.0;
+   int    n;
+
+   if ((bm == NULL) || (bm->series.nbBatches == 0)) {
+      return 0.0;
+   }
+   for (n = 0; n < bm->series.nbBatches; n++) {
+      sum += bm->means[n];
+   }
+   return sum / bm->series.nbBatches;
+}
+
+/*
+ * La demi-largeur est t(k-1).s/sqrt(k) sur les k lots complets, le
+ * quantile de Student étant approché par le développement de
+ * Cornish-Fisher à partir de celui de la loi normale.
+ */
+double probe_batchMeansHalfWidth(struct probe_t * p)
+{
+   struct batchMeans_t * bm = p->batchMeans;
+   double mean, var = 0.0, cov = 0.0, z = 1.96, t;
+   int    n, k;
+
+   if ((bm == NULL) || (bm->series.nbBatches < PROBE_BM_NB_BATCHES / 2)) {
+      return -1.0;
+   }
+   k = bm->series.nbBatches;
+   mean = probe_batchMeansMean(p);
+   for (n = 0; n < k; n++) {
+      var += (bm->means[n] - mean) * (bm->means[n] - mean);
+      if (n > 0) {
+         cov += (bm->means[n] - mean) * (bm->means[n - 1] - mean);
+      }
+   }
+
+   // Des lots encore corrélés ne donnent pas d'intervalle valide
+   if ((var > 0.0) && (cov / var > 2.0 / sqrt(k))) {
+      return -1.0;
+   }
+
+   t = z + (z * z * z + z) / (4.0 * (k - 1));
+   return t * sqrt(var / (k - 1) / k);
+}
+
+/*==========================================================================*/
+/*      Détection d'instabilité                                             */
+/*==========================================================================*/
+
+static void probe_instabilityReset(struct instability_t * s)
+{
+   batchSeries_reset(&s->series);
+   s->nbSamples = 0;
+   s->nbConfirmed = 0;
+   s->detected = 0;
+}
+
+/*
+ * Statistique normalisée de Mann-Kendall sur les moyennes des lots
+ * (sans correction pour les ex aequo)
+ */
+static double probe_instabilityTrend(struct instability_t * s)
+{
+   double S = 0.0, var;
+   int    i, j, k = s->series.nbBatches;
+
+   for (i = 0; i < k - 1; i++) {
+      for (j = i + 1; j < k; j++) {
+         S += (s->means[j] > s->means[i]) - (s->means[j] < s->means[i]);
+      }
+   }
+   var = k * (k - 1.0) * (2.0 * k + 5.0) / 18.0;
+
+   return (S > 0.0) ? (S - 1.0) / sqrt(var) : 0.0;
+}
+
+static void probe_instabilitySample(struct probe_t * probe, double value)
+{
+   struct instability_t * s = probe->instability;
+
+   if (s->detected) {
+      return;
+   }
+
+   s->nbSamples++;
+   if ((!batchSeries_sample(&s->series, value))
+       || (s->series.nbBatches < s->series.capacity)) {
+      return;
+   }
+
+   // Tous les lots sont pleins : test puis fusion
+   if (s->nbSamples >= PROBE_INSTAB_MIN_SAMPLES) {
+      if (probe_instabilityTrend(s) > PROBE_INSTAB_THRESHOLD) {
+         s->nbConfirmed++;
+      } else {
+         s->nbConfirmed = 0;
+      }
+   }
+   batchSeries_merge(&s->series);
+
+   if (s->nbConfirmed >= PROBE_INSTAB_CONFIRM) {
+      s->detected = 1;
+      printf_debug(DEBUG_PROBE, "\"%s\" is growing after %lu samples\n",
+		   probe_getName(probe), s->nbSamples);
+      if (s->unstable) {
+         s->unstable(probe, s->data);
+      } else {
+         motSim_stop(MOTSIM_STATUS_UNSTABLE);
+      }
+   }
+}
+
+void probe_setInstabilityDetector(struct probe_t * p,
+				  void (*unstable)(struct probe_t * p, void * data),
+				  void * data)
+{
+   if (p->instability == NULL) {
+      p->instability = (struct instability_t *)sim_malloc(sizeof(struct instability_t));
+      batchSeries_init(&p->instability->series, p->instability->means, PROBE_INSTAB_NB_BATCHES, 1);
+      probe_instabilityReset(p->instability);
+   }
+   p->instability->unstable = unstable;
+   p->instability->data = data;
+}
 
-// Pointeur sur la chaine de toutes les probes du système
-struct probe_t * firstProbe = NULL;
+int probe_instabilityDetected(struct probe_t * p)
+{
+   return (p->instability) && (p->instability->detected);
+}
 
 
 /**
@@ -178,17 +648,62 @@ struct probe_t * probe_chain(struct probe_t * p1, struct probe_t * p2)
    return p1;
 }
 
+/*
+ * Les échantillons sont oubliés, mais les blocs sont conservés : on se
+ * replace sur le premier (nbSamples est remis à 0 par l'appelant)
+ */
 void probe_resetExhaustive(struct probe_t * probe)
+{
+   if (probe->data.sampleSet) {
+      while (probe->data.sampleSet->prev) {
+         probe->data.sampleSet = probe->data.sampleSet->prev;
+      }
+   }
+}
+
+/*
+ * Libération effective de tous les blocs
+ */
+static void probe_freeExhaustive(struct probe_t * probe)
 {
    struct sampleSet_t * ss;
 
+   probe_resetExhaustive(probe);
    while (probe->data.sampleSet) {
-      ss = probe->data.sampleSet->prev;
+      ss = probe->data.sampleSet->next;
       free(probe->data.sampleSet);
       probe->data.sampleSet = ss;
    }
 }
 
+/*
+ * Le bloc où ranger l'échantillon numéro nbSamples, qui doit être le
+ * premier d'un bloc : celui sur lequel la sonde a été rembobinée, le
+ * suivant s'il a été conservé, ou un nouveau.
+ */
+static struct sampleSet_t * probe_exhaustiveNextSet(struct probe_t * probe)
+{
+   struct sampleSet_t * currentSet = probe->data.sampleSet;
+
+   if ((currentSet) && (probe->nbSamples == 0)) {
+      return currentSet;
+   }
+   if ((currentSet) && (currentSet->next)) {
+      probe->data.sampleSet = currentSet->next;
+      return probe->data.sampleSet;
+   }
+
+   printf_debug(DEBUG_PROBE_VERB, "building new set\n");
+   probe->data.sampleSet = (struct sampleSet_t *) sim_malloc(sizeof(struct sampleSet_t));
+   probe->data.sampleSet->prev = currentSet;
+   probe->data.sampleSet->next = NULL;
+   if (currentSet) {
+      currentSet->next = probe->data.sampleSet;
+   }
+
+   return probe->data.sampleSet;
+}
+
 void probe_resetGraphBar(struct probe_t * probe)
 {
    int i;
@@ -231,7 +746,7 @@ void probe_periodicReset(struct probe_t * pr)
 
    // On déclanche un échantillon du cumul à 0 + t
 
-   ev = event_create((void (*)(void *))probe_scheduleNextEvent, pr, pr->period);
+   ev = event_timerCreate((void (*)(void *))probe_scheduleNextEvent, pr, motSim_secondsToDate(pr->period));
    printf_debug(DEBUG_PROBE, "premiere moyenne a %f ms pour %s\n", pr->period, pr->name);
    motSim_addEvent(ev);
 }
@@ -247,7 +762,7 @@ void probe_timeSliceReset(struct probe_t * pr)
    probe_reset(pr->data.timeSlice->bwProbe);
 
    // On déclanche un échantillon du cumul à 0 + t
-   ev = event_create((void (*)(void *))probe_scheduleNextEvent, pr, pr->period);
+   ev = event_timerCreate((void (*)(void *))probe_scheduleNextEvent, pr, motSim_secondsToDate(pr->period));
    printf_debug(DEBUG_PROBE, "premiere moyenne a %f ms(ev %p)\n", pr->period, ev);
    motSim_addEvent(ev);
 }
@@ -300,9 +815,180 @@ void probe_reset(struct probe_t * probe)
    probe->lastSample = 0;
    probe->lastSampleDate = 0;
 
+   // La fenêtre de mesure est conservée, la détection recommence
+   if (probe->warmup) {
+      probe_warmupReset(probe->warmup);
+   }
+   if (probe->batchMeans) {
+      batchSeries_reset(&probe->batchMeans->series);
+   }
+   if (probe->instability) {
+      probe_instabilityReset(probe->instability);
+   }
+
    printf_debug(DEBUG_PROBE, "reset \"%s\"\n", probe_getName(probe));
 }
 
+/*
+ * Sauvegarde de l'état d'une sonde (cf checkpoint.h). Les sondes
+ * associées (méta sondes, tranches, ...) sont sauvegardées pour leur
+ * propre compte. Les échantillons d'une sonde exhaustive sont écrits
+ * par blocs, du plus ancien au plus récent.
+ */
+static void probe_checkpointSave(struct checkpoint_t * cp, void * data)
+{
+   struct probe_t     * probe = (struct probe_t *)data;
+   struct sampleSet_t * set;
+   unsigned long        n, nb;
+
+   checkpoint_write(cp, &probe->probeType, sizeof(probe->probeType));
+   checkpoint_write(cp, &probe->nbSamples, sizeof(probe->nbSamples));
+   checkpoint_write(cp, &probe->min, sizeof(probe->min));
+   checkpoint_write(cp, &probe->max, sizeof(probe->max));
+   checkpoint_write(cp, &probe->lastSample, sizeof(probe->lastSample));
+   checkpoint_write(cp, &probe->lastSampleDate, sizeof(probe->lastSampleDate));
+
+   switch (probe->probeType) {
+      case exhaustiveProbeType :
+         for (set = probe->data.sampleSet; (set) && (set->prev); set = set->prev);
+         for (n = 0; n < probe->nbSamples; n += nb, set = set->next) {
+            nb = min(PROBE_NB_SAMPLES_MAX, probe->nbSamples - n);
+            checkpoint_write(cp, set->dates, nb * sizeof(double));
+            checkpoint_write(cp, set->samples, nb * sizeof(double));
+         }
+      break;
+      case meanProbeType :
+         checkpoint_write(cp, probe->data.mean, sizeof(struct mean_t));
+      break;
+      case timeSliceAverageProbeType :
+      case timeSliceThroughputProbeType :
+         checkpoint_write(cp, &probe->data.timeSlice->valueSum, sizeof(double));
+         checkpoint_write(cp, &probe->data.timeSlice->nbSamplesInSlice, sizeof(int));
+      break;
+      case graphBarProbeType :
+         checkpoint_write(cp, &probe->data.graphBar->nbBar, sizeof(unsigned long));
+         checkpoint_write(cp, &probe->data.graphBar->normalized, sizeof(int));
+         checkpoint_write(cp, probe->data.graphBar->value,
+                          probe->data.graphBar->nbBar * sizeof(double));
+      break;
+      case EMAProbeType :
+         checkpoint_write(cp, probe->data.ema, sizeof(struct EMA_t));
+      break;
+      case slidingWindowProbeType :
+         checkpoint_write(cp, &probe->data.window->capacity, sizeof(int));
+         checkpoint_write(cp, &probe->data.window->length, sizeof(int));
+         checkpoint_write(cp, &probe->data.window->last, sizeof(int));
+         checkpoint_write(cp, probe->data.window->dates, probe->data.window->capacity * sizeof(double));
+         checkpoint_write(cp, probe->data.window->samples, probe->data.window->capacity * sizeof(double));
+      break;
+      case periodicProbeType :
+      break;
+   }
+
+   if (probe->warmup) {
+      batchSeries_checkpointSave(cp, &probe->warmup->series);
+      checkpoint_write(cp, &probe->warmup->detected, sizeof(int));
+      checkpoint_write(cp, &probe->warmup->date, sizeof(double));
+      checkpoint_write(cp, &probe->warmup->truncation, sizeof(unsigned long));
+   }
+   if (probe->batchMeans) {
+      batchSeries_checkpointSave(cp, &probe->batchMeans->series);
+   }
+   if (probe->instability) {
+      batchSeries_checkpointSave(cp, &probe->instability->series);
+      checkpoint_write(cp, &probe->instability->nbSamples, sizeof(unsigned long));
+      checkpoint_write(cp, &probe->instability->nbConfirmed, sizeof(int));
+      checkpoint_write(cp, &probe->instability->detected, sizeof(int));
+   }
+}
+
+static void probe_checkpointRestore(struct checkpoint_t * cp, void * data)
+{
+   struct probe_t     * probe = (struct probe_t *)data;
+   struct sampleSet_t * set = NULL;
+   enum probeType_t     probeType;
+   unsigned long        n, nb, nbBar;
+   int                  capacity;
+
+   checkpoint_read(cp, &probeType, sizeof(probeType));
+   if (probeType != probe->probeType) {
+      checkpoint_setError(cp);
+      return;
+   }
+   checkpoint_read(cp, &probe->nbSamples, sizeof(probe->nbSamples));
+   checkpoint_read(cp, &probe->min, sizeof(probe->min));
+   checkpoint_read(cp, &probe->max, sizeof(probe->max));
+   checkpoint_read(cp, &probe->lastSample, sizeof(probe->lastSample));
+   checkpoint_read(cp, &probe->lastSampleDate, sizeof(probe->lastSampleDate));
+
+   switch (probe->probeType) {
+      case exhaustiveProbeType :
+         probe_freeExhaustive(probe);
+         for (n = 0; n < probe->nbSamples; n += nb) {
+            nb = min(PROBE_NB_SAMPLES_MAX, probe->nbSamples - n);
+            set = (struct sampleSet_t *) sim_malloc(sizeof(struct sampleSet_t));
+            set->prev = probe->data.sampleSet;
+            set->next = NULL;
+            if (set->prev) {
+               set->prev->next = set;
+            }
+            probe->data.sampleSet = set;
+            checkpoint_read(cp, set->dates, nb * sizeof(double));
+            checkpoint_read(cp, set->samples, nb * sizeof(double));
+         }
+      break;
+      case meanProbeType :
+         checkpoint_read(cp, probe->data.mean, sizeof(struct mean_t));
+      break;
+      case timeSliceAverageProbeType :
+      case timeSliceThroughputProbeType :
+         checkpoint_read(cp, &probe->data.timeSlice->valueSum, sizeof(double));
+         checkpoint_read(cp, &probe->data.timeSlice->nbSamplesInSlice, sizeof(int));
+      break;
+      case graphBarProbeType :
+         checkpoint_read(cp, &nbBar, sizeof(unsigned long));
+         if (nbBar != probe->data.graphBar->nbBar) {
+            checkpoint_setError(cp);
+            return;
+         }
+         checkpoint_read(cp, &probe->data.graphBar->normalized, sizeof(int));
+         checkpoint_read(cp, probe->data.graphBar->value, nbBar * sizeof(double));
+      break;
+      case EMAProbeType :
+         checkpoint_read(cp, probe->data.ema, sizeof(struct EMA_t));
+      break;
+      case slidingWindowProbeType :
+         checkpoint_read(cp, &capacity, sizeof(int));
+         if (capacity != probe->data.window->capacity) {
+            checkpoint_setError(cp);
+            return;
+         }
+         checkpoint_read(cp, &probe->data.window->length, sizeof(int));
+         checkpoint_read(cp, &probe->data.window->last, sizeof(int));
+         checkpoint_read(cp, probe->data.window->dates, capacity * sizeof(double));
+         checkpoint_read(cp, probe->data.window->samples, capacity * sizeof(double));
+      break;
+      case periodicProbeType :
+      break;
+   }
+
+   if (probe->warmup) {
+      batchSeries_checkpointRestore(cp, &probe->warmup->series);
+      checkpoint_read(cp, &probe->warmup->detected, sizeof(int));
+      checkpoint_read(cp, &probe->warmup->date, sizeof(double));
+      checkpoint_read(cp, &probe->warmup->truncation, sizeof(unsigned long));
+   }
+   if (probe->batchMeans) {
+      batchSeries_checkpointRestore(cp, &probe->batchMeans->series);
+   }
+   if (probe->instability) {
+      batchSeries_checkpointRestore(cp, &probe->instability->series);
+      checkpoint_read(cp, &probe->instability->nbSamples, sizeof(unsigned long));
+      checkpoint_read(cp, &probe->instability->nbConfirmed, sizeof(int));
+      checkpoint_read(cp, &probe->instability->detected, sizeof(int));
+   }
+}
+
 /*
  * Création générale. Attention, toute création de probe doit passer
  * par là.
@@ -327,17 +1013,27 @@ struct probe_t * probe_createRaw(enum probeType_t probeType)
    // Default is no filter
    result->filter = NULL;
 
+   // Ni fenêtre de mesure, ni détection du régime permanent
+   result->measureWindow = NULL;
+   result->warmup = NULL;
+   result->batchMeans = NULL;
+   result->instability = NULL;
+
    // Les métas probes
    result->meanProbe = NULL;
    result->throughputProbe = NULL;
    result->sampleProbe = NULL;
 
-   result->next = firstProbe;
-   firstProbe = result;
+   result->next = __motSim->firstProbe;
+   __motSim->firstProbe = result;
 
    // Ajout à la liste des choses à réinitialiser avant une prochaine simu
    motsim_addToResetList(result, (void (*)(void * data)) probe_reset);
 
+   // Et à celle des choses à sauvegarder (cf motSim_checkpoint)
+   motSim_addToCheckpointList(result, "probe", probe_checkpointSave, probe_checkpointRestore);
+   checkpoint_registerFunction(probe_scheduleNextEvent);
+
    //printf_debug(DEBUG_PROBE, "A \"%s\" has been created\n" probeTypeName(probeType));
    printf_debug(DEBUG_PROBE, "out\n");
 
@@ -356,7 +1052,7 @@ struct probe_t * probe_periodicCreate(double t)
    result->period = t;
 
    // On déclanche un échantillon du cumul à 0 + t
-   ev = event_create((void (*)(void *))probe_scheduleNextEvent, result, result->period);
+   ev = event_timerCreate((void (*)(void *))probe_scheduleNextEvent, result, motSim_secondsToDate(result->period));
    printf_debug(DEBUG_PROBE, "premiere moyenne a %f ms(ev %p) pour \"%s\"\n", result->period, ev, result->name);
    motSim_addEvent(ev);
 
@@ -465,8 +1161,8 @@ void probe_scheduleNextEvent(struct probe_t * pr)
    }
 
    // On programme la prochaine
-   motSim_addEvent(event_create((void (*)(void *))probe_scheduleNextEvent, pr,
-				motSim_getCurrentTime() + pr->period));
+   motSim_addEvent(event_timerCreate((void (*)(void *))probe_scheduleNextEvent, pr,
+				     motSim_getCurrentTime() + motSim_secondsToDate(pr->period)));
 
 }
 
@@ -488,7 +1184,7 @@ struct probe_t * probe_createTimeSliceAverage(double t)
    result->data.timeSlice->bwProbe = probe_createExhaustive();
 
    // On déclanche un échantillon du cumul à 0 + t
-   ev = event_create((void (*)(void *))probe_scheduleNextEvent, result, result->period);
+   ev = event_timerCreate((void (*)(void *))probe_scheduleNextEvent, result, motSim_secondsToDate(result->period));
    printf_debug(DEBUG_PROBE, "premiere moyenne a %f ms(ev %p)\n", result->period, ev);
    motSim_addEvent(ev);
 
@@ -528,9 +1224,9 @@ void probe_sampleMean(struct probe_t * pr, double value)
 {
    pr->data.mean->valueSum += value;
    if (pr->nbSamples == 0) {
-      pr->data.mean->firstDate = motSim_getCurrentTime();
+      pr->data.mean->firstDate = probe_now();
    }
-   pr->data.mean->lastDate = motSim_getCurrentTime();
+   pr->data.mean->lastDate = probe_now();
 }
 
 void probe_timeSliceSample(struct probe_t * pr, double value)
@@ -569,7 +1265,7 @@ void probe_delete(struct probe_t * p)
  */
 void probe_resetAllProbes()
 {
-   struct probe_t * probe = firstProbe;
+   struct probe_t * probe = __motSim->firstProbe;
 
    printf_debug(DEBUG_PROBE, "reseting probes ...\n");
 
@@ -588,19 +1284,10 @@ void probe_sampleExhaustive(struct probe_t * probe, double value)
    printf_debug(DEBUG_PROBE_VERB, "%p \"%s\" : nbSamples=%ld, value = %f\n", probe, probe_getName(probe), probe->nbSamples, value);
 
    if(!(probe->nbSamples % PROBE_NB_SAMPLES_MAX)) {
-      printf_debug(DEBUG_PROBE_VERB, "building new set\n");
-      probe->data.sampleSet = (struct sampleSet_t *) sim_malloc(sizeof(struct sampleSet_t));
-
-      probe->data.sampleSet->prev = currentSet;
-      probe->data.sampleSet->next = NULL;
-      if (currentSet) {
-	 currentSet->next = probe->data.sampleSet;
-      }
-      currentSet = probe->data.sampleSet;
-      //      printf_debug(DEBUG_ALWAYS, "***(pr %p, %s) New set built : %p %p\n", probe, probe_getName(probe), probe->data.sampleSet, probe->data.sampleSet->prev);
+      currentSet = probe_exhaustiveNextSet(probe);
    }
   
-   currentSet->dates[probe->nbSamples%PROBE_NB_SAMPLES_MAX] = motSim_getCurrentTime();
+   currentSet->dates[probe->nbSamples%PROBE_NB_SAMPLES_MAX] = probe_now();
    currentSet->samples[probe->nbSamples%PROBE_NB_SAMPLES_MAX] = value;
    printf_debug(DEBUG_PROBE_VERB, "OUT\n");
 }
@@ -670,7 +1357,7 @@ void probe_slidingWindowSample(struct probe_t * pr, double v)
 
    // On met le truc dans le machin
    pr->data.window->samples[pr->data.window->last] = v;
-   pr->data.window->dates[pr->data.window->last] = motSim_getCurrentTime();
+   pr->data.window->dates[pr->data.window->last] = probe_now();
 }
 
 /*
@@ -854,7 +1541,7 @@ void probe_EMASample(struct probe_t * probe, double value)
    //ici, cumuler et mémoriser lastValue, ... pas tres beau, mais faut avancer !
 
    // Tant que le temps n'avance pas, on cumule les valeurs
-   if (motSim_getCurrentTime() == probe->lastSampleDate) {
+   if (probe_now() == probe->lastSampleDate) {
       probe->data.ema->value += value;
    } else {
       // Le temps a avancé, on redémarre le cumul à la date actuelle
@@ -871,18 +1558,18 @@ void probe_EMASample(struct probe_t * probe, double value)
       // les cumule (sinon, durée nulle => débit infini)
       if (probe->data.ema->previousTime == 0.0) {
          probe->data.ema->avg = probe->data.ema->value;
-         probe->data.ema->bwAvg =  (motSim_getCurrentTime()-probe->data.ema->previousTime);
+         probe->data.ema->bwAvg =  (probe_now()-probe->data.ema->previousTime);
 	 //         probe->data.ema->bwAvg = probe->data.ema->value * 8.0 / (motSim_getCurrentTime()-probe->data.ema->previousTime);
       } else {
          probe->data.ema->avg = probe->data.ema->a * probe->data.ema->previousAvg + (1.0 - probe->data.ema->a) * probe->data.ema->value;
-         probe->data.ema->bwAvg = probe->data.ema->a * probe->data.ema->previousBwAvg + (1.0 - probe->data.ema->a) *(motSim_getCurrentTime()-probe->data.ema->previousTime);
+         probe->data.ema->bwAvg = probe->data.ema->a * probe->data.ema->previousBwAvg + (1.0 - probe->data.ema->a) *(probe_now()-probe->data.ema->previousTime);
 	 //         probe->data.ema->bwAvg = probe->data.ema->a * probe->data.ema->previousBwAvg + (1.0 - probe->data.ema->a) * probe->data.ema->value * 8.0 / (motSim_getCurrentTime()-probe->data.ema->previousTime);
       }
       printf_debug(DEBUG_PROBE_VERB, "in \"%s\" (sample %f): %f b/ %f s (ov=%f/v=%f/b=%f/ob=%f)\n",
 	 	probe_getName(probe),
 		value,
 		probe->data.ema->value,
-                motSim_getCurrentTime()-probe->data.ema->previousTime,
+                probe_now()-probe->data.ema->previousTime,
 		probe->data.ema->avg,
 		probe->data.ema->previousAvg,
 		probe->data.ema->bwAvg,
@@ -923,6 +1610,11 @@ void probe_doSample(struct probe_t * probe, double value)
 {
    if (probe==NULL)
       return;
+
+   // Hors de la fenêtre de mesure, l'échantillon n'est pas conservé
+   if ((probe->measureWindow) && (!probe_inMeasureWindow(probe))) {
+      return;
+   }
    printf_debug(DEBUG_PROBE_VERB, "about to sample %f in \"%s\" (%p, type %s, %lu samples)\n",
 		value,
 		probe_getName(probe), probe,
@@ -968,7 +1660,7 @@ void probe_doSample(struct probe_t * probe, double value)
 
    }
    probe->lastSample = value;
-   probe->lastSampleDate = motSim_getCurrentTime();
+   probe->lastSampleDate = probe_now();
 
    if (probe->nbSamples == 0) {
       probe->min = value;
@@ -979,6 +1671,16 @@ void probe_doSample(struct probe_t * probe, double value)
    }
    probe->nbSamples++;
 
+   if (probe->warmup) {
+      probe_warmupSample(probe->warmup, value);
+   }
+   if (probe->batchMeans) {
+      probe_batchMeansSample(probe->batchMeans, value);
+   }
+   if (probe->instability) {
+      probe_instabilitySample(probe, value);
+   }
+
    // Gestion des méta probes
    if (probe->sampleProbe) {
       probe_sample(probe->sampleProbe, value);
@@ -1003,6 +1705,103 @@ void probe_sample(struct probe_t * probe, double value)
 
 }
 
+static void probe_mergeExhaustive(struct probe_t * dst, struct probe_t * src)
+{
+   struct sampleSet_t * set;
+   unsigned long n;
+
+   // A la recherche du premier set de src
+   for (set = src->data.sampleSet; set->prev != NULL ; set = set->prev){};
+
+   for (n = 0 ; n < src->nbSamples; n++) {
+      // Comme probe_sampleExhaustive, mais en conservant la date
+      if (!(dst->nbSamples % PROBE_NB_SAMPLES_MAX)) {
+         probe_exhaustiveNextSet(dst);
+      }
+      dst->data.sampleSet->dates[dst->nbSamples%PROBE_NB_SAMPLES_MAX] = set->dates[n%PROBE_NB_SAMPLES_MAX];
+      dst->data.sampleSet->samples[dst->nbSamples%PROBE_NB_SAMPLES_MAX] = set->samples[n%PROBE_NB_SAMPLES_MAX];
+      dst->nbSamples++;
+
+      // Si on est au bout d'un set, on décale
+      if ((n+1) % PROBE_NB_SAMPLES_MAX == 0) {
+	 set = set->next;
+      }
+   }
+}
+
+static void probe_mergeMean(struct probe_t * dst, struct probe_t * src)
+{
+   if ((dst->nbSamples == 0) || (src->data.mean->firstDate < dst->data.mean->firstDate)) {
+      dst->data.mean->firstDate = src->data.mean->firstDate;
+   }
+   if ((dst->nbSamples == 0) || (src->data.mean->lastDate > dst->data.mean->lastDate)) {
+      dst->data.mean->lastDate = src->data.mean->lastDate;
+   }
+   dst->data.mean->valueSum += src->data.mean->valueSum;
+   dst->nbSamples += src->nbSamples;
+}
+
+static void probe_mergeGraphBar(struct probe_t * dst, struct probe_t * src)
+{
+   struct graphBar_t * d = dst->data.graphBar;
+   struct graphBar_t * s = src->data.graphBar;
+   unsigned long n;
+
+   if ((d->min != s->min) || (d->max != s->max) || (d->nbBar != s->nbBar)
+       || (d->normalized) || (s->normalized)) {
+      motSim_error(MS_WARN, "Incompatible graphBars '%s' and '%s'\n", probe_getName(dst), probe_getName(src));
+      return;
+   }
+   for (n = 0 ; n < d->nbBar; n++) {
+      d->value[n] += s->value[n];
+   }
+   dst->nbSamples += src->nbSamples;
+}
+
+void probe_merge(struct probe_t * dst, struct probe_t * src)
+{
+   unsigned long nbSamples = dst->nbSamples;
+
+   if (src->nbSamples == 0) {
+      return;
+   }
+   if (dst->probeType != src->probeType) {
+      motSim_error(MS_WARN, "Can't merge probe \"%s\" (type \"%s\") into \"%s\" (type \"%s\")\n",
+                   probe_getName(src), probeTypeName(src->probeType),
+                   probe_getName(dst), probeTypeName(dst->probeType));
+      return;
+   }
+
+   switch (dst->probeType) {
+      case exhaustiveProbeType : 
+	 probe_mergeExhaustive(dst, src);
+      break;
+      case meanProbeType : 
+	 probe_mergeMean(dst, src);
+      break;
+      case graphBarProbeType : 
+	 probe_mergeGraphBar(dst, src);
+      break;
+      default :
+	 motSim_error(MS_WARN, "No merge for probe \"%s\" (type \"%s\")\n", probe_getName(dst), probeTypeName(dst->probeType));
+         return;
+      break;
+   }
+
+   if (dst->nbSamples == nbSamples) {
+      return; // Rien n'a été fusionné
+   }
+   if (nbSamples == 0) {
+      dst->min = src->min;
+      dst->max = src->max;
+   } else {
+      dst->min = (src->min>dst->min)?dst->min:src->min;
+      dst->max = (src->max<dst->max)?dst->max:src->max;
+   }
+   dst->lastSample = src->lastSample;
+   dst->lastSampleDate = src->lastSampleDate;
+}
+
 /*
  * Obtention du neme echantillon. Ce n'est pas completement trivial a
  * cause des "sets".
@@ -1577,6 +2376,11 @@ char * probe_getName(struct probe_t * p)
    return p->name;
 }
 
+enum probeType_t probe_getType(struct probe_t * p)
+{
+   return p->probeType;
+}
+
 /*
  * Lecture du nombre min d'échantillons dans un graphBar
   */
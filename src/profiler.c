@@ -0,0 +1,418 @@
+/**
+ * @file profiler.c
+ * @brief Profilage des événements
+ *
+ * Les mesures sont rangées dans des tables de hachage (adressage
+ * ouvert) indexées par l'adresse de la fonction ou de l'objet. Une
+ * troisième table associe à l'adresse des données privées de chaque
+ * ndesObject créé l'objet lui-même, ce qui permet de reconnaître le
+ * paramètre data d'un événement. Elle est remplie dès la création des
+ * objets, même si les mesures ne sont pas démarrées.
+ *
+ * Le coût est mesuré par le compteur de cycles du processeur (TSC)
+ * lorsqu'il est disponible, en nanosecondes sinon.
+ */
+#define _GNU_SOURCE    // dladdr
+#include <stdio.h>     // printf, fopen, ...
+#include <stdlib.h>    // qsort
+#include <stdint.h>    // uintptr_t
+#include <string.h>    // memset
+
+#include <profiler.h>
+#include <motsim-context.h>
+
+#ifdef MOTSIM_PROFILE
+
+#include <dlfcn.h>     // dladdr
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h> // __rdtsc
+#else
+#include <time.h>      // clock_gettime
+#endif
+
+#include <event.h>
+#include <ndesObject.h>
+
+#define PROFILER_INIT_SIZE 256   // Taille initiale d'une table (puissance de 2)
+
+struct profilerEntry_t {
+   void               * key;      // Fonction, objet ou données privées
+   struct ndesObject_t * object;  // L'objet (tables des objets)
+   unsigned long        count;
+   unsigned long        scheduled; // Evénements programmés
+   unsigned long long   cycles;
+   unsigned long long   min;
+   unsigned long long   max;
+};
+
+struct profilerTable_t {
+   struct profilerEntry_t * entries;
+   int                      size;  // Toujours une puissance de 2
+   int                      nb;
+};
+
+struct profiler_t {
+   struct profilerTable_t handlers;
+   struct profilerTable_t objects;
+   struct profilerTable_t registry;    // Données privées -> ndesObject
+   unsigned long          nbScheduled; // Pendant les mesures
+};
+
+static inline unsigned long long profiler_cycles()
+{
+#if defined(__x86_64__) || defined(__i386__)
+   return __rdtsc();
+#else
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#endif
+}
+
+static void profiler_tableInit(struct profilerTable_t * table)
+{
+   table->size = PROFILER_INIT_SIZE;
+   table->nb = 0;
+   table->entries = (struct profilerEntry_t *)sim_malloc(table->size * sizeof(struct profilerEntry_t));
+   memset(table->entries, 0, table->size * sizeof(struct profilerEntry_t));
+}
+
+static inline int profiler_hash(struct profilerTable_t * table, void * key)
+{
+   unsigned long long h = (unsigned long long)(uintptr_t)key * 0x9E3779B97F4A7C15ULL;
+
+   return (int)(h >> 32) & (table->size - 1);
+}
+
+static struct profilerEntry_t * profiler_lookup(struct profilerTable_t * table, void * key);
+
+/*
+ * Doublement de la taille d'une table
+ */
+static void profiler_tableGrow(struct profilerTable_t * table)
+{
+   struct profilerEntry_t * old = table->entries;
+   int oldSize = table->size;
+   int i;
+
+   table->size *= 2;
+   table->nb = 0;
+   table->entries = (struct profilerEntry_t *)sim_malloc(table->size * sizeof(struct profilerEntry_t));
+   memset(table->entries, 0, table->size * sizeof(struct profilerEntry_t));
+
+   for (i = 0; i < oldSize; i++) {
+      if (old[i].key) {
+         *profiler_lookup(table, old[i].key) = old[i];
+      }
+   }
+   sim_free(old);
+}
+
+/*
+ * L'entrée d'une clef, créée (vide) si besoin
+ */
+static struct profilerEntry_t * profiler_lookup(struct profilerTable_t * table, void * key)
+{
+   int i;
+
+   if (2 * (table->nb + 1) > table->size) {
+      profiler_tableGrow(table);
+   }
+
+   for (i = profiler_hash(table, key); table->entries[i].key; i = (i + 1) & (table->size - 1)) {
+      if (table->entries[i].key == key) {
+         return &table->entries[i];
+      }
+   }
+   table->entries[i].key = key;
+   table->entries[i].min = ~0ULL;
+   table->nb++;
+
+   return &table->entries[i];
+}
+
+/*
+ * L'entrée d'une clef, NULL si elle n'y est pas
+ */
+static struct profilerEntry_t * profiler_find(struct profilerTable_t * table, void * key)
+{
+   int i;
+
+   if ((table->entries == NULL) || (key == NULL)) {
+      return NULL;
+   }
+   for (i = profiler_hash(table, key); table->entries[i].key; i = (i + 1) & (table->size - 1)) {
+      if (table->entries[i].key == key) {
+         return &table->entries[i];
+      }
+   }
+   return NULL;
+}
+
+static void profiler_account(struct profilerEntry_t * entry, unsigned long long cost, unsigned long scheduled)
+{
+   entry->count++;
+   entry->scheduled += scheduled;
+   entry->cycles += cost;
+   entry->min = min(entry->min, cost);
+   entry->max = max(entry->max, cost);
+}
+
+/*
+ * Le profileur du contexte courant, créé au besoin
+ */
+static struct profiler_t * profiler_get()
+{
+   struct profiler_t * result = __motSim->profiler;
+
+   if (result == NULL) {
+      result = (struct profiler_t *)sim_malloc(sizeof(struct profiler_t));
+      profiler_tableInit(&result->handlers);
+      profiler_tableInit(&result->objects);
+      profiler_tableInit(&result->registry);
+      result->nbScheduled = 0;
+      __motSim->profiler = result;
+   }
+
+   return result;
+}
+
+void profiler_registerObject(struct ndesObject_t * object)
+{
+   profiler_lookup(&profiler_get()->registry, ndesObject_getPrivate(object))->object = object;
+}
+
+void profiler_runEvent(struct event_t * event)
+{
+   struct profiler_t      * profiler = __motSim->profiler;
+   void                  (* run)(void * data) = event->run;
+   void                   * data = event->data;
+   struct profilerEntry_t * entry;
+   unsigned long            scheduled = profiler->nbScheduled;
+   unsigned long long       start, cost;
+
+   start = profiler_cycles();
+   run(data);
+   cost = profiler_cycles() - start;
+
+   // Les tables ont pu être agrandies par un événement imbriqué
+   scheduled = profiler->nbScheduled - scheduled;
+   profiler_account(profiler_lookup(&profiler->handlers, (void *)run), cost, scheduled);
+
+   entry = profiler_find(&profiler->registry, data);
+   if (entry) {
+      struct ndesObject_t * object = entry->object;
+
+      entry = profiler_lookup(&profiler->objects, object);
+      entry->object = object;
+      profiler_account(entry, cost, scheduled);
+   }
+}
+
+void profiler_eventScheduled()
+{
+   __motSim->profiler->nbScheduled++;
+}
+
+void profiler_start()
+{
+   profiler_get();
+   __motSim->profiling = 1;
+}
+
+void profiler_stop()
+{
+   __motSim->profiling = 0;
+}
+
+static void profiler_tableClear(struct profilerTable_t * table)
+{
+   memset(table->entries, 0, table->size * sizeof(struct profilerEntry_t));
+   table->nb = 0;
+}
+
+void profiler_reset()
+{
+   struct profiler_t * profiler = profiler_get();
+
+   profiler_tableClear(&profiler->handlers);
+   profiler_tableClear(&profiler->objects);
+}
+
+void profiler_free(struct motsim_t * ctx)
+{
+   struct profiler_t * profiler = ctx->profiler;
+
+   if (profiler) {
+      sim_free(profiler->handlers.entries);
+      sim_free(profiler->objects.entries);
+      sim_free(profiler->registry.entries);
+      sim_free(profiler);
+      ctx->profiler = NULL;
+   }
+}
+
+/*
+ * Les noms : symbole de la fonction (ou son adresse), type,
+ * identifiant et nom de l'objet
+ */
+static void profiler_handlerName(void * run, char * name, int len)
+{
+   Dl_info info;
+
+   if ((dladdr(run, &info)) && (info.dli_sname)) {
+      snprintf(name, len, "%s", info.dli_sname);
+   } else {
+      snprintf(name, len, "%p", run);
+   }
+}
+
+static void profiler_objectName(struct ndesObject_t * object, char * name, int len)
+{
+   snprintf(name, len, "%s #%d%s%s", ndesObject_getType(object)->name,
+	    ndesObject_getId(object),
+	    object->name ? " " : "", object->name ? object->name : "");
+}
+
+static int profiler_compare(const void * a, const void * b)
+{
+   unsigned long long ca = (*(struct profilerEntry_t **)a)->cycles;
+   unsigned long long cb = (*(struct profilerEntry_t **)b)->cycles;
+
+   return (ca < cb) - (ca > cb);
+}
+
+/*
+ * Les entrées d'une table, triées par coût décroissant (à libérer)
+ */
+static struct profilerEntry_t ** profiler_sort(struct profilerTable_t * table, unsigned long long * total)
+{
+   struct profilerEntry_t ** result;
+   int i, n = 0;
+
+   result = (struct profilerEntry_t **)sim_malloc((table->nb + 1) * sizeof(struct profilerEntry_t *));
+   *total = 0;
+   for (i = 0; i < table->size; i++) {
+      if (table->entries[i].key) {
+         result[n++] = &table->entries[i];
+         *total += table->entries[i].cycles;
+      }
+   }
+   qsort(result, n, sizeof(struct profilerEntry_t *), profiler_compare);
+
+   return result;
+}
+
+static void profiler_printTable(struct profilerTable_t * table, char * title, int isObject, int nbLines)
+{
+   struct profilerEntry_t ** entries;
+   unsigned long long total;
+   char name[128];
+   int n;
+
+   entries = profiler_sort(table, &total);
+   printf("[PROFI] %s : %d entries, %llu cycles\n", title, table->nb, total);
+   printf("[PROFI] %6s %14s %10s %10s %10s %10s %10s  %s\n",
+	  "%", "cycles", "count", "mean", "min", "max", "sched", "name");
+   for (n = 0; (n < table->nb) && ((nbLines == 0) || (n < nbLines)); n++) {
+      if (isObject) {
+	 profiler_objectName(entries[n]->object, name, sizeof(name));
+      } else {
+	 profiler_handlerName(entries[n]->key, name, sizeof(name));
+      }
+      printf("[PROFI] %6.2f %14llu %10lu %10.0f %10llu %10llu %10lu  %s\n",
+	     total ? 100.0 * entries[n]->cycles / total : 0.0,
+	     entries[n]->cycles, entries[n]->count,
+	     (double)entries[n]->cycles / entries[n]->count,
+	     entries[n]->min, entries[n]->max, entries[n]->scheduled, name);
+   }
+   sim_free(entries);
+}
+
+void profiler_printReport(int nbLines)
+{
+   struct profiler_t * profiler = profiler_get();
+
+   profiler_printTable(&profiler->handlers, "Event handlers", 0, nbLines);
+   profiler_printTable(&profiler->objects, "Objects", 1, nbLines);
+}
+
+static void profiler_writeTable(FILE * f, struct profilerTable_t * table, int isObject)
+{
+   struct profilerEntry_t ** entries;
+   unsigned long long total;
+   char name[128];
+   int n;
+
+   entries = profiler_sort(table, &total);
+   for (n = 0; n < table->nb; n++) {
+      if (isObject) {
+	 profiler_objectName(entries[n]->object, name, sizeof(name));
+      } else {
+	 profiler_handlerName(entries[n]->key, name, sizeof(name));
+      }
+      fprintf(f, "%s,\"%s\",%lu,%llu,%llu,%llu,%f,%lu\n",
+	      isObject ? "object" : "handler", name, entries[n]->count,
+	      entries[n]->cycles, entries[n]->min, entries[n]->max,
+	      (double)entries[n]->cycles / entries[n]->count, entries[n]->scheduled);
+   }
+   sim_free(entries);
+}
+
+int profiler_writeCSV(const char * fileName)
+{
+   struct profiler_t * profiler = profiler_get();
+   FILE * f = fopen(fileName, "w");
+
+   if (f == NULL) {
+      return 1;
+   }
+   fprintf(f, "kind,name,count,cycles,min,max,mean,scheduled\n");
+   profiler_writeTable(f, &profiler->handlers, 0);
+   profiler_writeTable(f, &profiler->objects, 1);
+
+   return fclose(f);
+}
+
+unsigned long profiler_getNbRuns(void (*run)(void *data))
+{
+   struct profilerEntry_t * entry = profiler_find(&profiler_get()->handlers, (void *)run);
+
+   return entry ? entry->count : 0;
+}
+
+unsigned long profiler_getNbScheduled(void (*run)(void *data))
+{
+   struct profilerEntry_t * entry = profiler_find(&profiler_get()->handlers, (void *)run);
+
+   return entry ? entry->scheduled : 0;
+}
+
+unsigned long profiler_getObjectNbRuns(struct ndesObject_t * object)
+{
+   struct profilerEntry_t * entry = profiler_find(&profiler_get()->objects, object);
+
+   return entry ? entry->count : 0;
+}
+
+#else // MOTSIM_PROFILE
+
+void profiler_start()
+{
+   motSim_error(MS_WARN, "Profiling needs a library built with MOTSIM_PROFILE\n");
+}
+
+void profiler_stop() {}
+void profiler_reset() {}
+void profiler_printReport(int nbLines) {}
+int profiler_writeCSV(const char * fileName) { return 1; }
+unsigned long profiler_getNbRuns(void (*run)(void *data)) { return 0; }
+unsigned long profiler_getNbScheduled(void (*run)(void *data)) { return 0; }
+unsigned long profiler_getObjectNbRuns(struct ndesObject_t * object) { return 0; }
+void profiler_runEvent(struct event_t * event) {}
+void profiler_eventScheduled() {}
+void profiler_registerObject(struct ndesObject_t * object) {}
+void profiler_free(struct motsim_t * ctx) {}
+
+#endif // MOTSIM_PROFILE
@@ -21,6 +21,7 @@
 #include <motsim.h>
 #include <file_pdu.h>
 #include <random-generator.h>
+#include <checkpoint.h>
 #define PI 3.14159265358979323846
 
 /*
@@ -100,6 +101,8 @@ struct randomGenerator_t {
       unsigned short xsubi[3]; // for xrand48
    } aleaSrc;
 
+   int antithetic; // Si non nul, 1 - U plutôt que U (cf randomGenerator_setAntithetic)
+
    // La fonction donnant la prochaine valeur alÃ©atoire entre 0 et 1
    double (*aleaGetNext)(struct randomGenerator_t * rg); 
 
@@ -119,6 +122,10 @@ inline double randomGenerator_erand48GetNext(struct randomGenerator_t * rg)
    //   double result = drand48();
    double result = erand48(rg->aleaSrc.xsubi);
 
+   if (rg->antithetic) {
+      result = 1.0 - result;
+   }
+
    if (rg->values)
       probe_sample(rg->values, result);
 
@@ -133,12 +140,45 @@ void randomGenerator_erand48Init(struct randomGenerator_t * rg)
    struct timeval now;
    assert(rg->source == rGSourceErand48);
 
-   gettimeofday(&now, NULL);
-   bcopy(&now + sizeof(now) - sizeof(rg->aleaSrc.xsubi), rg->aleaSrc.xsubi, sizeof(rg->aleaSrc.xsubi));
+   // Une sous-suite propre si une graine a été fixée (cf motSim_setSeed)
+   if (!motSim_getSubstreamSeed(rg->aleaSrc.xsubi)) {
+      gettimeofday(&now, NULL);
+      bcopy(&now + sizeof(now) - sizeof(rg->aleaSrc.xsubi), rg->aleaSrc.xsubi, sizeof(rg->aleaSrc.xsubi));
+   }
    rg->aleaGetNext = randomGenerator_erand48GetNext;
 
 }
 
+/*
+ * Choix d'une sous-suite par son identifiant (cf motSim_getStreamSeed)
+ */
+void randomGenerator_setStream(struct randomGenerator_t * rg, unsigned long long stream)
+{
+   if (rg->source != rGSourceErand48) {
+      motSim_error(MS_WARN, "pas de flot pour cette source (%d)", rg->source);
+      return;
+   }
+   motSim_getStreamSeed(stream, rg->aleaSrc.xsubi);
+}
+
+/*
+ * L'identifiant est obtenu par hachage (FNV-1a) du rôle
+ */
+void randomGenerator_setStreamName(struct randomGenerator_t * rg, const char * role)
+{
+   unsigned long long h = 0xCBF29CE484222325ULL;
+
+   for (; *role; role++) {
+      h = (h ^ (unsigned char)*role) * 0x100000001B3ULL;
+   }
+   randomGenerator_setStream(rg, h);
+}
+
+void randomGenerator_setAntithetic(struct randomGenerator_t * rg, int antithetic)
+{
+   rg->antithetic = antithetic;
+}
+
 /*
  * Next value with replay
  */
@@ -419,6 +459,33 @@ void randomGenerator_reset(struct randomGenerator_t * rg)
    printf_debug(DEBUG_GENE, "OUT\n");
 }
 
+/*
+ * Sauvegarde de l'état de la source d'aléa (cf checkpoint.h), les
+ * valeurs enregistrées l'étant avec leur sonde
+ */
+static void randomGenerator_checkpointSave(struct checkpoint_t * cp, void * data)
+{
+   struct randomGenerator_t * rg = (struct randomGenerator_t *)data;
+
+   checkpoint_write(cp, &rg->source, sizeof(rg->source));
+   checkpoint_write(cp, &rg->aleaSrc, sizeof(rg->aleaSrc));
+   checkpoint_write(cp, &rg->antithetic, sizeof(rg->antithetic));
+}
+
+static void randomGenerator_checkpointRestore(struct checkpoint_t * cp, void * data)
+{
+   struct randomGenerator_t * rg = (struct randomGenerator_t *)data;
+   int source;
+
+   checkpoint_read(cp, &source, sizeof(source));
+   if ((source == rGSourceReplay) && (rg->source != rGSourceReplay)) {
+      rg->source = rGSourceReplay;
+      randomGenerator_replayInit(rg);
+   }
+   checkpoint_read(cp, &rg->aleaSrc, sizeof(rg->aleaSrc));
+   checkpoint_read(cp, &rg->antithetic, sizeof(rg->antithetic));
+}
+
 /*==========================================================================*/
 /*      CREATORS.                                                           */
 /*==========================================================================*/
@@ -438,7 +505,13 @@ struct randomGenerator_t * randomGenerator_createRaw()
    // Ajout Ã  la liste des choses Ã  rÃ©initialiser avant une prochaine simu
    motsim_addToResetList(result, (void (*)(void * data)) randomGenerator_reset);
 
+   // Et à celle des choses à sauvegarder (cf motSim_checkpoint)
+   motSim_addToCheckpointList(result, "randomGenerator",
+			      randomGenerator_checkpointSave,
+			      randomGenerator_checkpointRestore);
+
    // Source
+   result->antithetic = motSim_getAntithetic();
    result->source = rGSourceErand48; // WARNING use rgSourceDefault
    randomGenerator_erand48Init(result); // ... ?
 
@@ -0,0 +1,108 @@
+/**
+ * @file region.c
+ * @brief Implantation de la région propre à une simulation
+ *
+ * La région est une liste de blocs découpés l'un après l'autre. Un
+ * bloc fait REGION_BLOCK_SIZE octets, sauf pour une allocation plus
+ * grande qui obtient un bloc à sa taille. Vider la région revient à
+ * repartir du premier bloc, ils sont tous réutilisés.
+ */
+#include <stdlib.h>    // malloc, free
+
+#include <region.h>
+#include <motsim.h>
+#include <motsim-context.h>
+
+#define REGION_BLOCK_SIZE (64 * 1024)
+#define REGION_ALIGN      16
+
+struct regionBlock_t {
+   struct regionBlock_t * next;
+   size_t                 size;  // Taille de la zone data
+   size_t                 used;  // Octets déjà découpés
+   char                   data[] __attribute__((aligned(REGION_ALIGN)));
+};
+
+/*
+ * Le bloc suivant le bloc courant qui puisse contenir size octets :
+ * un bloc existant trop petit est sauté, sinon un nouveau est inséré
+ */
+static struct regionBlock_t * region_nextBlock(size_t size)
+{
+   struct regionBlock_t * current = __motSim->regionCurrent;
+   struct regionBlock_t * block = current ? current->next : __motSim->regionFirst;
+   size_t                 blockSize;
+
+   while ((block) && (block->size < size)) {
+      block->used = 0;
+      current = block;
+      block = block->next;
+   }
+
+   if (block == NULL) {
+      blockSize = (size > REGION_BLOCK_SIZE) ? size : REGION_BLOCK_SIZE;
+      block = (struct regionBlock_t *)sim_malloc(sizeof(struct regionBlock_t) + blockSize);
+      block->size = blockSize;
+      block->next = NULL;
+      if (current) {
+         current->next = block;
+      } else {
+         __motSim->regionFirst = block;
+      }
+   }
+   block->used = 0;
+   __motSim->regionCurrent = block;
+
+   return block;
+}
+
+void * motSim_runMalloc(size_t size)
+{
+   struct regionBlock_t * block = __motSim->regionCurrent;
+   void                 * result;
+
+   size = (size + REGION_ALIGN - 1) & ~(size_t)(REGION_ALIGN - 1);
+
+   if ((block == NULL) || (block->used + size > block->size)) {
+      block = region_nextBlock(size);
+   }
+   result = block->data + block->used;
+   block->used += size;
+
+   return result;
+}
+
+struct motSimRunMark_t motSim_runMark()
+{
+   struct motSimRunMark_t mark;
+
+   mark.block = __motSim->regionCurrent;
+   mark.used = mark.block ? mark.block->used : 0;
+
+   return mark;
+}
+
+void motSim_runRelease(struct motSimRunMark_t mark)
+{
+   // Les blocs suivants seront remis à zéro lorsqu'on les reprendra
+   __motSim->regionCurrent = mark.block;
+   if (mark.block) {
+      mark.block->used = mark.used;
+   }
+}
+
+void region_reset()
+{
+   __motSim->regionCurrent = NULL;
+}
+
+void region_free(struct motsim_t * ctx)
+{
+   struct regionBlock_t * block;
+
+   while ((block = ctx->regionFirst) != NULL) {
+      ctx->regionFirst = block->next;
+      sim_free(block);
+   }
+   ctx->regionCurrent = NULL;
+}
@@ -7,6 +7,7 @@
 #include <string.h>    // strcat
 
 #include <schedACM.h>
+#include <region.h>
 
 
 // A virer
@@ -647,7 +648,7 @@ struct PDU_t * schedACM_buildBBFRAMEGenericBatch(struct schedACM_t * sched)
    // mettre ! 
    if (sched->sequenceChoisie.positionActuelle == 0) {
       // On ne peut ordonnancer que si l'époque précédente est finie
-      if (motSim_getCurrentTime() >= sched->currentEpochStartTime + sched->epochMinDuration) {
+      if (motSim_dateToSeconds(motSim_getCurrentTime()) >= sched->currentEpochStartTime + sched->epochMinDuration) {
          // Recherche de l'ordonnancement par application de l'algo
          printf_debug(DEBUG_ACM, "On schedule ...\n");
          schedACM_schedule(sched);
@@ -664,9 +665,9 @@ struct PDU_t * schedACM_buildBBFRAMEGenericBatch(struct schedACM_t * sched)
             printf("\n");
 	 }
          if ( sched->currentEpochStartTime > 0.0) {
-            probe_sample(sched->epochDurationProbe, motSim_getCurrentTime() - sched->currentEpochStartTime);
+            probe_sample(sched->epochDurationProbe, motSim_dateToSeconds(motSim_getCurrentTime()) - sched->currentEpochStartTime);
 	 }
-	 sched->currentEpochStartTime = motSim_getCurrentTime();
+	 sched->currentEpochStartTime = motSim_dateToSeconds(motSim_getCurrentTime());
       }
    }
    printf_debug(DEBUG_ACM, "Looking for a frame\n");
@@ -910,6 +911,26 @@ void remplissage_init(t_remplissage * tr, int nbModCod, int nbQoS)
    //printf_debug(DEBUG_KS, "m/c = %d/%d done\n", nbModCod, nbQoS);
 }
 
+/*
+ * Une solution de travail, prise dans la région de la simulation : il
+ * n'y a pas à la libérer, il suffit de revenir à une position notée
+ * auparavant (cf motSim_runMark)
+ */
+void remplissage_initRun(t_remplissage * tr, int nbModCod, int nbQoS)
+{
+   int  m;
+
+   assert(tr);
+
+   tr->nbrePaquets = (int **)motSim_runMalloc(nbModCod*sizeof(int *));
+
+   for (m = 0; m < nbModCod; m++) {
+      tr->nbrePaquets[m] = (int *)motSim_runMalloc(nbQoS*sizeof(int));
+   }
+
+   remplissage_raz(tr, nbModCod, nbQoS);
+}
+
 
 void remplissage_free(t_remplissage * tr, int nbModCod)
 {
@@ -53,6 +53,8 @@ void schedulerBatchOnePass(struct schedACMBatch_t * sched, int mode)
    double  nbTrames;		     // nécessaires sur un MC (à supprimer)
    double sommePoids;
    int taille;
+   struct filePDU_t * file; // La file que l'on bourre
+   int pris, nb, debut, reste;
 
    t_sequence * sequence; //!< Séquence sur laquelle on travaille
 
@@ -213,27 +215,27 @@ void schedulerBatchOnePass(struct schedACMBatch_t * sched, int mode)
 						    sequence->remplissages[sequence->positionActuelle].nbrePaquets[m][qb]
 						    + sequence_nbPackets(sequence, m, qb)+1))),
 			       DVBS2ll_bbframePayloadBitSize(schedACM_getACMLink(sched->schedACM), m)/8 - sequence->remplissages[sequence->positionActuelle].volumeTotal);
-		 while ((sequence->remplissages[sequence->positionActuelle].nbrePaquets[m][qb]
-                 + sequence_nbPackets(sequence, m, qb)
-			 < filePDU_length(schedACM_getInputQueue(sched->schedACM, m, qb)))
-			&& (filePDU_size_PDU_n(schedACM_getInputQueue(sched->schedACM, m, qb),
-                                     sequence->remplissages[sequence->positionActuelle].nbrePaquets[m][qb]
-					       + sequence_nbPackets(sequence, m, qb)+1)
-			    + sequence->remplissages[sequence->positionActuelle].volumeTotal
-                            <= DVBS2ll_bbframePayloadBitSize(schedACM_getACMLink(sched->schedACM), m)/8))
-		   {
-                      taille = filePDU_size_PDU_n(schedACM_getInputQueue(sched->schedACM, m, qb),
-                                     sequence->remplissages[sequence->positionActuelle].nbrePaquets[m][qb]
-						  + sequence_nbPackets(sequence, m, qb)+1);
-                      // Je place le paquet dans le remplissage
-                      sequence->remplissages[sequence->positionActuelle].nbrePaquets[m][qb]++;
+		 // Les paquets de la file déjà pris, et le nombre de ceux qui
+		 // suivent et tiennent dans la place restante (cf
+		 // filePDU_nb_PDU_in)
+		 file = schedACM_getInputQueue(sched->schedACM, m, qb);
+		 pris = sequence->remplissages[sequence->positionActuelle].nbrePaquets[m][qb]
+		    + sequence_nbPackets(sequence, m, qb);
+		 reste = DVBS2ll_bbframePayloadBitSize(schedACM_getACMLink(sched->schedACM), m)/8
+		    - sequence->remplissages[sequence->positionActuelle].volumeTotal;
+		 debut = filePDU_size_n_PDU(file, pris);
+		 nb = (reste > 0) ? filePDU_nb_PDU_in(file, debut + reste) - pris : 0;
+		 if (nb > 0) {
+                      taille = filePDU_size_n_PDU(file, pris + nb) - debut;
+                      // Je place les paquets dans le remplissage
+                      sequence->remplissages[sequence->positionActuelle].nbrePaquets[m][qb] += nb;
                       sequence->remplissages[sequence->positionActuelle].volumeTotal += taille;
                       sequence->remplissages[sequence->positionActuelle].interet
 	                 += (double)(taille) * poids[m][qb]*sommePoids;
                       // C'est ça de moins pour la file (m, qb)
                       deficitBitSize[m][qb] -= 8*taille;
-                      printf_debug(DEBUG_SCHED, "Plus %d pour m=%d, q=%d\n", taille, m, qb);
-		   }
+                      printf_debug(DEBUG_SCHED, "Plus %d (%d paquets) pour m=%d, q=%d\n", taille, nb, m, qb);
+		 }
 	       }
                sequence->positionActuelle++;
 	    }
@@ -18,6 +18,7 @@
 
 #include <motsim.h>
 #include <schedUtility.h>
+#include <region.h>
 
 #define propModDirect         1
 #define propModProp           2
@@ -199,9 +200,10 @@ void schedulerUtilityMC(struct schedUtility_t * sched, int mc, t_remplissage * r
 void schedulerUtility(struct schedUtility_t * sched)
 {
    t_remplissage remplissage; // Le remplissage construit ici
+   struct motSimRunMark_t mark = motSim_runMark();
    int m;
 
-   remplissage_init(&remplissage, schedACM_getNbModCod(sched->schedACM), schedACM_getNbQoS(sched->schedACM));
+   remplissage_initRun(&remplissage, schedACM_getNbModCod(sched->schedACM), schedACM_getNbQoS(sched->schedACM));
 
    for (m = 0; m < schedACM_getNbModCod(sched->schedACM) ; m++){
       remplissage_raz(&remplissage, schedACM_getNbModCod(sched->schedACM), schedACM_getNbQoS(sched->schedACM));
@@ -236,6 +238,9 @@ void schedulerUtility(struct schedUtility_t * sched)
 		schedACM_getSolution(sched->schedACM)->modcod,
 		schedACM_getSolution(sched->schedACM)->volumeTotal,
 		schedACM_getSolution(sched->schedACM)->interet);
+
+   // La solution de travail est rendue
+   motSim_runRelease(mark);
 }
 
 /**
@@ -395,9 +400,10 @@ void schedulerUtilityMCProp(struct schedUtility_t * sched, int mc, t_remplissage
 void schedulerUtilityProp(struct schedUtility_t * sched)
 {
    t_remplissage remplissage; // Le remplissage construit ici
+   struct motSimRunMark_t mark = motSim_runMark();
    int m,q;
 
-   remplissage_init(&remplissage, schedACM_getNbModCod(sched->schedACM), schedACM_getNbQoS(sched->schedACM));
+   remplissage_initRun(&remplissage, schedACM_getNbModCod(sched->schedACM), schedACM_getNbQoS(sched->schedACM));
 
    for (m = 0; m < schedACM_getNbModCod(sched->schedACM) ; m++){
       remplissage_raz(&remplissage, schedACM_getNbModCod(sched->schedACM), schedACM_getNbQoS(sched->schedACM));
@@ -439,6 +445,7 @@ void schedulerUtilityProp(struct schedUtility_t * sched)
       }
    }
 
+   motSim_runRelease(mark);
 }
 
 static struct schedACM_func_t schedUtilityProp_func = {
@@ -233,7 +233,7 @@ void srcHTTPSS_EOTMainObject (void * arg) {
 
 	//On peut programmer le chargement des objets embarqués
 	printf("Programmation de l'event envoie des EbOb");
-	event_add(srcHTTPSS_sendEmbeddedObjects, src, motSim_getCurrentTime() + tempsParsing);
+	event_add(srcHTTPSS_sendEmbeddedObjects, src, motSim_getCurrentTime() + motSim_secondsToDate(tempsParsing));
 	printf("Event programmé\n\n");
 }
 
@@ -327,7 +327,7 @@ printf("Entrée dans la fonction de vérif de fin d'envoi\n");
 		// Ici la session c'est la lecture de 2 pages
 		if (src->nbPage < src->nbPageMax) {
 			printf("Programmation de l'event lire une nouvelle page\n");
-			event_add(srcHTTPSS_sessionStart, src, motSim_getCurrentTime()+ tempsReading);
+			event_add(srcHTTPSS_sessionStart, src, motSim_getCurrentTime()+ motSim_secondsToDate(tempsReading));
 		}
 
 	} else {
@@ -167,7 +167,7 @@ struct PDU_t * srcTCPss_getPDU(void * s)
   if (filePDU_length(src->outputQueue) > 0) {
      printf_debug(DEBUG_SRC, "scheduling two more segments\n");
      //printf("%d : motSimgetCurrentTime()\n",motSim_getCurrentTime());
-     event_add(srcTCPss_send2Segments, src, motSim_getCurrentTime() + src->RTT);
+     event_timerAdd(srcTCPss_send2Segments, src, motSim_getCurrentTime() + motSim_secondsToDate(src->RTT));
      result = filePDU_extract(src->outputQueue);
      src->nbSentSegments++;
      printf_debug(DEBUG_SRC, "returning a segment (nb %d) on %p\n", src->nbSentSegments, src);
@@ -14,6 +14,7 @@
 #include <srv-gen.h>
 #include <ndesObject.h>
 #include <log.h>
+#include <checkpoint.h>
 
 #include <stdlib.h>    // Malloc, NULL, exit...
 
@@ -30,7 +31,7 @@ struct srvGen_t {
 
    enum srvState_t          srvState;
    struct PDU_t           * currentPDU;   // The PDU being served
-   float                    serviceStartTime;
+   motSimDate_t             serviceStartTime;
 
    // Dealing with service time
    // C'est un peu de la merde parceque mes dates ne savent pas 
@@ -64,6 +65,59 @@ struct ndesObjectType_t srvGenType = {
    ndesObjectTypeDefaultValues(srvGen)
 };
 
+void srvGen_terminateProcess(struct srvGen_t * srv);
+
+/*
+ * Sauvegarde de l'état d'un serveur (cf checkpoint.h), y compris la
+ * source en attente s'il y en a une
+ */
+static void srvGen_checkpointSave(struct checkpoint_t * cp, void * data)
+{
+   struct srvGen_t * srv = (struct srvGen_t *)data;
+
+   checkpoint_write(cp, &srv->srvState, sizeof(srv->srvState));
+   checkpoint_write(cp, &srv->serviceStartTime, sizeof(srv->serviceStartTime));
+   checkpoint_writePDU(cp, srv->currentPDU);
+   checkpoint_writeObject(cp, srv->source);
+   if (srv->source) {
+      checkpoint_writeFunction(cp, (void (*)())srv->getPDU);
+   }
+}
+
+static void srvGen_checkpointRestore(struct checkpoint_t * cp, void * data)
+{
+   struct srvGen_t * srv = (struct srvGen_t *)data;
+
+   if (srv->currentPDU) {
+      PDU_free(srv->currentPDU);
+   }
+   checkpoint_read(cp, &srv->srvState, sizeof(srv->srvState));
+   checkpoint_read(cp, &srv->serviceStartTime, sizeof(srv->serviceStartTime));
+   srv->currentPDU = checkpoint_readPDU(cp);
+   srv->source = checkpoint_readObject(cp);
+   if (srv->source) {
+      srv->getPDU = (getPDU_t)checkpoint_readFunction(cp);
+   }
+}
+
+/*
+ * Réinitialisation (cf motSim_reset) : la PDU en cours de service est
+ * abandonnée, l'événement de fin de service ayant disparu avec les
+ * autres
+ */
+static void srvGen_reset(struct srvGen_t * srv)
+{
+   if (srv->currentPDU) {
+      PDU_free(srv->currentPDU);
+      srv->currentPDU = NULL;
+   }
+   srv->srvState = srvStateIdle;
+   srv->source = NULL;
+   if (srv->dateGenerator) {
+      dateGenerator_rewind(srv->dateGenerator);
+   }
+}
+
 /*
  * Creation et initialisation d'un serveur
  */
@@ -90,18 +144,21 @@ struct srvGen_t * srvGen_create(void * destination,
 
    result->serviceProbe = NULL;
 
+   motsim_addToResetList(result, (void (*)(void *))srvGen_reset);
+   motSim_addToCheckpointList(result, "srvGen", srvGen_checkpointSave, srvGen_checkpointRestore);
+   checkpoint_registerFunction(srvGen_terminateProcess);
+   checkpoint_registerFunction(srvGen_getPDU);
+
    return result;
 }
 
-
-void srvGen_terminateProcess(struct srvGen_t * srv);
 /*
  * Début de traitement d'une PDU
  */
 void srvGen_startService(struct srvGen_t * srv, struct PDU_t * pdu)
 {
    struct event_t * event;
-   double date ; 
+   motSimDate_t date ; 
 
    assert(pdu != NULL);
 
@@ -116,13 +173,13 @@ void srvGen_startService(struct srvGen_t * srv, struct PDU_t * pdu)
 
    //Déterminer une date de fin en fonction du temps de traitement
    if (srv->serviceTime == serviceTimeProp){
-      date = motSim_getCurrentTime() + PDU_size(pdu) * srv->serviceTimeParameter;
+      date = motSim_getCurrentTime() + motSim_secondsToDate(PDU_size(pdu) * srv->serviceTimeParameter);
    } else {
       assert(srv->dateGenerator);
       date = dateGenerator_nextDate(srv->dateGenerator);
    }
 
-   printf_debug(DEBUG_SRV, " PDU %d from %6.3f to %6.3f\n", PDU_id(pdu), motSim_getCurrentTime(), date);
+   printf_debug(DEBUG_SRV, " PDU %d from %6.3f to %6.3f\n", PDU_id(pdu), motSim_dateToSeconds(motSim_getCurrentTime()), motSim_dateToSeconds(date));
 
    // On crée un événement pour cette date
    event = event_create((eventAction_t)srvGen_terminateProcess, srv, date);
@@ -151,7 +208,7 @@ void srvGen_terminateProcess(struct srvGen_t * srv)
    printf_debug(DEBUG_SRV, " end of service\n");
 
    if (srv->serviceProbe) {
-      probe_sample(srv->serviceProbe, motSim_getCurrentTime() - srv->serviceStartTime);
+      probe_sample(srv->serviceProbe, motSim_dateToSeconds(motSim_getCurrentTime() - srv->serviceStartTime));
    }
 
    // On propose la PDU à la destination
@@ -0,0 +1,281 @@
+/**
+ * @file telemetry.c
+ * @brief Suivi de l'avancement des simulations
+ *
+ * Les contextes sont chaînés dans une liste globale protégée par un
+ * verrou. A chaque période, le thread de suivi lit les compteurs
+ * publiés par chaque contexte puis lui demande une nouvelle
+ * publication : les valeurs affichées ont donc au plus une période de
+ * retard. Seul le thread de suivi écrit sur la sortie standard et
+ * dans le fichier JSON, rien n'est fait dans un gestionnaire de
+ * signal.
+ */
+#include <stdio.h>     // printf, fopen, ...
+#include <string.h>    // strcmp
+#include <time.h>      // clock_gettime
+#include <errno.h>     // ETIMEDOUT
+#include <unistd.h>    // sysconf
+#include <pthread.h>
+
+#include <telemetry.h>
+#include <motsim-context.h>
+#include <event-file.h>
+
+static pthread_mutex_t telemetry_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  telemetry_cond = PTHREAD_COND_INITIALIZER;
+
+// Les contextes existants (protégés par telemetry_mutex)
+static struct telemetry_t * telemetry_first = NULL;
+static int                  telemetry_nextId = 0;
+
+// Le thread de suivi
+static pthread_t     telemetry_thread;
+static int           telemetry_running = 0;
+static int           telemetry_stopping = 0;
+static double        telemetry_period;
+static int           telemetry_statusLine;
+static FILE        * telemetry_jsonFile = NULL;
+static double        telemetry_startWall;
+static double        telemetry_lastWall;
+static unsigned long telemetry_nbSamples = 0;
+
+static double telemetry_wallTime()
+{
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/*
+ * La mémoire résidente du processus (en octets), 0 si elle n'est pas
+ * connue
+ */
+static unsigned long telemetry_rss()
+{
+   unsigned long size, resident = 0;
+   FILE * f = fopen("/proc/self/statm", "r");
+
+   if (f) {
+      if (fscanf(f, "%lu %lu", &size, &resident) != 2) {
+         resident = 0;
+      }
+      fclose(f);
+   }
+   return resident * sysconf(_SC_PAGESIZE);
+}
+
+void telemetry_register(struct motsim_t * ctx)
+{
+   struct telemetry_t * t = &ctx->telemetry;
+
+   pthread_mutex_lock(&telemetry_mutex);
+   t->id = telemetry_nextId++;
+   t->lastDate = 0.0;
+   t->lastEvents = 0;
+   atomic_store(&t->requested, 0);
+   t->next = telemetry_first;
+   telemetry_first = t;
+   pthread_mutex_unlock(&telemetry_mutex);
+}
+
+void telemetry_unregister(struct motsim_t * ctx)
+{
+   struct telemetry_t ** t;
+
+   pthread_mutex_lock(&telemetry_mutex);
+   for (t = &telemetry_first; *t; t = &(*t)->next) {
+      if (*t == &ctx->telemetry) {
+         *t = ctx->telemetry.next;
+         break;
+      }
+   }
+   pthread_mutex_unlock(&telemetry_mutex);
+}
+
+/*
+ * Publication des compteurs d'un contexte, par le thread qui
+ * l'exécute
+ */
+void telemetry_publish(struct motsim_t * ctx)
+{
+   struct telemetry_t * t = &ctx->telemetry;
+   struct motSimCounters_t counters;
+
+   atomic_store_explicit(&t->requested, 0, memory_order_relaxed);
+
+   motSim_getCounters(ctx, &counters);
+
+   atomic_store_explicit(&t->date, motSim_dateToSeconds(ctx->currentTime), memory_order_relaxed);
+   atomic_store_explicit(&t->finishTime, motSim_dateToSeconds(ctx->finishTime), memory_order_relaxed);
+   atomic_store_explicit(&t->nbEvents, ctx->nbRanEvents, memory_order_relaxed);
+   atomic_store_explicit(&t->nbPending,
+			 eventFile_length(ctx->events) + eventFile_length(ctx->timers),
+			 memory_order_relaxed);
+   atomic_store_explicit(&t->nbPDUInUse, counters.PDUCreated - counters.PDUFreed,
+			 memory_order_relaxed);
+   atomic_store_explicit(&t->nbPDUAllocated, counters.PDUMalloced, memory_order_relaxed);
+}
+
+/*
+ * Un échantillon de tous les contextes
+ */
+static void telemetry_sample()
+{
+   struct telemetry_t * t;
+   double        wall = telemetry_wallTime();
+   double        elapsed = wall - telemetry_lastWall;
+   double        date, minDate = 0.0, finish = 0.0;
+   double        rate, totalRate = 0.0, ratio, minRatio = 0.0;
+   unsigned long events, totalEvents = 0, pending = 0, inUse = 0, allocated = 0;
+   unsigned long rss = telemetry_rss();
+   int           nb = 0;
+
+   if (elapsed <= 0.0) {
+      elapsed = 1e-9;
+   }
+
+   if (telemetry_jsonFile) {
+      fprintf(telemetry_jsonFile, "{\"wall\":%.3f,\"rss\":%lu,\"contexts\":[",
+	      wall - telemetry_startWall, rss);
+   }
+
+   pthread_mutex_lock(&telemetry_mutex);
+   for (t = telemetry_first; t; t = t->next) {
+      date = atomic_load_explicit(&t->date, memory_order_relaxed);
+      events = atomic_load_explicit(&t->nbEvents, memory_order_relaxed);
+
+      // Une réinitialisation (cf motSim_reset) fait reculer les compteurs
+      rate = (events >= t->lastEvents) ? (events - t->lastEvents) / elapsed : 0.0;
+      ratio = (date >= t->lastDate) ? (date - t->lastDate) / elapsed : 0.0;
+      t->lastEvents = events;
+      t->lastDate = date;
+
+      if (telemetry_jsonFile) {
+         fprintf(telemetry_jsonFile,
+		 "%s{\"id\":%d,\"date\":%g,\"finish\":%g,\"events\":%lu,\"rate\":%.1f,"
+		 "\"ratio\":%g,\"pending\":%lu,\"pduInUse\":%lu,\"pduAllocated\":%lu}",
+		 nb ? "," : "", t->id, date,
+		 atomic_load_explicit(&t->finishTime, memory_order_relaxed),
+		 events, rate, ratio,
+		 atomic_load_explicit(&t->nbPending, memory_order_relaxed),
+		 atomic_load_explicit(&t->nbPDUInUse, memory_order_relaxed),
+		 atomic_load_explicit(&t->nbPDUAllocated, memory_order_relaxed));
+      }
+
+      // La ligne d'état montre le contexte le moins avancé
+      if ((!nb) || (date < minDate)) {
+         minDate = date;
+         finish = atomic_load_explicit(&t->finishTime, memory_order_relaxed);
+      }
+      if ((!nb) || (ratio < minRatio)) {
+         minRatio = ratio;
+      }
+      totalEvents += events;
+      totalRate += rate;
+      pending += atomic_load_explicit(&t->nbPending, memory_order_relaxed);
+      inUse += atomic_load_explicit(&t->nbPDUInUse, memory_order_relaxed);
+      allocated += atomic_load_explicit(&t->nbPDUAllocated, memory_order_relaxed);
+      nb++;
+
+      // Les compteurs seront publiés pour le prochain échantillon
+      atomic_store_explicit(&t->requested, 1, memory_order_relaxed);
+   }
+   pthread_mutex_unlock(&telemetry_mutex);
+
+   telemetry_lastWall = wall;
+   telemetry_nbSamples++;
+
+   if (telemetry_jsonFile) {
+      fprintf(telemetry_jsonFile, "]}\n");
+      fflush(telemetry_jsonFile);
+   }
+
+   if (telemetry_statusLine) {
+      printf("\r[TELEM] %d ctx, t = %8.2f s (%6.2f%%), %lu ev (%.3g ev/s, x%.3g), %lu pr., %lu/%lu PDU, %lu kB",
+	     nb, minDate, (finish > 0.0) ? 100.0 * minDate / finish : 0.0,
+	     totalEvents, totalRate, minRatio, pending, inUse, allocated, rss / 1024);
+      fflush(stdout);
+   }
+}
+
+static void * telemetry_reporter(void * arg)
+{
+   struct timespec deadline;
+   double          next;
+
+   pthread_mutex_lock(&telemetry_mutex);
+   clock_gettime(CLOCK_REALTIME, &deadline);
+   while (!telemetry_stopping) {
+      next = deadline.tv_nsec * 1e-9 + telemetry_period;
+      deadline.tv_sec += (time_t)next;
+      deadline.tv_nsec = (long)((next - (time_t)next) * 1e9);
+      while ((!telemetry_stopping)
+	     && (pthread_cond_timedwait(&telemetry_cond, &telemetry_mutex, &deadline) != ETIMEDOUT));
+
+      pthread_mutex_unlock(&telemetry_mutex);
+      telemetry_sample();
+      pthread_mutex_lock(&telemetry_mutex);
+   }
+   pthread_mutex_unlock(&telemetry_mutex);
+
+   return NULL;
+}
+
+int telemetry_start(double period, int statusLine, const char * jsonFileName)
+{
+   if ((telemetry_running) || (period <= 0.0)) {
+      return 1;
+   }
+
+   if (jsonFileName) {
+      if (!strcmp(jsonFileName, "-")) {
+         telemetry_jsonFile = stdout;
+      } else if ((telemetry_jsonFile = fopen(jsonFileName, "w")) == NULL) {
+         return 1;
+      }
+   }
+   telemetry_period = period;
+   telemetry_statusLine = statusLine;
+   telemetry_stopping = 0;
+   telemetry_nbSamples = 0;
+   telemetry_startWall = telemetry_lastWall = telemetry_wallTime();
+
+   if (pthread_create(&telemetry_thread, NULL, telemetry_reporter, NULL)) {
+      if ((telemetry_jsonFile) && (telemetry_jsonFile != stdout)) {
+         fclose(telemetry_jsonFile);
+      }
+      telemetry_jsonFile = NULL;
+      return 1;
+   }
+   telemetry_running = 1;
+
+   return 0;
+}
+
+void telemetry_stop()
+{
+   if (!telemetry_running) {
+      return;
+   }
+
+   pthread_mutex_lock(&telemetry_mutex);
+   telemetry_stopping = 1;
+   pthread_cond_signal(&telemetry_cond);
+   pthread_mutex_unlock(&telemetry_mutex);
+   pthread_join(telemetry_thread, NULL);
+   telemetry_running = 0;
+
+   if (telemetry_statusLine) {
+      printf("\n");
+   }
+   if ((telemetry_jsonFile) && (telemetry_jsonFile != stdout)) {
+      fclose(telemetry_jsonFile);
+   }
+   telemetry_jsonFile = NULL;
+}
+
+unsigned long telemetry_getNbSamples()
+{
+   return telemetry_nbSamples;
+}
@@ -0,0 +1,88 @@
+/*
+ *    Test des embranchements
+ *
+ *    branch : une file M/D/1 est simulée jusqu'à BRANCHE puis
+ *    dupliquée en NB_BRANCHES variantes, dont le temps de service
+ *    est modifié. La branche 0, non modifiée, doit donner exactement
+ *    le même résultat que le père qui poursuit la simulation, et le
+ *    temps de séjour doit croître avec le temps de service.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>      // sqrt
+
+#include <motsim.h>
+#include <branch.h>
+
+#include "file-simple.h"
+
+#define BRANCHE     5000.0
+#define DUREE      20000.0
+#define LAMBDA         0.5
+#define SERVICE        1.0   // Temps de service d'une PDU de taille 1
+#define NB_BRANCHES    4
+
+struct srvGen_t * srv;
+
+/*
+ * La branche n sert les PDU en SERVICE * (1 + n/4)
+ */
+void modifier(int n, void * data)
+{
+   srvGen_setServiceTime(srv, serviceTimeProp, SERVICE * (1.0 + n / 4.0));
+}
+
+int main()
+{
+   struct motSimBranchResult_t resultats[NB_BRANCHES * 2];
+   struct probe_t    * sondes[2];
+   struct fileSimple_t mm1;
+   int                 result = 0;
+   int                 n;
+
+   motSim_create();
+
+   sondes[0] = probe_createExhaustive();
+   sondes[1] = probe_createMean();
+   fileSimple_construire(&mm1, dateGenerator_createExp(LAMBDA), SERVICE, sondes[0]);
+   filePDU_addSejournProbe(mm1.file, sondes[1]);
+   srv = mm1.srv;
+   PDUSource_start(mm1.source);
+
+   motSim_runUntil(motSim_secondsToDate(BRANCHE));
+
+   if (motSim_branch(NB_BRANCHES, motSim_secondsToDate(DUREE), modifier, NULL,
+		     2, sondes, resultats)) {
+      printf("[BRNCH] ERREUR : branches en échec\n");
+      return 1;
+   }
+
+   // Le père poursuit sans modification
+   motSim_runUntil(motSim_secondsToDate(DUREE));
+
+   for (n = 0; n < NB_BRANCHES; n++) {
+      printf("[BRNCH] branche %d : %lu séjours, moyenne %f (+/- %f)\n", n,
+	     resultats[2 * n].nbSamples, resultats[2 * n].mean,
+	     sqrt(resultats[2 * n].variance));
+      if (resultats[2 * n].nbSamples != resultats[2 * n + 1].nbSamples) {
+	 printf("[BRNCH] ERREUR : sondes incohérentes\n");
+	 result = 1;
+      }
+      if ((n > 0) && (resultats[2 * n].mean <= resultats[2 * (n - 1)].mean)) {
+	 printf("[BRNCH] ERREUR : séjour non croissant\n");
+	 result = 1;
+      }
+   }
+   printf("[BRNCH] père : %lu séjours, moyenne %f\n",
+	  probe_nbSamples(sondes[0]), probe_mean(sondes[0]));
+
+   if ((resultats[0].nbSamples != probe_nbSamples(sondes[0]))
+       || (resultats[0].mean != probe_mean(sondes[0]))
+       || (resultats[0].max != probe_max(sondes[0]))
+       || (resultats[1].mean != probe_mean(sondes[1]))) {
+      printf("[BRNCH] ERREUR : branche 0 différente du père\n");
+      result = 1;
+   }
+
+   return result;
+}
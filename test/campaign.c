@@ -0,0 +1,117 @@
+/*
+ *    Test des campagnes de simulation
+ *
+ *    campaign : une file M/D/1 est répliquée, d'abord sur un seul
+ *    thread puis sur plusieurs. Les résultats doivent être identiques
+ *    et le temps d'attente moyen proche de sa valeur théorique.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>      // fabs
+
+#include <campaign.h>
+
+#include "file-simple.h"
+
+#define NB_REPLICATIONS 12
+#define DUREE           5000.0
+#define LAMBDA          0.5
+#define MU              1.0     // Des PDU de taille 1 servies à débit MU
+
+/*
+ * Les numéros des mesures de la campagne
+ */
+struct mesures_t {
+   int attente;
+   int histo;
+};
+
+void construire(struct motSimCampaign_t * c, int n, void * data)
+{
+   struct mesures_t * mesures = (struct mesures_t *)data;
+   struct fileSimple_t mm1;
+   struct probe_t   * attente, * histo;
+
+   attente = probe_createMean();
+   histo = probe_createGraphBar(0.0, 20.0, 40);
+   fileSimple_construire(&mm1, dateGenerator_createExp(LAMBDA), 1.0 / MU, attente);
+   filePDU_addSejournProbe(mm1.file, histo);
+
+   motSim_campaignSetProbe(c, n, mesures->attente, attente);
+   motSim_campaignSetProbe(c, n, mesures->histo, histo);
+}
+
+/*
+ * Exécution d'une campagne sur nbThreads threads
+ */
+struct motSimCampaign_t * lancer(int nbThreads,
+				 struct probe_t ** moyennes,
+				 struct probe_t ** histo)
+{
+   static struct mesures_t mesures;
+   struct motSimCampaign_t * c;
+
+   c = motSim_campaignCreate(NB_REPLICATIONS, motSim_secondsToDate(DUREE), construire, &mesures);
+   motSim_campaignSetNbThreads(c, nbThreads);
+   motSim_campaignSetSeed(c, 42);
+
+   *moyennes = probe_createExhaustive();
+   probe_setName(*moyennes, "attente");
+   *histo = probe_createGraphBar(0.0, 20.0, 40);
+
+   mesures.attente = motSim_campaignAddProbe(c, *moyennes, NULL);
+   mesures.histo = motSim_campaignAddProbe(c, NULL, *histo);
+
+   motSim_campaignRun(c);
+   motSim_campaignPrintStatus(c);
+
+   return c;
+}
+
+int main()
+{
+   struct probe_t * moyennes[2], * histo[2];
+   double attente = LAMBDA / (2.0 * MU * (MU - LAMBDA));
+   int result = 0;
+   int n;
+
+   motSim_create();
+
+   lancer(1, &moyennes[0], &histo[0]);
+   lancer(4, &moyennes[1], &histo[1]);
+
+   if ((probe_nbSamples(moyennes[0]) != NB_REPLICATIONS)
+       || (probe_nbSamples(moyennes[1]) != NB_REPLICATIONS)) {
+      printf("[CAMPA] ERREUR : %lu et %lu réplications\n",
+	     probe_nbSamples(moyennes[0]), probe_nbSamples(moyennes[1]));
+      result = 1;
+   }
+
+   for (n = 0; n < NB_REPLICATIONS; n++) {
+      if (probe_exhaustiveGetSample(moyennes[0], n) != probe_exhaustiveGetSample(moyennes[1], n)) {
+	 printf("[CAMPA] ERREUR : réplication %d différente\n", n);
+	 result = 1;
+      }
+   }
+
+   for (n = 0; n < 40; n++) {
+      if (probe_graphBarGetValue(histo[0], n) != probe_graphBarGetValue(histo[1], n)) {
+	 printf("[CAMPA] ERREUR : histogrammes différents en %d\n", n);
+	 result = 1;
+      }
+   }
+
+   // Deux réplications différentes ne doivent pas donner la même chose
+   if (probe_exhaustiveGetSample(moyennes[0], 0) == probe_exhaustiveGetSample(moyennes[0], 1)) {
+      printf("[CAMPA] ERREUR : réplications identiques\n");
+      result = 1;
+   }
+
+   if (fabs(probe_mean(moyennes[0]) - attente) > 0.2) {
+      printf("[CAMPA] ERREUR : attente moyenne %f au lieu de %f\n",
+	     probe_mean(moyennes[0]), attente);
+      result = 1;
+   }
+
+   return result;
+}
@@ -0,0 +1,219 @@
+/*
+ *    Test des sauvegardes
+ *
+ *    checkpoint : une file M/M/1 est simulée pendant une phase de
+ *    chauffe puis sauvegardée et simulée jusqu'au bout. Le même
+ *    modèle, reconstruit dans un autre contexte et restauré à partir
+ *    de la sauvegarde, doit donner exactement les mêmes résultats (y
+ *    compris les lots des détecteurs et des intervalles de confiance),
+ *    et la restauration doit être bien plus rapide que la chauffe. Un
+ *    modèle d'une autre version ou avec un client de plus doit être
+ *    refusé, tout comme une sauvegarde tronquée, qui ne doit alors
+ *    rien modifier. Un générateur antithétique doit le rester après
+ *    restauration dans un modèle qui ne l'est pas.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>      // clock_gettime
+#include <unistd.h>    // unlink, truncate
+#include <sys/stat.h>  // stat
+
+#include <motsim.h>
+#include <checkpoint.h>
+#include <random-generator.h>
+
+#include "file-simple.h"
+
+#define CHAUFFE 100000.0
+#define DUREE   120000.0
+#define LAMBDA  0.5
+#define MU      1.0     // Des PDU de taille 1 servies à débit MU
+#define NB_BARRES 40
+
+#define FICHIER "checkpoint.bin"
+#define FICHIER_RG "checkpoint-rg.bin"
+
+struct modele_t {
+   struct filePDU_t * file;
+   struct probe_t   * attente;
+   struct probe_t   * histo;
+   struct probe_t   * service;
+};
+
+void instable(struct probe_t * p, void * data)
+{
+   printf("[CHECK] ERREUR : file stable jugée instable\n");
+}
+
+void construire(struct modele_t * m, int version, int sondeEnPlus)
+{
+   struct fileSimple_t mm1;
+
+   motSim_setSeed(42);
+   motSim_setModelVersion("mm1", version);
+
+   m->attente = probe_createExhaustive();
+   probe_setWarmupDetector(m->attente);
+   probe_setBatchMeans(m->attente);
+   probe_setInstabilityDetector(m->attente, instable, NULL);
+   fileSimple_construire(&mm1, dateGenerator_createExp(LAMBDA), 1.0 / MU, m->attente);
+   m->file = mm1.file;
+
+   m->histo = probe_createGraphBar(0.0, 20.0, NB_BARRES);
+   filePDU_addSejournProbe(m->file, m->histo);
+   m->service = probe_createMean();
+   srvGen_addServiceProbe(mm1.srv, m->service);
+
+   PDUSource_start(mm1.source);
+
+   if (sondeEnPlus) {
+      probe_createMean();
+   }
+}
+
+/*
+ * Un générateur seul, antithétique ou non
+ */
+struct randomGenerator_t * construireGenerateur(int antithetique)
+{
+   struct randomGenerator_t * rg;
+
+   motSim_setSeed(7);
+   motSim_setModelVersion("rg", 1);
+   rg = randomGenerator_createDoubleRange(0.0, 1.0);
+   randomGenerator_setAntithetic(rg, antithetique);
+
+   return rg;
+}
+
+double maintenant()
+{
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main()
+{
+   struct modele_t   reference, restaure, autre;
+   struct motsim_t * ctx;
+   struct stat       st;
+   struct randomGenerator_t * rg;
+   double            u;
+   motSimDate_t      date;
+   double            debut, chauffe, restauration;
+   int               result = 0;
+   int               n;
+
+   // La référence, sauvegardée après la chauffe
+   motSim_create();
+   ctx = motSim_getCurrentContext();
+   construire(&reference, 1, 0);
+   debut = maintenant();
+   motSim_runUntil(motSim_secondsToDate(CHAUFFE));
+   chauffe = maintenant() - debut;
+   if (motSim_checkpoint(FICHIER)) {
+      printf("[CHECK] ERREUR : sauvegarde\n");
+      return 1;
+   }
+   motSim_runUntil(motSim_secondsToDate(DUREE));
+
+   // Le même modèle restauré
+   motSim_create();
+   construire(&restaure, 1, 0);
+   debut = maintenant();
+   if (motSim_restore(FICHIER)) {
+      printf("[CHECK] ERREUR : restauration\n");
+      return 1;
+   }
+   restauration = maintenant() - debut;
+   motSim_runUntil(motSim_secondsToDate(DUREE));
+
+   printf("[CHECK] chauffe %.3f s, restauration %.3f s\n", chauffe, restauration);
+   printf("[CHECK] %lu attentes (moyenne %f), %lu restaurées (moyenne %f)\n",
+	  probe_nbSamples(reference.attente), probe_mean(reference.attente),
+	  probe_nbSamples(restaure.attente), probe_mean(restaure.attente));
+
+   if ((probe_nbSamples(reference.attente) != probe_nbSamples(restaure.attente))
+       || (probe_mean(reference.attente) != probe_mean(restaure.attente))
+       || (probe_exhaustiveGetSample(reference.attente, probe_nbSamples(reference.attente) - 1)
+	   != probe_exhaustiveGetSample(restaure.attente, probe_nbSamples(restaure.attente) - 1))
+       || (probe_mean(reference.service) != probe_mean(restaure.service))
+       || (probe_warmupTruncation(reference.attente) != probe_warmupTruncation(restaure.attente))
+       || (probe_batchMeansMean(reference.attente) != probe_batchMeansMean(restaure.attente))
+       || (probe_batchMeansHalfWidth(reference.attente) != probe_batchMeansHalfWidth(restaure.attente))
+       || (probe_instabilityDetected(restaure.attente))
+       || (filePDU_length(reference.file) != filePDU_length(restaure.file))) {
+      printf("[CHECK] ERREUR : résultats différents\n");
+      result = 1;
+   }
+   for (n = 0; n < NB_BARRES; n++) {
+      if (probe_graphBarGetValue(reference.histo, n) != probe_graphBarGetValue(restaure.histo, n)) {
+	 printf("[CHECK] ERREUR : histogrammes différents en %d\n", n);
+	 result = 1;
+      }
+   }
+   if (restauration >= chauffe) {
+      printf("[CHECK] ERREUR : restauration trop lente\n");
+      result = 1;
+   }
+
+   // Les modèles incompatibles
+   motSim_create();
+   construire(&autre, 2, 0);
+   if (!motSim_restore(FICHIER)) {
+      printf("[CHECK] ERREUR : version différente acceptée\n");
+      result = 1;
+   }
+   motSim_create();
+   construire(&autre, 1, 1);
+   if (!motSim_restore(FICHIER)) {
+      printf("[CHECK] ERREUR : client supplémentaire accepté\n");
+      result = 1;
+   }
+
+   // Une sauvegarde tronquée (ici au milieu des événements) ne modifie
+   // rien, la simulation se poursuit comme sans restauration
+   motSim_create();
+   construire(&autre, 1, 0);
+   motSim_runUntil(motSim_secondsToDate(CHAUFFE / 10.0));
+   n = probe_nbSamples(autre.attente);
+   date = motSim_getCurrentTime();
+   if ((stat(FICHIER, &st)) || (truncate(FICHIER, st.st_size - 20)) || (!motSim_restore(FICHIER))) {
+      printf("[CHECK] ERREUR : sauvegarde tronquée acceptée\n");
+      result = 1;
+   }
+   if ((motSim_getCurrentTime() != date)
+       || (probe_nbSamples(autre.attente) != n)) {
+      printf("[CHECK] ERREUR : état modifié par une sauvegarde tronquée\n");
+      result = 1;
+   }
+   motSim_runUntil(motSim_secondsToDate(CHAUFFE / 5.0));
+   if (probe_nbSamples(autre.attente) <= n) {
+      printf("[CHECK] ERREUR : simulation arrêtée par une sauvegarde tronquée\n");
+      result = 1;
+   }
+
+   // Le caractère antithétique d'un générateur est sauvegardé
+   motSim_create();
+   rg = construireGenerateur(1);
+   randomGenerator_getNextDouble(rg);
+   if (motSim_checkpoint(FICHIER_RG)) {
+      printf("[CHECK] ERREUR : sauvegarde du générateur\n");
+      result = 1;
+   }
+   u = randomGenerator_getNextDouble(rg);
+   motSim_create();
+   rg = construireGenerateur(0);
+   if ((motSim_restore(FICHIER_RG)) || (randomGenerator_getNextDouble(rg) != u)) {
+      printf("[CHECK] ERREUR : générateur antithétique mal restauré\n");
+      result = 1;
+   }
+
+   unlink(FICHIER);
+   unlink(FICHIER_RG);
+   motSim_setCurrentContext(ctx);
+
+   return result;
+}
@@ -0,0 +1,154 @@
+/*
+ *    Test des contextes de simulation
+ *
+ *    contexts : deux simulations indépendantes (une file M/M/1
+ *    construite à la main) doivent donner exactement le même résultat
+ *    qu'elles soient exécutées seules, entrelacées dans un même
+ *    thread, ou en parallèle dans deux threads.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>      // log
+#include <pthread.h>
+
+#include <motsim.h>
+#include <event.h>
+#include <pdu.h>
+#include <file_pdu.h>
+#include <probe.h>
+
+#define DUREE     10000.0
+#define NB_ETAPES 10
+
+struct modele_t {
+   unsigned short     xsubi[3];
+   struct filePDU_t * file;
+   struct probe_t   * sejour;
+   int                occupe;
+   long               nbServis;
+   int                dernierId;
+};
+
+void servir(void * data);
+
+void demarrerService(struct modele_t * m)
+{
+   m->occupe = 1;
+   event_add(servir, m, motSim_getCurrentTime() - log(erand48(m->xsubi)) / 1.1);
+}
+
+void arrivee(void * data)
+{
+   struct modele_t * m = (struct modele_t *)data;
+
+   filePDU_insert(m->file, PDU_create(1, NULL));
+   if (!m->occupe) {
+      demarrerService(m);
+   }
+   event_add(arrivee, m, motSim_getCurrentTime() - log(erand48(m->xsubi)));
+}
+
+void servir(void * data)
+{
+   struct modele_t * m = (struct modele_t *)data;
+   struct PDU_t * pdu = filePDU_extract(m->file);
+
+   probe_sample(m->sejour, motSim_getCurrentTime() - PDU_getCreationDate(pdu));
+   m->dernierId = PDU_id(pdu);
+   m->nbServis++;
+   PDU_free(pdu);
+
+   m->occupe = 0;
+   if (filePDU_length(m->file)) {
+      demarrerService(m);
+   }
+}
+
+/*
+ * Création d'un contexte (qui devient courant) et du modèle
+ */
+struct motsim_t * construire(struct modele_t * m, unsigned short graine)
+{
+   motSim_create();
+
+   m->xsubi[0] = graine;
+   m->xsubi[1] = 0x1234;
+   m->xsubi[2] = 0x330E;
+   m->file = filePDU_create(NULL, NULL);
+   m->sejour = probe_createMean();
+   m->occupe = 0;
+   m->nbServis = 0;
+   m->dernierId = -1;
+
+   event_add(arrivee, m, 0.0);
+
+   return motSim_getCurrentContext();
+}
+
+/*
+ * Une simulation complète dans un thread
+ */
+void * simuler(void * data)
+{
+   struct modele_t * m = (struct modele_t *)data;
+
+   construire(m, m->xsubi[0]);
+   motSim_runUntil(DUREE);
+
+   return NULL;
+}
+
+int comparer(char * cas, struct modele_t * m, struct modele_t * ref)
+{
+   if ((m->nbServis != ref->nbServis)
+       || (m->dernierId != ref->dernierId)
+       || (probe_mean(m->sejour) != probe_mean(ref->sejour))) {
+      printf("[CTX] ERREUR (%s) : %ld servis (%d), sejour %f au lieu de %ld (%d), %f\n",
+             cas, m->nbServis, m->dernierId, probe_mean(m->sejour),
+             ref->nbServis, ref->dernierId, probe_mean(ref->sejour));
+      return 1;
+   }
+   return 0;
+}
+
+int main()
+{
+   struct modele_t ref[2], m[2];
+   struct motsim_t * ctx[2];
+   pthread_t thread[2];
+   int result = 0;
+   int i, e;
+
+   // Les références, l'une après l'autre
+   for (i = 0; i < 2; i++) {
+      construire(&ref[i], i + 1);
+      motSim_runUntil(DUREE);
+   }
+   printf("[CTX] %ld et %ld clients servis\n", ref[0].nbServis, ref[1].nbServis);
+
+   // Entrelacées dans le même thread
+   for (i = 0; i < 2; i++) {
+      ctx[i] = construire(&m[i], i + 1);
+   }
+   for (e = 1; e <= NB_ETAPES; e++) {
+      for (i = 0; i < 2; i++) {
+         motSim_setCurrentContext(ctx[i]);
+         motSim_runUntil(DUREE * e / NB_ETAPES);
+      }
+   }
+   for (i = 0; i < 2; i++) {
+      result |= comparer("entrelacées", &m[i], &ref[i]);
+   }
+
+   // En parallèle
+   for (i = 0; i < 2; i++) {
+      m[i].xsubi[0] = i + 1;
+      pthread_create(&thread[i], NULL, simuler, &m[i]);
+   }
+   for (i = 0; i < 2; i++) {
+      pthread_join(thread[i], NULL);
+      result |= comparer("parallèles", &m[i], &ref[i]);
+   }
+
+   return result;
+}
@@ -0,0 +1,165 @@
+/*
+ *    Test des nombres aléatoires communs et des variables antithétiques
+ *
+ *    crn : deux configurations d'une file M/D/1 sont comparées, la
+ *    seconde sert les PDU plus lentement et crée un générateur de
+ *    plus avant celui des arrivées. Avec des flots nommés et la même
+ *    graine, les deux configurations voient les mêmes arrivées et la
+ *    différence de leurs temps de séjour varie beaucoup moins que
+ *    lorsqu'elles sont indépendantes. Des paires antithétiques donnent
+ *    de même une moyenne moins dispersée que des paires indépendantes.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <motsim.h>
+#include <campaign.h>
+#include <random-generator.h>
+
+#include "file-simple.h"
+
+#define NB_REPLICATIONS 40
+#define DUREE           2000.0
+#define LAMBDA          0.5
+#define NB_TIRAGES      1000
+
+/*
+ * Une configuration : le temps de service, l'utilisation de flots
+ * nommés et le générateur supplémentaire
+ */
+struct config_t {
+   double service;
+   int    nomme;
+   int    plus;
+   int    attente;
+};
+
+void construire(struct motSimCampaign_t * c, int n, void * data)
+{
+   struct config_t    * config = (struct config_t *)data;
+   struct fileSimple_t  mm1;
+   struct dateGenerator_t   * arrivees;
+   struct randomGenerator_t * rg;
+   struct probe_t     * attente;
+
+   if (config->plus) {
+      randomGenerator_createDoubleRange(0.0, 1.0);
+   }
+   rg = randomGenerator_createDoubleExp(LAMBDA);
+   if (config->nomme) {
+      randomGenerator_setStreamName(rg, "arrivees");
+   }
+   arrivees = dateGenerator_create();
+   dateGenerator_setRandomGenerator(arrivees, rg);
+
+   attente = probe_createMean();
+   fileSimple_construire(&mm1, arrivees, config->service, attente);
+   motSim_campaignSetProbe(c, n, config->attente, attente);
+}
+
+/*
+ * Les moyennes d'une campagne, une par réplication (ou par paire)
+ */
+struct probe_t * lancer(struct config_t * config, unsigned long long seed, int antithetic)
+{
+   struct motSimCampaign_t * c;
+   struct probe_t * moyennes = probe_createExhaustive();
+
+   c = motSim_campaignCreate(NB_REPLICATIONS, motSim_secondsToDate(DUREE), construire, config);
+   motSim_campaignSetNbThreads(c, 4);
+   motSim_campaignSetSeed(c, seed);
+   motSim_campaignSetAntithetic(c, antithetic);
+   config->attente = motSim_campaignAddProbe(c, moyennes, NULL);
+   motSim_campaignRun(c);
+
+   return moyennes;
+}
+
+/*
+ * Variance des différences entre les échantillons de deux sondes
+ */
+double varianceEcarts(struct probe_t * a, struct probe_t * b)
+{
+   double d, s = 0.0, s2 = 0.0;
+   int n, nb = probe_nbSamples(a);
+
+   for (n = 0; n < nb; n++) {
+      d = probe_exhaustiveGetSample(a, n) - probe_exhaustiveGetSample(b, n);
+      s += d;
+      s2 += d * d;
+   }
+   return (s2 - s * s / nb) / (nb - 1);
+}
+
+int main()
+{
+   struct config_t a = {1.0, 1, 0, 0}, b = {1.2, 1, 1, 0}, bRang = {1.2, 0, 1, 0};
+   struct config_t d = {1.0, 0, 0, 0};
+   struct probe_t * pa, * pb, * pbIndep, * pbRang, * anti, * indep, * paires;
+   struct randomGenerator_t * rg[3];
+   double vCommun, vIndep, vRang, vAnti, vPaires, u, v;
+   int result = 0;
+   int n;
+
+   motSim_create();
+
+   // Un flot nommé ne dépend pas du rang de création, et l'antithétique
+   // lui est symétrique
+   motSim_setSeed(7);
+   rg[0] = randomGenerator_createDoubleRange(0.0, 1.0);
+   randomGenerator_setStreamName(rg[0], "arrivees");
+   randomGenerator_createDoubleRange(0.0, 1.0);
+   rg[1] = randomGenerator_createDoubleRange(0.0, 1.0);
+   randomGenerator_setStreamName(rg[1], "arrivees");
+   rg[2] = randomGenerator_createDoubleRange(0.0, 1.0);
+   randomGenerator_setStreamName(rg[2], "arrivees");
+   randomGenerator_setAntithetic(rg[2], 1);
+   for (n = 0; n < NB_TIRAGES; n++) {
+      u = randomGenerator_getNextDouble(rg[0]);
+      v = randomGenerator_getNextDouble(rg[2]);
+      if ((randomGenerator_getNextDouble(rg[1]) != u) || (u + v != 1.0)) {
+         printf("[CRN] ERREUR : tirage %d, %f et %f\n", n, u, v);
+         result = 1;
+         break;
+      }
+   }
+
+   // Nombres aléatoires communs entre deux configurations
+   pa = lancer(&a, 42, 0);
+   pb = lancer(&b, 42, 0);
+   pbIndep = lancer(&b, 4242, 0);
+   pbRang = lancer(&bRang, 42, 0);
+   vCommun = varianceEcarts(pa, pb);
+   vIndep = varianceEcarts(pa, pbIndep);
+   vRang = varianceEcarts(pa, pbRang);
+   printf("[CRN] variance des écarts : %f (communs), %f (rangs), %f (indépendants)\n",
+          vCommun, vRang, vIndep);
+   if ((vCommun * 4.0 > vIndep) || (vCommun * 4.0 > vRang)) {
+      printf("[CRN] ERREUR : pas de réduction de variance\n");
+      result = 1;
+   }
+
+   // Variables antithétiques : chaque paire est comparée à la moyenne
+   // de deux réplications indépendantes
+   anti = lancer(&d, 42, 1);
+   indep = lancer(&d, 42, 0);
+   paires = probe_createExhaustive();
+   for (n = 0; n + 1 < NB_REPLICATIONS; n += 2) {
+      probe_sample(paires, (probe_exhaustiveGetSample(indep, n)
+                            + probe_exhaustiveGetSample(indep, n + 1)) / 2.0);
+   }
+   if (probe_nbSamples(anti) != NB_REPLICATIONS / 2) {
+      printf("[CRN] ERREUR : %lu paires\n", probe_nbSamples(anti));
+      result = 1;
+   }
+   vAnti = probe_variance(anti);
+   vPaires = probe_variance(paires);
+   printf("[CRN] variance par paire : %f (antithétiques), %f (indépendantes)\n",
+          vAnti, vPaires);
+   if (vAnti >= vPaires) {
+      printf("[CRN] ERREUR : pas de réduction de variance\n");
+      result = 1;
+   }
+
+   return result;
+}
@@ -0,0 +1,500 @@
+/*
+ *    Quelques tests sur les files d'événements
+ *
+ *    event-file : chaque implantation doit extraire les événements
+ *    par date croissante, et dans l'ordre d'insertion à date égale,
+ *    y compris lorsque certains ont été annulés ou déplacés, et qu'on
+ *    les extraie un à un ou par groupes de même date. La roue doit en
+ *    plus supporter des dates sur toutes les échelles. Les arguments
+ *    d'un événement doivent lui parvenir, et ses blocs être réutilisés
+ *    après motSim_reset.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>    // strcmp
+#include <math.h>      // pow
+
+#include <motsim.h>
+#include <event.h>
+#include <event-file.h>
+
+#define NB_EVENTS 20000
+#define NB_DATES  500     // Peu de dates différentes pour avoir des ex aequo
+
+static enum eventFileType_t types[] = {
+   eventFileSortedList,
+   eventFileBinaryHeap,
+   eventFile4aryHeap,
+   eventFilePairingHeap,
+   eventFileCalendarQueue,
+   eventFileTimingWheel
+};
+
+#define NB_TYPES (sizeof(types)/sizeof(types[0]))
+
+void rien(void * data)
+{
+}
+
+/*
+ * On mélange insertions et extractions, on vérifie l'ordre et on note
+ * la séquence obtenue pour la comparer entre implantations.
+ */
+int testerType(enum eventFileType_t type, long * sequence)
+{
+   struct eventFile_t * file = eventFile_createType(type);
+   struct event_t     * ev;
+   motSimDate_t         now = 0.0;
+   long                 lastId = -1, n = 0, i;
+   int                  result = 0;
+
+   srand48(1);
+
+   for (i = 0; i < NB_EVENTS; i++) {
+      ev = event_create(rien, (void *)i,
+                        now + (double)(lrand48() % NB_DATES));
+      eventFile_insert(file, ev);
+
+      // Une fois sur trois, on extrait
+      if (lrand48() % 3 == 0) {
+         ev = eventFile_extract(file);
+         if (event_getDate(ev) < now) {
+            printf("[EVFILE] ERREUR (%s) : date %f < %f\n",
+                   eventFile_getTypeName(file), motSim_dateToSeconds(event_getDate(ev)), motSim_dateToSeconds(now));
+            result = 1;
+         }
+         now = event_getDate(ev);
+         sequence[n++] = (long)ev->data;
+      }
+   }
+
+   if (eventFile_length(file) != NB_EVENTS - n) {
+      printf("[EVFILE] ERREUR (%s) : longueur %d\n",
+             eventFile_getTypeName(file), eventFile_length(file));
+      result = 1;
+   }
+
+   // On vide tout
+   while ((ev = eventFile_nextEvent(file)) != NULL) {
+      if (ev != eventFile_extract(file)) {
+         printf("[EVFILE] ERREUR (%s) : nextEvent incohérent\n",
+                eventFile_getTypeName(file));
+         result = 1;
+      }
+      if ((event_getDate(ev) == now) && ((long)ev->data < lastId)) {
+         printf("[EVFILE] ERREUR (%s) : ordre FIFO non respecté\n",
+                eventFile_getTypeName(file));
+         result = 1;
+      }
+      if (event_getDate(ev) < now) {
+         printf("[EVFILE] ERREUR (%s) : date %f < %f\n",
+                eventFile_getTypeName(file), motSim_dateToSeconds(event_getDate(ev)), motSim_dateToSeconds(now));
+         result = 1;
+      }
+      now = event_getDate(ev);
+      lastId = (long)ev->data;
+      sequence[n++] = lastId;
+   }
+
+   if ((n != NB_EVENTS) || (eventFile_length(file) != 0)
+       || (eventFile_extract(file) != NULL)) {
+      printf("[EVFILE] ERREUR (%s) : %ld événements extraits\n",
+             eventFile_getTypeName(file), n);
+      result = 1;
+   }
+
+   return result;
+}
+
+/*
+ * On annule un quart des événements et on en déplace un autre quart
+ * (plus tôt ou plus tard), au fil des insertions et des extractions
+ */
+int testerAnnulation(enum eventFileType_t type, long * sequence)
+{
+   struct eventFile_t * file = eventFile_createType(type);
+   static struct eventHandle_t handles[NB_EVENTS];
+   static motSimDate_t dates[NB_EVENTS];
+   static int annule[NB_EVENTS];
+   struct event_t     * ev;
+   motSimDate_t         now = 0.0;
+   long                 n = 0, nbAnnul = 0, i, j;
+   int                  result = 0;
+
+   srand48(2);
+
+   for (i = 0; i < NB_EVENTS; i++) {
+      dates[i] = now + (double)(lrand48() % NB_DATES);
+      annule[i] = 0;
+      ev = event_create(rien, (void *)i, dates[i]);
+      eventFile_insert(file, ev);
+      handles[i] = event_getHandle(ev);
+
+      // On agit sur un événement pris au hasard parmi les précédents
+      j = lrand48() % (i + 1);
+      switch (lrand48() % 4) {
+         case 0 :
+            if (event_cancel(handles[j])) {
+               annule[j] = 1;
+               nbAnnul++;
+            }
+         break;
+         case 1 :
+            dates[j] = now + (double)(lrand48() % NB_DATES);
+            event_reschedule(handles[j], dates[j]);
+         break;
+         case 2 :
+            ev = eventFile_extract(file);
+            if ((ev) && ((annule[(long)ev->data])
+                         || (event_getDate(ev) != dates[(long)ev->data])
+                         || (event_getDate(ev) < now))) {
+               printf("[EVFILE] ERREUR (%s) : extraction de %ld incorrecte\n",
+                      eventFile_getTypeName(file), (long)ev->data);
+               result = 1;
+            }
+            if (ev) {
+               now = event_getDate(ev);
+               sequence[n++] = (long)ev->data;
+            }
+         break;
+      }
+   }
+
+   if (eventFile_length(file) != NB_EVENTS - n - nbAnnul) {
+      printf("[EVFILE] ERREUR (%s) : longueur %d\n",
+             eventFile_getTypeName(file), eventFile_length(file));
+      result = 1;
+   }
+
+   while ((ev = eventFile_extract(file)) != NULL) {
+      if ((annule[(long)ev->data]) || (event_getDate(ev) < now)) {
+         printf("[EVFILE] ERREUR (%s) : extraction de %ld incorrecte\n",
+                eventFile_getTypeName(file), (long)ev->data);
+         result = 1;
+      }
+      now = event_getDate(ev);
+      sequence[n++] = (long)ev->data;
+   }
+
+   // Toutes les poignées sont maintenant caduques
+   for (i = 0; i < NB_EVENTS; i++) {
+      if (event_cancel(handles[i]) || event_reschedule(handles[i], now)) {
+         printf("[EVFILE] ERREUR (%s) : poignée %ld encore valide\n",
+                eventFile_getTypeName(file), i);
+         result = 1;
+         break;
+      }
+   }
+
+   if (n + nbAnnul != NB_EVENTS) {
+      printf("[EVFILE] ERREUR (%s) : %ld événements extraits, %ld annulés\n",
+             eventFile_getTypeName(file), n, nbAnnul);
+      result = 1;
+   }
+   // Pour la comparaison entre implantations
+   for (; n < NB_EVENTS; n++) {
+      sequence[n] = -1;
+   }
+
+   return result;
+}
+
+/*
+ * Extraction par groupes de même date, comparée à l'extraction un à
+ * un d'une file construite de la même façon (avec des annulations)
+ */
+struct eventFile_t * construire(enum eventFileType_t type, long seed)
+{
+   struct eventFile_t * file = eventFile_createType(type);
+   struct eventHandle_t handle;
+   struct event_t     * ev;
+   long                 i;
+
+   srand48(seed);
+   for (i = 0; i < NB_EVENTS; i++) {
+      ev = event_create(rien, (void *)i, (double)(lrand48() % NB_DATES));
+      eventFile_insert(file, ev);
+      handle = event_getHandle(ev);
+      if (lrand48() % 4 == 0) {
+         event_cancel(handle);
+      }
+   }
+   return file;
+}
+
+int testerGroupes(enum eventFileType_t type)
+{
+   struct eventFile_t * un = construire(type, 3);
+   struct eventFile_t * groupes = construire(type, 3);
+   struct event_t     * ev, * premier, * ref;
+   int                  result = 0;
+
+   while ((premier = eventFile_extractSameDate(groupes)) != NULL) {
+      for (ev = premier; ev != NULL; ev = ev->next) {
+         ref = eventFile_extract(un);
+         if ((ref == NULL) || (ev->data != ref->data)
+             || (event_getDate(ev) != event_getDate(premier))
+             || ((ev->next) && (ev->next->prev != ev))) {
+            printf("[EVFILE] ERREUR (%s) : groupe de %f incorrect\n",
+                   eventFile_getTypeName(groupes), motSim_dateToSeconds(event_getDate(premier)));
+            return 1;
+         }
+      }
+      // Le suivant doit être plus tardif
+      ev = eventFile_nextEvent(groupes);
+      if ((ev) && (event_getDate(ev) <= event_getDate(premier))) {
+         printf("[EVFILE] ERREUR (%s) : groupe de %f incomplet\n",
+                eventFile_getTypeName(groupes), motSim_dateToSeconds(event_getDate(premier)));
+         result = 1;
+      }
+   }
+   if ((eventFile_length(groupes) != 0) || (eventFile_extract(un) != NULL)) {
+      printf("[EVFILE] ERREUR (%s) : groupes incomplets\n",
+             eventFile_getTypeName(groupes));
+      result = 1;
+   }
+
+   return result;
+}
+
+/*
+ * La roue hiérarchique face à un tas, avec des écarts de dates de la
+ * picoseconde à l'année, des dates démesurées et quelques insertions
+ * dans le passé (qui l'obligent à se reconstruire)
+ */
+#define NB_ROUE 20000
+
+int testerRoue()
+{
+   struct eventFile_t * files[2];
+   struct event_t     * ev[2];
+   motSimDate_t         now = 0, date;
+   long                 i;
+   int                  f, result = 0;
+
+   files[0] = eventFile_createType(eventFile4aryHeap);
+   files[1] = eventFile_createType(eventFileTimingWheel);
+
+   srand48(3);
+   for (i = 0; i < NB_ROUE; i++) {
+      switch (lrand48() % 64) {
+         case 0 :
+            date = MOTSIM_DATE_MAX;
+         break;
+         case 1 :
+            date = now / 2;
+         break;
+         default :
+            date = now + motSim_secondsToDate(pow(10.0, -12.0 + 19.0 * drand48()));
+         break;
+      }
+      for (f = 0; f < 2; f++) {
+         eventFile_insert(files[f], event_create(rien, (void *)i, date));
+      }
+
+      if (lrand48() % 2 == 0) {
+         for (f = 0; f < 2; f++) {
+            ev[f] = eventFile_extract(files[f]);
+         }
+         if (ev[0]->data != ev[1]->data) {
+            printf("[EVFILE] ERREUR (roue) : %ld au lieu de %ld\n",
+                   (long)ev[1]->data, (long)ev[0]->data);
+            return 1;
+         }
+         now = event_getDate(ev[0]);
+         for (f = 0; f < 2; f++) {
+            event_free(ev[f]);
+         }
+      }
+   }
+
+   while ((ev[0] = eventFile_extract(files[0])) != NULL) {
+      ev[1] = eventFile_extract(files[1]);
+      if (ev[0]->data != ev[1]->data) {
+         printf("[EVFILE] ERREUR (roue) : %ld au lieu de %ld en fin\n",
+                (long)ev[1]->data, (long)ev[0]->data);
+         return 1;
+      }
+      event_free(ev[0]);
+      event_free(ev[1]);
+   }
+   if (eventFile_length(files[1]) != 0) {
+      result = 1;
+   }
+   printf("[EVFILE] roue : %lu reconstructions\n", eventFile_getNbResize(files[1]));
+
+   eventFile_free(files[0]);
+   eventFile_free(files[1]);
+
+   return result;
+}
+
+/*
+ * Dans le simulateur, un événement peut annuler ou déplacer un de ses
+ * ex aequo pas encore exécuté, ou en programmer un nouveau à la même
+ * date : l'ordre doit être celui d'une extraction un à un.
+ */
+char ordre[8];
+int  nbOrdre = 0;
+struct eventHandle_t hC, hD;
+
+void noter(void * data)
+{
+   ordre[nbOrdre++] = *(char *)data;
+}
+
+void evA(void * data)
+{
+   noter(data);
+   if (!event_cancel(hC)) {
+      ordre[nbOrdre++] = '!';
+   }
+}
+
+void evB(void * data)
+{
+   noter(data);
+   if (!event_isPending(hD) || !event_reschedule(hD, motSim_getCurrentTime())) {
+      ordre[nbOrdre++] = '!';
+   }
+   event_add(noter, "E", motSim_getCurrentTime());
+}
+
+/*
+ * Les temporisateurs (dont les événements périodiques) et les autres
+ * événements sont dans deux files, ils doivent pourtant être exécutés
+ * dans l'ordre d'insertion à date égale
+ */
+void noterPeriodique(void * data)
+{
+   noter(data);
+   if (nbOrdre == 6) {
+      event_cancel(event_getHandle(event_getCurrent()));
+   }
+}
+
+int testerTemporisateurs()
+{
+   nbOrdre = 0;
+   event_periodicAdd(noterPeriodique, "P", motSim_getCurrentTime() + 1.0, 1.0);
+   event_add(noter, "A", motSim_getCurrentTime() + 1.0);
+   event_timerAdd(noter, "T", motSim_getCurrentTime() + 1.0);
+   event_add(noter, "B", motSim_getCurrentTime() + 2.0);
+   motSim_runUntil(motSim_getCurrentTime() + 10.0);
+   ordre[nbOrdre] = 0;
+
+   if (strcmp(ordre, "PATBPP")) {
+      printf("[EVFILE] ERREUR : ordre d'exécution %s (temporisateurs)\n", ordre);
+      return 1;
+   }
+   return 0;
+}
+
+int testerSimulateur()
+{
+   event_add(noter, "0", 0.5);
+   event_add(evA, "A", 1.0);
+   event_add(evB, "B", 1.0);
+   hC = event_addWithHandle(noter, "C", 1.0);
+   hD = event_addWithHandle(noter, "D", 1.0);
+   event_add(noter, "F", 2.0);
+   motSim_runUntil(10.0);
+   ordre[nbOrdre] = 0;
+
+   if (strcmp(ordre, "0ABDEF")) {
+      printf("[EVFILE] ERREUR : ordre d'exécution %s\n", ordre);
+      return 1;
+   }
+   return 0;
+}
+
+/*
+ * Les arguments supplémentaires sont retrouvés par la fonction de
+ * l'événement. Après motSim_reset, les blocs sont repris depuis le
+ * début. Dans un contexte neuf : les tests précédents ne libèrent pas
+ * leurs événements.
+ */
+double somme = 0.0;
+
+void additionner(void * data)
+{
+   somme += *(double *)data + event_getArgDouble(1) * (long)event_getArg(0);
+}
+
+int testerArguments()
+{
+   struct event_t * premier, * event;
+   double un = 1.0;
+   int    i;
+
+   motSim_create();
+   for (i = 0; i < 1000; i++) {
+      event = event_create(additionner, &un, 1.0 + i);
+      event_setArg(event, 0, (void *)2L);
+      event_setArgDouble(event, 1, 0.25);
+      if (i == 0) {
+         premier = event;
+      }
+      motSim_addEvent(event);
+   }
+   motSim_runUntil(2000.0);
+
+   if (somme != 1500.0) {
+      printf("[EVFILE] ERREUR : somme des arguments %f\n", somme);
+      return 1;
+   }
+
+   motSim_reset();
+   event = event_create(additionner, &un, 1.0);
+   if (event != premier) {
+      printf("[EVFILE] ERREUR : blocs non réutilisés après motSim_reset\n");
+      return 1;
+   }
+   event_free(event);
+
+   return 0;
+}
+
+int main()
+{
+   long sequences[NB_TYPES][NB_EVENTS];
+   long annulations[NB_TYPES][NB_EVENTS];
+   struct motsim_t * ctx;
+   int  result = 0;
+   int  t, i;
+
+   motSim_create();
+   ctx = motSim_getCurrentContext();
+
+   for (t = 0; t < NB_TYPES; t++) {
+      result |= testerType(types[t], sequences[t]);
+      result |= testerAnnulation(types[t], annulations[t]);
+      result |= testerGroupes(types[t]);
+   }
+
+   // Toutes les implantations doivent donner la même séquence
+   for (t = 1; t < NB_TYPES; t++) {
+      for (i = 0; i < NB_EVENTS; i++) {
+         if (sequences[t][i] != sequences[0][i]) {
+            printf("[EVFILE] ERREUR : séquence %d différente en %d\n", t, i);
+            result = 1;
+            break;
+         }
+      }
+      for (i = 0; i < NB_EVENTS; i++) {
+         if (annulations[t][i] != annulations[0][i]) {
+            printf("[EVFILE] ERREUR : séquence %d différente en %d (annulations)\n", t, i);
+            result = 1;
+            break;
+         }
+      }
+   }
+
+   result |= testerRoue();
+   result |= testerSimulateur();
+   result |= testerTemporisateurs();
+   result |= testerArguments();
+   motSim_destroyContext(motSim_setCurrentContext(ctx));
+
+   return result;
+}
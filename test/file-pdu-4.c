@@ -0,0 +1,128 @@
+/*----------------------------------------------------------------------*/
+/*   Test de NDES : l'anneau des files de PDU.                          */
+/*----------------------------------------------------------------------*/
+/*
+ * Des PDU de tailles distinctes sont insérées et extraites en
+ * décalant l'anneau, de sorte qu'il fasse plusieurs fois le tour et
+ * qu'il soit agrandi alors qu'il est à cheval sur sa fin. L'ordre, les
+ * tailles et identifiants des n-ièmes PDU, les tailles cumulées, le
+ * nombre de PDU tenant dans un volume et le drop head doivent être
+ * respectés, et une fois l'anneau à sa taille maximale ni insertion ni
+ * extraction ne doivent plus allouer de mémoire. Les compteurs du
+ * moteur et une sonde système attachée en cours de route doivent
+ * suivre les PDU créées et libérées.
+ */
+#include <stdlib.h>    // Malloc, NULL, exit, ...
+#include <stdio.h>     // printf, ...
+
+#include <file_pdu.h>
+#include <probe.h>
+
+#define NB_TOURS 1000
+#define NBMAX      50
+
+int main() {
+   struct filePDU_t * filePDU;
+   struct PDU_t     * pdu;
+   struct probe_t   * crees;
+   struct motSimCounters_t compteurs;
+   unsigned long      memoire = 0;
+   int                premier = 0, dernier = 0; // Tailles attendues
+   int                n, tour, cumul, nb;
+   int                result = 0;
+
+   printf("[FILE-PDU-4] ... ");
+   fflush(stdout);
+
+   motSim_create();
+   crees = probe_createMean();
+   filePDU = filePDU_create(NULL, NULL);
+
+   // A chaque tour, on insère 3 PDU et on en extrait 2
+   for (tour = 0; tour < NB_TOURS; tour++) {
+      if (tour == NB_TOURS / 2) {
+         memoire = __totalMallocSize;
+         // On vide la file pour repartir d'un anneau déjà assez grand
+         while ((pdu = filePDU_extract(filePDU)) != NULL) {
+            PDU_free(pdu);
+            premier++;
+         }
+      }
+      for (n = 0; n < 3; n++) {
+         filePDU_insert(filePDU, PDU_create(++dernier, NULL));
+      }
+      for (n = 0; n < 2; n++) {
+         pdu = filePDU_extract(filePDU);
+         if (PDU_size(pdu) != ++premier) {
+            printf("ERROR : got PDU of size %d instead of %d\n", PDU_size(pdu), premier);
+            result = 1;
+         }
+         PDU_free(pdu);
+      }
+   }
+
+   if (__totalMallocSize != memoire) {
+      printf("ERROR : %lu bytes allocated instead of %lu\n", __totalMallocSize, memoire);
+      result = 1;
+   }
+
+   if ((filePDU_length(filePDU) != dernier - premier)
+       || (filePDU_size_PDU_n(filePDU, 1) != premier + 1)
+       || (filePDU_size_PDU_n(filePDU, filePDU_length(filePDU)) != dernier)
+       || (filePDU_size_n_PDU(filePDU, 2) != 2 * premier + 3)) {
+      printf("ERROR : %d PDUs, sizes %d to %d\n", filePDU_length(filePDU),
+             filePDU_size_PDU_n(filePDU, 1), filePDU_size_PDU_n(filePDU, filePDU_length(filePDU)));
+      result = 1;
+   }
+
+   // Les cumuls, comparés à un parcours de la file
+   cumul = 0;
+   for (n = 1; n <= filePDU_length(filePDU); n++) {
+      nb = filePDU_nb_PDU_in(filePDU, cumul + filePDU_size_PDU_n(filePDU, n) - 1);
+      cumul += filePDU_size_PDU_n(filePDU, n);
+      if ((filePDU_size_n_PDU(filePDU, n) != cumul) || (nb != n - 1)
+          || (filePDU_nb_PDU_in(filePDU, cumul) != n)) {
+         printf("ERROR : %d PDUs of cumulated size %d (%d), %d fit\n",
+                n, filePDU_size_n_PDU(filePDU, n), cumul, nb);
+         result = 1;
+         break;
+      }
+   }
+   if (filePDU_nb_PDU_in(filePDU, 2 * cumul) != filePDU_length(filePDU)) {
+      printf("ERROR : not all PDUs fit\n");
+      result = 1;
+   }
+
+   // Drop head, avec une sonde sur les créations : seules les NBMAX dernières restent
+   filePDU_reset(filePDU);
+   filePDU_setMaxLength(filePDU, NBMAX);
+   filePDU_setDropStrategy(filePDU, filePDU_dropHead);
+   PDU_setSystemProbes(crees, NULL, NULL, NULL);
+   for (n = 1; n <= 3 * NBMAX; n++) {
+      pdu = PDU_create(n, NULL);
+      filePDU_insert(filePDU, pdu);
+   }
+   if ((filePDU_length(filePDU) != NBMAX)
+       || (filePDU_size_PDU_n(filePDU, 1) != 2 * NBMAX + 1)
+       || (filePDU_id_PDU_n(filePDU, NBMAX) != PDU_id(pdu))) {
+      printf("ERROR : drop head left %d PDUs, first of size %d\n",
+             filePDU_length(filePDU), filePDU_size_PDU_n(filePDU, 1));
+      result = 1;
+   }
+
+   motSim_getCounters(NULL, &compteurs);
+   if ((compteurs.PDUCreated != dernier + 3 * NBMAX)
+       || (compteurs.PDUCreated - compteurs.PDUFreed != NBMAX)
+       || (compteurs.PDUReused + compteurs.PDUMalloced != compteurs.PDUCreated)
+       || (probe_nbSamples(crees) != 3 * NBMAX)) {
+      printf("ERROR : %lu PDUs created, %lu freed, %lu in probe\n",
+             compteurs.PDUCreated, compteurs.PDUFreed, probe_nbSamples(crees));
+      result = 1;
+   }
+
+   if (!result) {
+      printf("[OK]\n");
+   }
+
+   return result;
+}
@@ -0,0 +1,26 @@
+/*
+ *    Une file simple pour les tests du moteur (cf file-simple.h)
+ */
+#include <motsim.h>
+#include <pdu-sink.h>
+
+#include "file-simple.h"
+
+void fileSimple_construire(struct fileSimple_t * m,
+			   struct dateGenerator_t * arrivees,
+			   double service,
+			   struct probe_t * sejour)
+{
+   struct PDUSink_t * sink;
+
+   sink = PDUSink_create();
+   m->srv = srvGen_create(sink, PDUSink_processPDU);
+   srvGen_setServiceTime(m->srv, serviceTimeProp, service);
+   m->file = filePDU_create(m->srv, srvGen_processPDU);
+   m->source = PDUSource_create(arrivees, m->file, filePDU_processPDU);
+   PDUSource_setPDUSizeGenerator(m->source, randomGenerator_createUIntConstant(1));
+
+   if (sejour) {
+      filePDU_addSejournProbe(m->file, sejour);
+   }
+}
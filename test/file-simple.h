@@ -0,0 +1,35 @@
+/*
+ *    Une file simple pour les tests du moteur
+ *
+ *    Des PDU de taille 1, dont les arrivées sont données par un
+ *    générateur de dates, attendent dans une file puis sont servies
+ *    par un serveur à temps de service proportionnel à leur taille
+ *    avant d'être détruites par un puits. Avec des arrivées
+ *    exponentielles, c'est une file M/D/1.
+ */
+#ifndef __DEF_FILE_SIMPLE
+#define __DEF_FILE_SIMPLE
+
+#include <file_pdu.h>
+#include <pdu-source.h>
+#include <srv-gen.h>
+#include <date-generator.h>
+#include <probe.h>
+
+struct fileSimple_t {
+   struct srvGen_t    * srv;
+   struct filePDU_t   * file;
+   struct PDUSource_t * source;
+};
+
+/*
+ * Construction dans le contexte courant. La sonde sejour (si elle
+ * n'est pas NULL) reçoit le temps de séjour dans la file. La source
+ * n'est pas démarrée.
+ */
+void fileSimple_construire(struct fileSimple_t * m,
+			   struct dateGenerator_t * arrivees,
+			   double service,
+			   struct probe_t * sejour);
+
+#endif
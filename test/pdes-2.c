@@ -0,0 +1,185 @@
+/*
+ *    Test de la simulation parallèle optimiste
+ *
+ *    pdes-2 : un client (LP 0) envoie des requêtes à un serveur M/M/1
+ *    (LP 1) qui les lui renvoie une fois servies, sans aucun délai
+ *    entre les deux : aucune anticipation n'est possible. L'état des
+ *    deux entités est enregistré, les retours arrière doivent donc
+ *    donner exactement les mêmes résultats qu'une exécution
+ *    séquentielle.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>      // log
+
+#include <pdes.h>
+#include <event.h>
+#include <probe.h>
+
+#define DUREE      2000.0
+#define LAMBDA     10.0
+#define MU         12.0
+#define FILE_MAX   4096
+
+struct client_t {
+   unsigned short         xsubi[3];
+   struct pdesChannel_t * aller;
+   long                   nbEnvoyes;
+   long                   nbRecus;
+   double                 sejourTotal;
+   int                    tailleTotale;
+};
+
+struct serveur_t {
+   unsigned short         xsubi[3];
+   struct pdesChannel_t * retour;
+   struct PDU_t         * file[FILE_MAX];
+   int                    tete, nb;
+   long                   nbServis;
+};
+
+struct client_t  client;
+struct serveur_t serveur;
+
+/*
+ * Sans pdes, les PDU sont remises immédiatement
+ */
+struct PDU_t * aRemettre;
+
+struct PDU_t * remettre(void * foo)
+{
+   return aRemettre;
+}
+
+int serveur_processPDU(void * s, getPDU_t getPDU, void * source);
+int client_processPDU(void * c, getPDU_t getPDU, void * source);
+
+void envoyer(struct pdesChannel_t * canal, struct PDU_t * pdu,
+	     processPDU_t processPDU, void * destination)
+{
+   if (canal) {
+      pdes_channelSend(canal, pdu, motSim_getCurrentTime());
+   } else {
+      aRemettre = pdu;
+      processPDU(destination, remettre, NULL);
+   }
+}
+
+void arrivee(void * data)
+{
+   struct client_t * c = (struct client_t *)data;
+   struct PDU_t * pdu = PDU_create(1 + (int)(1000.0 * erand48(c->xsubi)), NULL);
+
+   c->nbEnvoyes++;
+   envoyer(c->aller, pdu, serveur_processPDU, &serveur);
+   event_add(arrivee, c, motSim_getCurrentTime() + motSim_secondsToDate(-log(erand48(c->xsubi)) / LAMBDA));
+}
+
+int client_processPDU(void * data, getPDU_t getPDU, void * source)
+{
+   struct client_t * c = (struct client_t *)data;
+   struct PDU_t * pdu = getPDU(source);
+
+   c->nbRecus++;
+   c->sejourTotal += motSim_dateToSeconds(motSim_getCurrentTime() - PDU_getCreationDate(pdu));
+   c->tailleTotale += PDU_size(pdu);
+   PDU_free(pdu);
+
+   return 1;
+}
+
+void finDeService(void * data)
+{
+   struct serveur_t * s = (struct serveur_t *)data;
+   struct PDU_t * pdu = s->file[s->tete];
+
+   s->tete = (s->tete + 1) % FILE_MAX;
+   s->nb--;
+   s->nbServis++;
+   if (s->nb) {
+      event_add(finDeService, s, motSim_getCurrentTime() + motSim_secondsToDate(-log(erand48(s->xsubi)) / MU));
+   }
+   envoyer(s->retour, pdu, client_processPDU, &client);
+}
+
+int serveur_processPDU(void * data, getPDU_t getPDU, void * source)
+{
+   struct serveur_t * s = (struct serveur_t *)data;
+
+   if (s->nb == FILE_MAX) {
+      return 0;
+   }
+   s->file[(s->tete + s->nb++) % FILE_MAX] = getPDU(source);
+   if (s->nb == 1) {
+      event_add(finDeService, s, motSim_getCurrentTime() + motSim_secondsToDate(-log(erand48(s->xsubi)) / MU));
+   }
+
+   return 1;
+}
+
+void construire(struct pdes_t * pdes)
+{
+   client.xsubi[0] = 1;
+   client.xsubi[1] = 0x1234;
+   client.xsubi[2] = 0x330E;
+   client.aller = NULL;
+   client.nbEnvoyes = 0;
+   client.nbRecus = 0;
+   client.sejourTotal = 0.0;
+   client.tailleTotale = 0;
+
+   serveur.xsubi[0] = 2;
+   serveur.xsubi[1] = 0x1234;
+   serveur.xsubi[2] = 0x330E;
+   serveur.retour = NULL;
+   serveur.tete = 0;
+   serveur.nb = 0;
+   serveur.nbServis = 0;
+
+   if (pdes) {
+      pdes_setCurrentLP(pdes, 1);
+      pdes_registerState(pdes, &serveur, sizeof(serveur));
+      serveur.retour = pdes_channelCreate(pdes, 0, &client, client_processPDU, 0.0);
+
+      pdes_setCurrentLP(pdes, 0);
+      pdes_registerState(pdes, &client, sizeof(client));
+      client.aller = pdes_channelCreate(pdes, 1, &serveur, serveur_processPDU, 0.0);
+   }
+   event_add(arrivee, &client, 0);
+}
+
+int main()
+{
+   struct pdes_t * pdes;
+   struct client_t ref;
+   int result = 0;
+
+   // La référence séquentielle
+   motSim_create();
+   construire(NULL);
+   motSim_runUntil(motSim_secondsToDate(DUREE));
+   ref = client;
+   printf("[PDES] %ld requetes, %ld reponses, sejour moyen %f\n",
+	  ref.nbEnvoyes, ref.nbRecus, ref.sejourTotal / ref.nbRecus);
+
+   // La même en parallèle optimiste
+   pdes = pdes_create(2);
+   pdes_setOptimistic(pdes, 64, motSim_secondsToDate(0.5));
+   construire(pdes);
+   pdes_runUntil(pdes, motSim_secondsToDate(DUREE));
+   pdes_printStatus(pdes);
+
+   if ((client.nbEnvoyes != ref.nbEnvoyes)
+       || (client.nbRecus != ref.nbRecus)
+       || (client.sejourTotal != ref.sejourTotal)
+       || (client.tailleTotale != ref.tailleTotale)) {
+      printf("[PDES] ERREUR : %ld requetes, %ld reponses, sejour moyen %f\n",
+	     client.nbEnvoyes, client.nbRecus, client.sejourTotal / client.nbRecus);
+      result = 1;
+   }
+   if (probe_nbSamples(pdes_getEfficiencyProbe(pdes, 0)) == 0) {
+      result = 1;
+   }
+
+   return result;
+}
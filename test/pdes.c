@@ -0,0 +1,116 @@
+/*
+ *    Test de la simulation parallèle conservatrice
+ *
+ *    pdes : des PDU font l'aller-retour entre deux LP sur des liens
+ *    (llSimplex_t). Le même modèle est d'abord simulé dans un seul
+ *    contexte puis découpé en deux LP : les sondes doivent donner
+ *    exactement les mêmes résultats.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <pdes.h>
+#include <file_pdu.h>
+#include <ll-simplex.h>
+#include <pdu-source.h>
+#include <pdu-sink.h>
+#include <date-generator.h>
+#include <probe.h>
+
+#define NB_CHAINES  4
+#define DUREE       500.0
+#define GRAINE      42
+#define LAMBDA      50.0
+#define DEBIT       1000000
+#define PROPAGATION 0.005
+
+struct mesures_t {
+   struct probe_t * aller[NB_CHAINES];
+   struct probe_t * retour[NB_CHAINES];
+};
+
+/*
+ * Une chaîne : source -> file -> lien -> (LP 1) file -> lien -> (LP
+ * 0) puits. Sans pdes, tout est dans le contexte courant.
+ */
+void construire(struct pdes_t * pdes, struct mesures_t * m)
+{
+   struct PDUSink_t   * sink;
+   struct llSimplex_t * lienAller, * lienRetour;
+   struct filePDU_t   * fileAller, * fileRetour;
+   struct PDUSource_t * source;
+   struct randomGenerator_t * taille;
+   int c;
+
+   for (c = 0; c < NB_CHAINES; c++) {
+      sink = PDUSink_create();
+
+      if (pdes) pdes_setCurrentLP(pdes, 1);
+      lienRetour = llSimplex_create(sink, PDUSink_processPDU, DEBIT, PROPAGATION);
+      if (pdes) llSimplex_setDestinationLP(lienRetour, pdes, 0);
+      fileRetour = filePDU_create(lienRetour, llSimplex_processPDU);
+      m->retour[c] = probe_createExhaustive();
+      filePDU_addSejournProbe(fileRetour, m->retour[c]);
+
+      if (pdes) pdes_setCurrentLP(pdes, 0);
+      lienAller = llSimplex_create(fileRetour, filePDU_processPDU, DEBIT, PROPAGATION * (c + 1));
+      if (pdes) llSimplex_setDestinationLP(lienAller, pdes, 1);
+      fileAller = filePDU_create(lienAller, llSimplex_processPDU);
+      m->aller[c] = probe_createExhaustive();
+      filePDU_addSejournProbe(fileAller, m->aller[c]);
+
+      source = PDUSource_create(dateGenerator_createExp(LAMBDA), fileAller, filePDU_processPDU);
+      taille = randomGenerator_createUIntRange(100, 1500);
+      randomGenerator_setDistributionUniform(taille);
+      PDUSource_setPDUSizeGenerator(source, taille);
+   }
+}
+
+int comparer(struct probe_t * p, struct probe_t * ref, char * nom, int c)
+{
+   if ((probe_nbSamples(p) != probe_nbSamples(ref))
+       || (probe_mean(p) != probe_mean(ref))
+       || (probe_max(p) != probe_max(ref))) {
+      printf("[PDES] ERREUR chaîne %d (%s) : %ld PDU, %f au lieu de %ld, %f\n",
+	     c, nom, probe_nbSamples(p), probe_mean(p),
+	     probe_nbSamples(ref), probe_mean(ref));
+      return 1;
+   }
+   return 0;
+}
+
+int main()
+{
+   struct mesures_t ref, m;
+   struct pdes_t * pdes;
+   int result = 0;
+   int c;
+
+   // La référence séquentielle
+   motSim_create();
+   motSim_setSeed(GRAINE);
+   construire(NULL, &ref);
+   motSim_reset();
+   motSim_runUntil(motSim_secondsToDate(DUREE));
+
+   // La même en parallèle, en deux étapes
+   pdes = pdes_create(2);
+   motSim_setSeed(GRAINE);
+   construire(pdes, &m);
+   pdes_reset(pdes);
+   pdes_runUntil(pdes, motSim_secondsToDate(DUREE / 2.0));
+   pdes_runUntil(pdes, motSim_secondsToDate(DUREE));
+   pdes_printStatus(pdes);
+
+   for (c = 0; c < NB_CHAINES; c++) {
+      printf("[PDES] chaîne %d : %ld PDU, aller %f s, retour %f s\n", c,
+	     probe_nbSamples(m.retour[c]), probe_mean(m.aller[c]), probe_mean(m.retour[c]));
+      result |= comparer(m.aller[c], ref.aller[c], "aller", c);
+      result |= comparer(m.retour[c], ref.retour[c], "retour", c);
+      if (probe_nbSamples(m.retour[c]) == 0) {
+	 result = 1;
+      }
+   }
+
+   return result;
+}
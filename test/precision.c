@@ -0,0 +1,83 @@
+/*
+ *    Test de la simulation jusqu'à une précision donnée
+ *
+ *    precision : le temps d'attente dans une file M/D/1 est estimé
+ *    avec une précision de PRECISION. La simulation doit s'arrêter
+ *    bien avant la date maximale, avec un intervalle qui contient la
+ *    valeur théorique. Une précision inaccessible doit mener jusqu'à
+ *    la date maximale.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include <motsim.h>
+
+#include "file-simple.h"
+
+#define LAMBDA     0.5
+#define MU         1.0     // Des PDU de taille 1 servies à débit MU
+#define PRECISION  0.02
+#define DATE_MAX   1000000.0
+
+struct probe_t * construire()
+{
+   struct fileSimple_t mm1;
+   struct probe_t    * attente;
+
+   motSim_create();
+   motSim_setSeed(42);
+
+   attente = probe_createExhaustive();
+   fileSimple_construire(&mm1, dateGenerator_createExp(LAMBDA), 1.0 / MU, attente);
+   PDUSource_start(mm1.source);
+
+   return attente;
+}
+
+int main()
+{
+   struct probe_t * attente;
+   double theorique = LAMBDA / (2.0 * MU * (MU - LAMBDA));
+   double moyenne, demiLargeur, date;
+   int    result = 0;
+
+   attente = construire();
+   if (motSim_runUntilPrecision(&attente, 1, PRECISION, motSim_secondsToDate(DATE_MAX))) {
+      printf("[PRECI] ERREUR : précision non atteinte\n");
+      return 1;
+   }
+   date = motSim_dateToSeconds(motSim_getCurrentTime());
+   moyenne = probe_batchMeansMean(attente);
+   demiLargeur = probe_batchMeansHalfWidth(attente);
+
+   printf("[PRECI] %.0f s, %lu attentes : %f +/- %f (théorique %f, iid +/- %f)\n",
+	  date, probe_nbSamples(attente), moyenne, demiLargeur, theorique,
+	  probe_demiIntervalleConfiance5pc(attente));
+
+   if ((demiLargeur < 0.0) || (demiLargeur > PRECISION * moyenne)) {
+      printf("[PRECI] ERREUR : demi-largeur %f\n", demiLargeur);
+      result = 1;
+   }
+   if (fabs(moyenne - theorique) > 2.0 * demiLargeur) {
+      printf("[PRECI] ERREUR : valeur théorique hors de l'intervalle\n");
+      result = 1;
+   }
+   if (date > DATE_MAX / 2.0) {
+      printf("[PRECI] ERREUR : simulation trop longue\n");
+      result = 1;
+   }
+
+   // Une précision inaccessible
+   attente = construire();
+   if (!motSim_runUntilPrecision(&attente, 1, 1e-6, motSim_secondsToDate(DATE_MAX / 100.0))) {
+      printf("[PRECI] ERREUR : précision de 1e-6 atteinte\n");
+      result = 1;
+   }
+   if (motSim_dateToSeconds(motSim_getCurrentTime()) < DATE_MAX / 100.0 - 100.0) {
+      printf("[PRECI] ERREUR : arrêt à %f\n", motSim_dateToSeconds(motSim_getCurrentTime()));
+      result = 1;
+   }
+
+   return result;
+}
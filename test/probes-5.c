@@ -0,0 +1,97 @@
+/*
+ * Quelques tests simples sur les sondes
+ *
+ * probes-5 : test des fenêtres de mesure et de la détection du régime
+ * transitoire
+ *
+ * Une valeur est échantillonnée chaque seconde : un bruit uniforme sur
+ * [0, 1[ auquel s'ajoute un régime transitoire qui décroît
+ * exponentiellement. Une sonde n'enregistre que sur une fenêtre, une
+ * autre qu'après la fin du régime transitoire détectée par une
+ * troisième.
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+
+#include <motsim.h>
+#include <event.h>
+#include <probe.h>
+
+#define DUREE     20000
+#define TRANSIT     200.0
+#define DEBUT      1000.0
+#define FIN        2000.0
+
+struct probe_t * detecteur, * apres, * fenetre;
+
+void echantillonner(void * data)
+{
+   double t = motSim_dateToSeconds(motSim_getCurrentTime());
+   double v = 10.0 * exp(-t / TRANSIT) + drand48();
+
+   probe_sample(detecteur, v);
+   probe_sample(apres, v);
+   probe_sample(fenetre, v);
+
+   if (t + 1.0 < DUREE) {
+      event_add(echantillonner, NULL, motSim_getCurrentTime() + motSim_secondsToDate(1.0));
+   }
+}
+
+int main()
+{
+   double date;
+   int result = 0;
+
+   printf("[PROBES-5] ... ");
+   fflush(stdout);
+
+   motSim_create();
+   srand48(42);
+
+   detecteur = probe_createExhaustive();
+   probe_setWarmupDetector(detecteur);
+   apres = probe_createMean();
+   probe_startAfterWarmup(apres, detecteur);
+   fenetre = probe_createExhaustive();
+   probe_setMeasureWindow(fenetre, DEBUT, FIN);
+
+   event_add(echantillonner, NULL, 0);
+   motSim_runUntil(motSim_secondsToDate(DUREE));
+
+   // La fenêtre
+   if ((probe_nbSamples(fenetre) != (unsigned long)(FIN - DEBUT))
+       || (probe_exhaustiveGetDateN(fenetre, 0) != DEBUT)) {
+      printf("ERROR : %lu samples in window\n", probe_nbSamples(fenetre));
+      result = 1;
+   }
+
+   // La détection
+   date = probe_warmupDate(detecteur);
+   if ((!probe_warmupDetected(detecteur)) || (date < TRANSIT) || (date > DUREE / 2)
+       || (probe_warmupTruncation(detecteur) > date)) {
+      printf("ERROR : warm-up detected at %f (%lu samples)\n",
+	     date, probe_warmupTruncation(detecteur));
+      result = 1;
+   }
+   if ((probe_nbSamples(detecteur) != DUREE)
+       || (probe_nbSamples(apres) != DUREE - (unsigned long)date)) {
+      printf("ERROR : %lu samples after warm-up\n", probe_nbSamples(apres));
+      result = 1;
+   }
+
+   // Le biais dû au régime transitoire est éliminé
+   if (fabs(probe_mean(apres) - 0.5) >= fabs(probe_mean(detecteur) - 0.5)) {
+      printf("ERROR : mean %f after warm-up, %f overall\n",
+	     probe_mean(apres), probe_mean(detecteur));
+      result = 1;
+   }
+
+   if (!result) {
+      printf("[OK] (warm-up %.0f s, mean %f instead of %f)\n",
+	     date, probe_mean(apres), probe_mean(detecteur));
+   }
+
+   return result;
+}
@@ -0,0 +1,107 @@
+/*
+ *    Test du profilage des événements
+ *
+ *    profiler : une source périodique alimente un puits, et un
+ *    événement en programme deux autres. Avec une bibliothèque
+ *    compilée avec MOTSIM_PROFILE, les nombres d'exécutions et
+ *    d'événements programmés doivent être exacts, par fonction comme
+ *    par objet. Sans MOTSIM_PROFILE, il n'y a rien à vérifier.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>    // strstr
+#include <unistd.h>    // unlink
+
+#include <motsim.h>
+#include <event.h>
+#include <profiler.h>
+#include <pdu-source.h>
+#include <pdu-sink.h>
+#include <date-generator.h>
+
+#define PERIODE  0.125
+#define DUREE    10.0
+#define NB_DEUX  5
+
+void rien(void * foo)
+{
+}
+
+void deux(void * foo)
+{
+   event_add(rien, NULL, motSim_getCurrentTime() + motSim_secondsToDate(0.01));
+   event_add(rien, NULL, motSim_getCurrentTime() + motSim_secondsToDate(0.02));
+}
+
+#ifdef MOTSIM_PROFILE
+int verifier(struct PDUSource_t * source)
+{
+   unsigned long nbSources;
+   char          line[256];
+   FILE        * csv;
+   int result = 0;
+   int n;
+
+   profiler_printReport(0);
+
+   nbSources = profiler_getObjectNbRuns(PDUSource_getObject(source));
+   printf("[PROFI] %lu PDU, %lu deux, %lu rien\n", nbSources,
+	  profiler_getNbRuns(deux), profiler_getNbRuns(rien));
+
+   // Une PDU par période, de 0 à DUREE comprises
+   if (nbSources != (unsigned long)(DUREE / PERIODE) + 1) {
+      result = 1;
+   }
+   if ((profiler_getNbRuns(deux) != NB_DEUX)
+       || (profiler_getNbScheduled(deux) != 2 * NB_DEUX)
+       || (profiler_getNbRuns(rien) != 2 * NB_DEUX)
+       || (profiler_getNbScheduled(rien) != 0)) {
+      result = 1;
+   }
+
+   // Les noms sont connus grâce à -rdynamic
+   if (profiler_writeCSV("profiler.csv")) {
+      return 1;
+   }
+   csv = fopen("profiler.csv", "r");
+   n = 0;
+   while (fgets(line, sizeof(line), csv)) {
+      n += (strstr(line, "handler,\"deux\",5,") == line);
+   }
+   fclose(csv);
+   unlink("profiler.csv");
+   if (n != 1) {
+      printf("[PROFI] ERREUR : fonction deux absente du CSV\n");
+      result = 1;
+   }
+
+   return result;
+}
+#endif
+
+int main()
+{
+   struct PDUSource_t * source;
+   struct PDUSink_t   * sink;
+   int n;
+
+   motSim_create();
+
+   sink = PDUSink_create();
+   source = PDUSource_create(dateGenerator_createPeriodic(PERIODE), sink, PDUSink_processPDU);
+   for (n = 0; n < NB_DEUX; n++) {
+      event_add(deux, NULL, motSim_secondsToDate(1.0 + n));
+   }
+
+   profiler_start();
+   PDUSource_start(source);
+   motSim_runUntil(motSim_secondsToDate(DUREE));
+   profiler_stop();
+
+#ifdef MOTSIM_PROFILE
+   return verifier(source);
+#else
+   printf("[PROFI] Bibliothèque compilée sans MOTSIM_PROFILE\n");
+   return 0;
+#endif
+}
@@ -0,0 +1,118 @@
+/*
+ *    Test de la région propre à une simulation
+ *
+ *    region : des objets de tailles variées sont pris dans la région,
+ *    ils doivent être alignés et ne pas se chevaucher. Revenir à une
+ *    position notée rend la mémoire allouée depuis, et une allocation
+ *    plus grande qu'un bloc est possible. Après chaque
+ *    réinitialisation, la région est reprise depuis le début : la
+ *    mémoire allouée ne doit plus croître après la première
+ *    simulation. Ce qu'un client prend dans la région lors de sa
+ *    réinitialisation doit lui rester.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include <motsim.h>
+#include <region.h>
+
+#define NB_OBJETS   10000
+#define GRAND       (200 * 1024)
+#define NB_SIMU        10
+#define MARQUE       0x5a
+
+/*
+ * Un client qui prend sa mémoire dans la région à chaque
+ * réinitialisation
+ */
+void client(void * data)
+{
+   char ** zone = (char **)data;
+
+   *zone = (char *)motSim_runMalloc(64);
+   memset(*zone, MARQUE, 64);
+}
+
+int main()
+{
+   char                 * objets[NB_OBJETS];
+   char                 * p, * q, * premier = NULL;
+   char                 * zone = NULL;
+   struct motSimRunMark_t mark;
+   unsigned long          memoire = 0;
+   int                    result = 0;
+   int                    n, s;
+
+   printf("[REGION] ... ");
+   fflush(stdout);
+
+   motSim_create();
+   motsim_addToResetList(&zone, client);
+
+   for (s = 0; (s < NB_SIMU) && (!result); s++) {
+      // Comme motSim_runNSimu
+      motSim_reset();
+
+      // Des objets alignés, chacun marqué de son rang
+      for (n = 0; n < NB_OBJETS; n++) {
+         objets[n] = (char *)motSim_runMalloc(1 + n % 100);
+         if (objets[n] == zone) {
+            printf("ERROR : run %d, reset client memory reused\n", s);
+            result = 1;
+         }
+         if ((uintptr_t)objets[n] % 16) {
+            printf("ERROR : run %d, object %d not aligned\n", s, n);
+            result = 1;
+         }
+         memset(objets[n], n & 0xff, 1 + n % 100);
+      }
+      for (n = 0; n < NB_OBJETS; n++) {
+         if ((objets[n][0] != (char)(n & 0xff)) || (objets[n][n % 100] != (char)(n & 0xff))) {
+            printf("ERROR : run %d, object %d overwritten\n", s, n);
+            result = 1;
+            break;
+         }
+      }
+
+      // Une zone temporaire, même plus grande qu'un bloc
+      mark = motSim_runMark();
+      p = (char *)motSim_runMalloc(64);
+      q = (char *)motSim_runMalloc(GRAND);
+      memset(q, 0, GRAND);
+      motSim_runRelease(mark);
+      if ((char *)motSim_runMalloc(64) != p) {
+         printf("ERROR : run %d, region not released\n", s);
+         result = 1;
+      }
+
+      if ((zone == NULL) || (zone[0] != MARQUE) || (zone[63] != MARQUE)) {
+         printf("ERROR : run %d, reset client memory overwritten\n", s);
+         result = 1;
+      }
+
+      // La région est reprise depuis le début
+      if (s == 0) {
+         premier = objets[0];
+      } else if (objets[0] != premier) {
+         printf("ERROR : run %d, region not reused\n", s);
+         result = 1;
+      }
+
+      motSim_runUntil(motSim_secondsToDate(1.0));
+      if (s == 0) {
+         memoire = __totalMallocSize;
+      } else if (__totalMallocSize != memoire) {
+         printf("ERROR : run %d, %lu bytes allocated instead of %lu\n", s,
+                __totalMallocSize, memoire);
+         result = 1;
+      }
+   }
+
+   if (!result) {
+      printf("[OK] (%d runs, %lu bytes)\n", NB_SIMU, memoire);
+   }
+
+   return result;
+}
@@ -0,0 +1,108 @@
+/*
+ *    Test de la réinitialisation entre deux simulations
+ *
+ *    reset : une file surchargée (les PDU arrivent deux fois plus vite
+ *    qu'elles ne sont servies) est simulée NB_SIMU fois de suite. Tout
+ *    est déterministe, chaque simulation doit donc donner exactement le
+ *    même résultat. La file et l'échéancier ne sont pas vides lors de
+ *    chaque réinitialisation, et la sonde exhaustive occupe plusieurs
+ *    blocs : la mémoire allouée ne doit plus croître après la première
+ *    simulation, pas même d'un en-tête ndesObject par PDU. Une poignée
+ *    sur un événement d'une simulation doit être caduque après la
+ *    réinitialisation. Une source relancée après la dernière
+ *    simulation doit continuer à émettre, et non repartir de sa date
+ *    de démarrage (ce qui l'arrêterait).
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <motsim.h>
+#include <event.h>
+
+#include "file-simple.h"
+
+#define DUREE      100000.0
+#define NB_SIMU        20
+
+void rien(void * data)
+{
+}
+
+int main()
+{
+   struct fileSimple_t  mm1;
+   struct filePDU_t   * file;
+   struct probe_t     * sejour;
+   struct probe_t     * emises;
+   struct PDUSource_t * source;
+   struct eventHandle_t handle;
+   unsigned long        nbSamples = 0, memoire = 0, avant;
+   double               moyenne = 0.0;
+   int                  longueur = 0;
+   int                  result = 0;
+   int                  n;
+
+   printf("[RESET] ... ");
+   fflush(stdout);
+
+   motSim_create();
+
+   sejour = probe_createExhaustive();
+   fileSimple_construire(&mm1, dateGenerator_createPeriodic(1.0), 2.0, sejour);
+   file = mm1.file;
+   // Démarrée par chaque réinitialisation
+   source = mm1.source;
+   emises = probe_createMean();
+   PDUSource_addPDUGenerationSizeProbe(source, emises);
+
+   for (n = 0; n < NB_SIMU; n++) {
+      motSim_runNSimu(motSim_secondsToDate(DUREE), 1);
+      handle = event_addWithHandle(rien, NULL, motSim_secondsToDate(2.0 * DUREE));
+
+      if (n == 0) {
+         nbSamples = probe_nbSamples(sejour);
+         moyenne = probe_mean(sejour);
+         longueur = filePDU_length(file);
+         memoire = __totalMallocSize;
+      } else if ((probe_nbSamples(sejour) != nbSamples)
+                 || (probe_mean(sejour) != moyenne)
+                 || (filePDU_length(file) != longueur)) {
+         printf("ERROR : run %d, %lu samples, mean %f, %d PDUs\n", n,
+                probe_nbSamples(sejour), probe_mean(sejour), filePDU_length(file));
+         result = 1;
+      } else if (__totalMallocSize != memoire) {
+         printf("ERROR : run %d, %lu bytes allocated instead of %lu\n", n,
+                __totalMallocSize, memoire);
+         result = 1;
+      }
+
+      if (n + 1 < NB_SIMU) {
+         motSim_reset();
+         if (event_isPending(handle)) {
+            printf("ERROR : run %d, handle still pending after reset\n", n);
+            result = 1;
+         }
+      }
+   }
+
+   // Relance en cours de simulation, sans retour dans le passé
+   avant = probe_nbSamples(emises);
+   PDUSource_start(source);
+   motSim_runUntil(motSim_secondsToDate(2.0 * DUREE));
+   if (probe_nbSamples(emises) < avant + DUREE / 2) {
+      printf("ERROR : %lu PDUs sent after restarting the source\n", probe_nbSamples(emises) - avant);
+      result = 1;
+   }
+
+   if ((nbSamples <= PROBE_NB_SAMPLES_MAX) || (longueur == 0)) {
+      printf("ERROR : %lu samples, %d PDUs left\n", nbSamples, longueur);
+      result = 1;
+   }
+
+   if (!result) {
+      printf("[OK] (%d runs, %lu samples, %d PDUs left, %lu bytes)\n",
+             NB_SIMU, nbSamples, longueur, memoire);
+   }
+
+   return result;
+}
@@ -0,0 +1,117 @@
+/*
+ *    Test du suivi des simulations
+ *
+ *    telemetry : deux simulations, l'une dans le thread principal,
+ *    l'autre dans un second thread, sont suivies par le thread de
+ *    telemetry_start. Le dernier échantillon, pris par telemetry_stop,
+ *    doit montrer les deux contextes avec leur nombre exact
+ *    d'événements et de PDU en attente.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>    // strstr
+#include <unistd.h>    // unlink
+#include <pthread.h>
+
+#include <motsim.h>
+#include <event.h>
+#include <pdu.h>
+#include <telemetry.h>
+
+#define PERIODE_SUIVI 0.01
+#define NB_TOPS       500000
+#define NB_GARDEES    10
+
+#define FICHIER "telemetry.json"
+
+struct modele_t {
+   long           nbTops;
+   struct PDU_t * gardees[NB_GARDEES];
+   struct motsim_t * ctx;
+};
+
+/*
+ * Chaque top crée une PDU et libère celle créée NB_GARDEES tops plus
+ * tôt : il en reste toujours NB_GARDEES en attente
+ */
+void top(void * data)
+{
+   struct modele_t * m = (struct modele_t *)data;
+   int i = m->nbTops % NB_GARDEES;
+
+   if (m->gardees[i]) {
+      PDU_free(m->gardees[i]);
+   }
+   m->gardees[i] = PDU_create(100, NULL);
+   m->nbTops++;
+   if (m->nbTops < NB_TOPS) {
+      event_add(top, m, motSim_getCurrentTime() + motSim_secondsToDate(0.001));
+   }
+}
+
+void * simuler(void * data)
+{
+   struct modele_t * m = (struct modele_t *)data;
+
+   motSim_create();
+   m->ctx = motSim_getCurrentContext();
+   event_add(top, m, 0);
+   motSim_runUntil(motSim_secondsToDate(NB_TOPS * 0.001));
+
+   return NULL;
+}
+
+int main()
+{
+   struct modele_t m1 = {0}, m2 = {0};
+   pthread_t       thread;
+   char            ligne[4096], derniere[4096] = "", attendu[128];
+   unsigned long   nbLignes = 0;
+   FILE          * f;
+   int             result = 0;
+
+   if (telemetry_start(PERIODE_SUIVI, 0, FICHIER)) {
+      printf("[TELEM] ERREUR : démarrage\n");
+      return 1;
+   }
+
+   pthread_create(&thread, NULL, simuler, &m2);
+   simuler(&m1);
+   pthread_join(thread, NULL);
+
+   telemetry_stop();
+   printf("[TELEM] %lu échantillons\n", telemetry_getNbSamples());
+
+   f = fopen(FICHIER, "r");
+   while ((f) && (fgets(ligne, sizeof(ligne), f))) {
+      strcpy(derniere, ligne);
+      nbLignes++;
+   }
+   if (f) {
+      fclose(f);
+   }
+   unlink(FICHIER);
+   printf("[TELEM] %s", derniere);
+
+   if ((nbLignes == 0) || (nbLignes != telemetry_getNbSamples())) {
+      result = 1;
+   }
+
+   // Les deux contextes ont publié leur état final
+   sprintf(attendu, "\"events\":%d,\"rate\"", NB_TOPS);
+   if ((!strstr(derniere, attendu))
+       || (!strstr(strstr(derniere, attendu) + 1, attendu))) {
+      printf("[TELEM] ERREUR : %s absent\n", attendu);
+      result = 1;
+   }
+   sprintf(attendu, "\"pending\":0,\"pduInUse\":%d,", NB_GARDEES);
+   if ((!strstr(derniere, attendu))
+       || (!strstr(strstr(derniere, attendu) + 1, attendu))) {
+      printf("[TELEM] ERREUR : %s absent\n", attendu);
+      result = 1;
+   }
+
+   motSim_destroyContext(m2.ctx);
+
+   return result;
+}
@@ -0,0 +1,92 @@
+/*
+ *    Test des conversions entre dates et secondes
+ *
+ *    ticks : écrit avec motSim_secondsToDate et motSim_dateToSeconds,
+ *    ce modèle doit fonctionner quelle que soit la représentation des
+ *    dates. Avec MOTSIM_TICK_DATE (bibliothèque comprise), les dates
+ *    cumulées par un générateur périodique ou un événement périodique
+ *    doivent être exactes.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>      // fabs
+
+#include <motsim.h>
+#include <event.h>
+#include <date-generator.h>
+#include <probe.h>
+
+#define PERIODE  0.001
+#define NB_DATES 1000000
+#define DUREE    10.0
+
+long nbTops = 0;
+struct probe_t * tops;
+
+void top(void * foo)
+{
+   nbTops++;
+   probe_sample(tops, 1.0);
+}
+
+int main()
+{
+   struct dateGenerator_t * dateGen;
+   motSimDate_t             periode, date = 0;
+   double                   ecart, tolerance;
+   long                     n;
+   int                      result = 0;
+
+   motSim_create();
+
+   periode = motSim_secondsToDate(PERIODE);
+   if (fabs(motSim_dateToSeconds(periode) - PERIODE) > 1e-15) {
+      printf("[TICKS] ERREUR : %g s au lieu de %g s\n",
+	     motSim_dateToSeconds(periode), PERIODE);
+      result = 1;
+   }
+
+   // Les dates d'un générateur périodique (la première est 0)
+   dateGen = dateGenerator_createPeriodic(PERIODE);
+   for (n = 1; n <= NB_DATES; n++) {
+      date = dateGenerator_nextDate(dateGen);
+   }
+   ecart = motSim_dateToSeconds(date - (NB_DATES - 1) * periode);
+   printf("[TICKS] %d dates, écart %g s\n", NB_DATES, ecart);
+#ifdef MOTSIM_TICK_DATE
+   if (date != (NB_DATES - 1) * periode) {
+      result = 1;
+   }
+#else
+   if (fabs(ecart) > 1e-6) {
+      result = 1;
+   }
+#endif
+
+   // Un événement périodique, les sondes voient des secondes
+   tops = probe_createExhaustive();
+   event_periodicAdd(top, NULL, 0, periode);
+   motSim_runUntil(motSim_secondsToDate(DUREE));
+   printf("[TICKS] %ld tops en %f s\n", nbTops,
+	  motSim_dateToSeconds(motSim_getCurrentTime()));
+   // Les dates réelles cumulées peuvent s'arrêter juste avant DUREE
+#ifdef MOTSIM_TICK_DATE
+   if (nbTops != (long)(DUREE / PERIODE) + 1) {
+      result = 1;
+   }
+   tolerance = 1e-6;
+#else
+   if (labs(nbTops - (long)(DUREE / PERIODE) - 1) > 1) {
+      result = 1;
+   }
+   tolerance = PERIODE * (1.0 + 1e-6);
+#endif
+   if ((fabs(probe_IAMean(tops) - PERIODE) > 1e-9)
+       || (fabs(probe_exhaustiveGetDateN(tops, nbTops - 1) - DUREE) > tolerance)) {
+      printf("[TICKS] ERREUR : sonde %f s, dernier top %f s\n",
+	     probe_IAMean(tops), probe_exhaustiveGetDateN(tops, nbTops - 1));
+      result = 1;
+   }
+
+   return result;
+}
@@ -0,0 +1,91 @@
+/*
+ *    Test de la détection d'instabilité
+ *
+ *    unstable : une file M/D/1 surchargée doit être arrêtée bien avant
+ *    la fin de la simulation, avec l'état MOTSIM_STATUS_UNSTABLE. Dans
+ *    une campagne mêlant charges stables et instables, seules les
+ *    réplications instables doivent être signalées, et leurs résultats
+ *    ignorés.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <motsim.h>
+#include <campaign.h>
+
+#include "file-simple.h"
+
+#define DUREE          200000.0
+#define NB_REPLICATIONS     8
+#define CHARGE_STABLE       0.9
+#define CHARGE_INSTABLE     1.25
+
+struct probe_t * construire(double charge)
+{
+   struct fileSimple_t mm1;
+   struct probe_t    * attente;
+
+   attente = probe_createMean();
+   fileSimple_construire(&mm1, dateGenerator_createExp(charge), 1.0, attente);
+   filePDU_addInstabilityDetector(mm1.file, NULL, NULL);
+
+   return attente;
+}
+
+/*
+ * Les réplications impaires sont instables
+ */
+void construireReplication(struct motSimCampaign_t * c, int n, void * data)
+{
+   int * mesure = (int *)data;
+
+   motSim_campaignSetProbe(c, n, *mesure,
+			   construire((n % 2) ? CHARGE_INSTABLE : CHARGE_STABLE));
+}
+
+int main()
+{
+   struct motSimCampaign_t * c;
+   struct probe_t * moyennes;
+   double date;
+   int    mesure;
+   int    result = 0;
+   int    n;
+
+   // Une seule simulation instable
+   motSim_create();
+   motSim_setSeed(42);
+   construire(CHARGE_INSTABLE);
+   motSim_reset();
+   motSim_runUntil(motSim_secondsToDate(DUREE));
+   date = motSim_dateToSeconds(motSim_getCurrentTime());
+   printf("[UNSTA] instable arrêtée à %.0f s\n", date);
+   if ((motSim_getStatus() != MOTSIM_STATUS_UNSTABLE) || (date > DUREE / 4.0)) {
+      printf("[UNSTA] ERREUR : état %d\n", motSim_getStatus());
+      result = 1;
+   }
+
+   // Une campagne
+   c = motSim_campaignCreate(NB_REPLICATIONS, motSim_secondsToDate(DUREE),
+			     construireReplication, &mesure);
+   motSim_campaignSetSeed(c, 42);
+   moyennes = probe_createExhaustive();
+   mesure = motSim_campaignAddProbe(c, moyennes, NULL);
+   motSim_campaignRun(c);
+   motSim_campaignPrintStatus(c);
+
+   for (n = 0; n < NB_REPLICATIONS; n++) {
+      if (motSim_campaignGetStatus(c, n) != ((n % 2) ? MOTSIM_STATUS_UNSTABLE : MOTSIM_STATUS_OK)) {
+	 printf("[UNSTA] ERREUR : réplication %d dans l'état %d\n", n, motSim_campaignGetStatus(c, n));
+	 result = 1;
+      }
+   }
+   if ((motSim_campaignNbUnstable(c) != NB_REPLICATIONS / 2)
+       || (probe_nbSamples(moyennes) != NB_REPLICATIONS / 2)) {
+      printf("[UNSTA] ERREUR : %d instables, %lu moyennes\n",
+	     motSim_campaignNbUnstable(c), probe_nbSamples(moyennes));
+      result = 1;
+   }
+
+   return result;
+}